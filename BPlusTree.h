@@ -0,0 +1,894 @@
+/*
+BPlusTree.h
+
+B+ Tree template class that implements an Ordered Map,
+with the same public interface as RedBlackTree.h
+
+Nodes are sized to span a small, fixed number of cache lines so that a
+lookup touches one node (a few adjacent lines) per level instead of one
+scattered node per level. Leaves are linked, so range scans walk the
+leaf level sequentially.
+
+Authour: Fitz Laddaran
+Contact: fitzladdaran@gmail.com
+Last Updated: 27/08/2020
+*/
+
+#pragma once
+#include <vector>
+#include <iostream>
+
+using std::cout;
+using std::endl;
+using std::vector;
+
+template <class T, class U>
+class BPlusTree {
+
+public:
+
+	BPlusTree(); // constructor
+	BPlusTree(const BPlusTree& bpTree); // copy constructor
+	BPlusTree& operator=(const BPlusTree& bpTree); // overloaded assignment operator
+	~BPlusTree(); // destructor
+
+	// inserts a key-value pair, if key is not present in B+ Tree
+	bool insert(const T keyP, const U valueP);
+
+	// removes a key-value pair, if key is present in B+ Tree
+	bool remove(const T keyP);
+
+	// search B+ Tree to see if key is present
+	bool search(const T keyP) const;
+
+	// returns all values whose keys are between keyP1 - keyP2
+	// based on ascending order of keys
+	vector<U> search(const T keyP1, const T keyP2) const;
+
+	// returns all values in the tree
+	// based on ascending order of keys
+	vector<U> values() const;
+
+	// returns all keys in the tree
+	vector<T> keys() const;
+
+	// returns number of items stored in the tree
+	int size() const;
+
+	// in-order print
+	void inOrderPrint() const;
+
+private:
+
+	// a node spans NODE_BYTES (4 cache lines); slot counts are derived from what else it
+	// holds: the header, padding of at most one alignment unit before each array or
+	// pointer that follows another, and the sibling links of a leaf or the extra child
+	// pointer of an internal node (nodes of very large keys or values keep 4 slots and
+	// span more lines)
+	static const int CACHE_LINE = 64;
+	static const int NODE_BYTES = 4 * CACHE_LINE;
+	static const int NODE_HEADER = (int)(2 * sizeof(int)) + (int)alignof(T);
+	static const int LEAF_OVERHEAD = NODE_HEADER + (int)alignof(U) + (int)(alignof(void*) + 2 * sizeof(void*));
+	static const int INTERNAL_OVERHEAD = NODE_HEADER + (int)(alignof(void*) + sizeof(void*));
+	static const int LEAF_SLOTS = ((NODE_BYTES - LEAF_OVERHEAD) / (int)(sizeof(T) + sizeof(U))) > 4 ?
+		((NODE_BYTES - LEAF_OVERHEAD) / (int)(sizeof(T) + sizeof(U))) : 4;
+	static const int INTERNAL_SLOTS = ((NODE_BYTES - INTERNAL_OVERHEAD) / (int)(sizeof(T) + sizeof(void*))) > 4 ?
+		((NODE_BYTES - INTERNAL_OVERHEAD) / (int)(sizeof(T) + sizeof(void*))) : 4;
+	static const int MAX_DEPTH = 64; // deeper than any tree that fits in memory
+
+	// common header of leaf and internal nodes
+	struct Node {
+		bool isLeaf; // checks the type of a node
+		int count; // number of keys stored in node
+	};
+
+	// leaf node: keys are kept apart from values so searching only touches key lines
+	struct alignas(64) Leaf : Node {
+		T keys[LEAF_SLOTS]; // sorted keys
+		U vals[LEAF_SLOTS]; // associated values
+		Leaf* next; // next leaf in ascending key order
+		Leaf* prev; // previous leaf in ascending key order
+	};
+
+	// internal node: children[i] holds keys < keys[i] <= children[i + 1]
+	struct alignas(64) Internal : Node {
+		T keys[INTERNAL_SLOTS]; // separator keys
+		Node* children[INTERNAL_SLOTS + 1]; // child pointers
+	};
+
+	static_assert(LEAF_SLOTS == 4 || sizeof(Leaf) <= NODE_BYTES, "a leaf spans more than NODE_BYTES");
+	static_assert(INTERNAL_SLOTS == 4 || sizeof(Internal) <= NODE_BYTES, "an internal node spans more than NODE_BYTES");
+
+	// attributes
+	Node* root; // pointer to tree's root
+	Leaf* head; // pointer to left-most leaf
+	int currSize; // size of tree
+
+	// helper functions
+	Leaf* newLeaf(); // allocates an empty leaf
+	Internal* newInternal(); // allocates an empty internal node
+	Node* copy(const Node* nd, Leaf*& prevLeaf); // deep copy every node in the tree
+	void clear(); // deallocates memory and sets root to NULL
+	void clear(Node* nd); // deallocates dynamic memory
+	int leafPosition(const Leaf* lf, const T& keyP) const; // first slot in leaf whose key is >= keyP
+	int childPosition(const Internal* in, const T& keyP) const; // child slot to descend for keyP
+	Leaf* findLeaf(const T& keyP) const; // descends to the leaf that would hold keyP
+	void insertInParent(Internal** path, int* pathPos, int depth, T sepKey, Node* rightNode); // pushes a split up the tree
+	void fixLeaf(Internal* parent, int pos, Leaf* lf); // rebalances an under-full leaf
+	void fixInternal(Internal* parent, int pos, Internal* in); // rebalances an under-full internal node
+
+};
+
+// constructor
+template <class T, class U>
+BPlusTree<T, U>::BPlusTree() {
+
+	root = nullptr;
+	head = nullptr;
+	currSize = 0;
+
+}
+
+// copy constructor
+template <class T, class U>
+BPlusTree<T, U>::BPlusTree(const BPlusTree& bpTree) {
+
+	Leaf* prevLeaf = nullptr;
+	head = nullptr;
+	root = copy(bpTree.root, prevLeaf);
+	currSize = bpTree.currSize;
+
+}
+
+// overloaded assignment operator
+template <class T, class U>
+BPlusTree<T, U>& BPlusTree<T, U>::operator=(const BPlusTree& bpTree) {
+
+	// if it is not self-assignment
+	if (this != &bpTree) {
+
+		// deallocate memory associated with tree nodes
+		this->clear();
+
+		// deep copy
+		Leaf* prevLeaf = nullptr;
+		root = copy(bpTree.root, prevLeaf);
+		currSize = bpTree.currSize;
+
+	}
+
+	// return reference to calling object
+	return *this;
+
+}
+
+// destructor
+template <class T, class U>
+BPlusTree<T, U>::~BPlusTree() {
+
+	clear();
+
+}
+
+// inserts key-value pair if key is not in B+ Tree and return true
+// otherwise return false without insertion
+template <class T, class U>
+bool BPlusTree<T, U>::insert(const T keyP, const U valueP) {
+
+	// if tree is empty, the root is a single leaf
+	if (root == nullptr) {
+
+		Leaf* lf = newLeaf();
+		lf->keys[0] = keyP;
+		lf->vals[0] = valueP;
+		lf->count = 1;
+		root = lf;
+		head = lf;
+		currSize = 1;
+		return true;
+
+	}
+
+	Internal* path[MAX_DEPTH]; // internal nodes visited on the way down
+	int pathPos[MAX_DEPTH]; // child slot taken at each internal node
+	int depth = 0;
+	Node* current = root; // iterator
+
+	// descend to the leaf, remembering the path for splits
+	while (!current->isLeaf) {
+
+		Internal* in = static_cast<Internal*>(current);
+		int pos = childPosition(in, keyP);
+		path[depth] = in;
+		pathPos[depth] = pos;
+		depth++;
+		current = in->children[pos];
+
+	}
+
+	Leaf* lf = static_cast<Leaf*>(current);
+	int pos = leafPosition(lf, keyP);
+
+	// if keyP is found, then return false without insertion
+	if (pos < lf->count && lf->keys[pos] == keyP) {
+		return false;
+	}
+
+	// if leaf has room, shift larger keys right and insert in place
+	if (lf->count < LEAF_SLOTS) {
+
+		for (int i = lf->count; i > pos; --i) {
+			lf->keys[i] = lf->keys[i - 1];
+			lf->vals[i] = lf->vals[i - 1];
+		}
+
+		lf->keys[pos] = keyP;
+		lf->vals[pos] = valueP;
+		lf->count++;
+		currSize++;
+		return true;
+
+	}
+
+	// if leaf is full, split it in half and insert into the proper half
+	Leaf* rightLeaf = newLeaf();
+	int half = (LEAF_SLOTS + 1) / 2; // number of keys left in the original leaf
+
+	// keys from slot (half - 1) onwards move right when keyP lands in the left half
+	int splitFrom = (pos < half) ? half - 1 : half;
+
+	for (int i = splitFrom; i < LEAF_SLOTS; ++i) {
+		rightLeaf->keys[i - splitFrom] = lf->keys[i];
+		rightLeaf->vals[i - splitFrom] = lf->vals[i];
+	}
+
+	rightLeaf->count = LEAF_SLOTS - splitFrom;
+	lf->count = splitFrom;
+
+	// insert into the half that now covers keyP
+	Leaf* target = (pos < half) ? lf : rightLeaf;
+	int targetPos = (pos < half) ? pos : pos - splitFrom;
+
+	for (int i = target->count; i > targetPos; --i) {
+		target->keys[i] = target->keys[i - 1];
+		target->vals[i] = target->vals[i - 1];
+	}
+
+	target->keys[targetPos] = keyP;
+	target->vals[targetPos] = valueP;
+	target->count++;
+
+	// link new leaf after the original one
+	rightLeaf->next = lf->next;
+	rightLeaf->prev = lf;
+
+	if (lf->next != nullptr) {
+		lf->next->prev = rightLeaf;
+	}
+
+	lf->next = rightLeaf;
+
+	insertInParent(path, pathPos, depth, rightLeaf->keys[0], rightLeaf);
+	currSize++;
+	return true;
+
+}
+
+// removes key-value pair if key is in B+ Tree and return true
+// otherwise return false without removal
+template <class T, class U>
+bool BPlusTree<T, U>::remove(const T keyP) {
+
+	// if tree is empty
+	if (root == nullptr) {
+		return false;
+	}
+
+	Internal* path[MAX_DEPTH]; // internal nodes visited on the way down
+	int pathPos[MAX_DEPTH]; // child slot taken at each internal node
+	int depth = 0;
+	Node* current = root; // iterator
+
+	// descend to the leaf, remembering the path for rebalancing
+	while (!current->isLeaf) {
+
+		Internal* in = static_cast<Internal*>(current);
+		int pos = childPosition(in, keyP);
+		path[depth] = in;
+		pathPos[depth] = pos;
+		depth++;
+		current = in->children[pos];
+
+	}
+
+	Leaf* lf = static_cast<Leaf*>(current);
+	int pos = leafPosition(lf, keyP);
+
+	// if keyP is not found, then return false without removal
+	if (pos == lf->count || !(lf->keys[pos] == keyP)) {
+		return false;
+	}
+
+	// close the gap left by keyP
+	for (int i = pos; i < lf->count - 1; ++i) {
+		lf->keys[i] = lf->keys[i + 1];
+		lf->vals[i] = lf->vals[i + 1];
+	}
+
+	lf->count--;
+	currSize--;
+
+	// the root leaf may shrink freely; it is removed once empty
+	if (depth == 0) {
+
+		if (lf->count == 0) {
+			delete lf;
+			root = nullptr;
+			head = nullptr;
+		}
+
+		return true;
+
+	}
+
+	// rebalance bottom-up while nodes are less than half full
+	if (lf->count < LEAF_SLOTS / 2) {
+
+		fixLeaf(path[depth - 1], pathPos[depth - 1], lf);
+
+		for (int level = depth - 1; level > 0; --level) {
+
+			if (path[level]->count >= INTERNAL_SLOTS / 2) {
+				break;
+			}
+
+			fixInternal(path[level - 1], pathPos[level - 1], path[level]);
+
+		}
+	}
+
+	// an internal root left without keys is replaced by its only child
+	if (!root->isLeaf && root->count == 0) {
+
+		Internal* oldRoot = static_cast<Internal*>(root);
+		root = oldRoot->children[0];
+		delete oldRoot;
+
+	}
+
+	return true;
+
+}
+
+// search B+ Tree to see if key matches any stored key
+// return true if found, otherwise false
+template <class T, class U>
+bool BPlusTree<T, U>::search(const T keyP) const {
+
+	// if tree is empty
+	if (root == nullptr) {
+		return false;
+	}
+
+	Leaf* lf = findLeaf(keyP);
+	int pos = leafPosition(lf, keyP);
+	return pos < lf->count && lf->keys[pos] == keyP;
+
+}
+
+// returns a vector containing all values whose keys are between
+// keyP1 - keyP2, based on ascending key order
+template <class T, class U>
+vector<U> BPlusTree<T, U>::search(const T keyP1, const T keyP2) const {
+
+	vector<U> myVect;
+
+	// if tree is empty
+	if (root == nullptr) {
+		return myVect;
+	}
+
+	// bounds may be given in either order
+	const T& low = (keyP2 < keyP1) ? keyP2 : keyP1;
+	const T& high = (keyP2 < keyP1) ? keyP1 : keyP2;
+
+	Leaf* lf = findLeaf(low);
+	int pos = leafPosition(lf, low);
+
+	// walk linked leaves until a key passes the upper bound
+	while (lf != nullptr) {
+
+		for (int i = pos; i < lf->count; ++i) {
+
+			if (high < lf->keys[i]) {
+				return myVect;
+			}
+
+			myVect.push_back(lf->vals[i]);
+
+		}
+
+		lf = lf->next;
+		pos = 0;
+
+	}
+
+	return myVect;
+
+}
+
+// returns a vector containing all values in ascending key order
+// if tree is empty, vector is also empty
+template <class T, class U>
+vector<U> BPlusTree<T, U>::values() const {
+
+	vector<U> myVect;
+	myVect.reserve(currSize);
+
+	for (Leaf* lf = head; lf != nullptr; lf = lf->next) {
+		myVect.insert(myVect.end(), lf->vals, lf->vals + lf->count);
+	}
+
+	return myVect;
+
+}
+
+// returns a vector containing all keys in ascending order
+// if tree is empty, vector is also empty
+template <class T, class U>
+vector<T> BPlusTree<T, U>::keys() const {
+
+	vector<T> myVect;
+	myVect.reserve(currSize);
+
+	for (Leaf* lf = head; lf != nullptr; lf = lf->next) {
+		myVect.insert(myVect.end(), lf->keys, lf->keys + lf->count);
+	}
+
+	return myVect;
+
+}
+
+// returns the number of items stored in the tree
+template <class T, class U>
+int BPlusTree<T, U>::size() const {
+
+	return currSize;
+
+}
+
+// prints every key-value pair in ascending key order
+template <class T, class U>
+void BPlusTree<T, U>::inOrderPrint() const {
+
+	for (Leaf* lf = head; lf != nullptr; lf = lf->next) {
+
+		for (int i = 0; i < lf->count; ++i) {
+			cout << "Key: " << lf->keys[i] << endl;
+			cout << "Value: " << lf->vals[i] << endl;
+			cout << endl;
+		}
+
+	}
+
+}
+
+// HELPER FUNCTION: allocates an empty leaf
+// USED BY: insert(), copy()
+template <class T, class U>
+typename BPlusTree<T, U>::Leaf* BPlusTree<T, U>::newLeaf() {
+
+	Leaf* lf = new Leaf();
+	lf->isLeaf = true;
+	lf->count = 0;
+	lf->next = nullptr;
+	lf->prev = nullptr;
+	return lf;
+
+}
+
+// HELPER FUNCTION: allocates an empty internal node
+// USED BY: insertInParent(), copy()
+template <class T, class U>
+typename BPlusTree<T, U>::Internal* BPlusTree<T, U>::newInternal() {
+
+	Internal* in = new Internal();
+	in->isLeaf = false;
+	in->count = 0;
+	return in;
+
+}
+
+// HELPER FUNCTION: copies every node in tree (pre-order traversal),
+// relinking leaves in the order they are visited
+// USED BY: copy constructor, overloaded assignment operator
+template <class T, class U>
+typename BPlusTree<T, U>::Node* BPlusTree<T, U>::copy(const Node* nd, Leaf*& prevLeaf) {
+
+	// if node is NULL
+	if (nd == nullptr) {
+		return nullptr;
+	}
+
+	// if node is a leaf, copy its slots and append it to the leaf chain
+	if (nd->isLeaf) {
+
+		const Leaf* lf = static_cast<const Leaf*>(nd);
+		Leaf* newLf = newLeaf();
+		newLf->count = lf->count;
+
+		for (int i = 0; i < lf->count; ++i) {
+			newLf->keys[i] = lf->keys[i];
+			newLf->vals[i] = lf->vals[i];
+		}
+
+		newLf->prev = prevLeaf;
+
+		if (prevLeaf != nullptr) {
+			prevLeaf->next = newLf;
+		}
+
+		else {
+			head = newLf;
+		}
+
+		prevLeaf = newLf;
+		return newLf;
+
+	}
+
+	// if node is internal, copy separators and recursively copy children left to right
+	const Internal* in = static_cast<const Internal*>(nd);
+	Internal* newIn = newInternal();
+	newIn->count = in->count;
+
+	for (int i = 0; i < in->count; ++i) {
+		newIn->keys[i] = in->keys[i];
+	}
+
+	for (int i = 0; i <= in->count; ++i) {
+		newIn->children[i] = copy(in->children[i], prevLeaf);
+	}
+
+	return newIn;
+
+}
+
+// HELPER FUNCTION: calls clear(Node* nd), and sets root = NULL
+// USED BY: destructor, overloaded assignment operator
+template <class T, class U>
+void BPlusTree<T, U>::clear() {
+
+	clear(root);
+	root = nullptr;
+	head = nullptr;
+	currSize = 0;
+
+}
+
+// HELPER FUNCTION: removes all nodes and deallocates dynamic memory for every node
+// USED BY: clear()
+template <class T, class U>
+void BPlusTree<T, U>::clear(Node* nd) {
+
+	// if node is NULL
+	if (nd == nullptr) {
+		return;
+	}
+
+	if (nd->isLeaf) {
+		delete static_cast<Leaf*>(nd);
+	}
+
+	else {
+
+		Internal* in = static_cast<Internal*>(nd);
+
+		for (int i = 0; i <= in->count; ++i) {
+			clear(in->children[i]); // recursively clear every child
+		}
+
+		delete in;
+
+	}
+
+}
+
+// HELPER FUNCTION: binary search for the first slot whose key is >= keyP
+// USED BY: insert(), remove(), search()
+template <class T, class U>
+int BPlusTree<T, U>::leafPosition(const Leaf* lf, const T& keyP) const {
+
+	int low = 0;
+	int high = lf->count;
+
+	while (low < high) {
+
+		int mid = (low + high) / 2;
+
+		if (lf->keys[mid] < keyP) {
+			low = mid + 1;
+		}
+
+		else {
+			high = mid;
+		}
+
+	}
+
+	return low;
+
+}
+
+// HELPER FUNCTION: binary search for the number of separators <= keyP,
+// which is the child slot that covers keyP
+// USED BY: insert(), remove(), findLeaf()
+template <class T, class U>
+int BPlusTree<T, U>::childPosition(const Internal* in, const T& keyP) const {
+
+	int low = 0;
+	int high = in->count;
+
+	while (low < high) {
+
+		int mid = (low + high) / 2;
+
+		if (keyP < in->keys[mid]) {
+			high = mid;
+		}
+
+		else {
+			low = mid + 1;
+		}
+
+	}
+
+	return low;
+
+}
+
+// HELPER FUNCTION: descends from the root to the leaf that would hold keyP
+// USED BY: search()
+template <class T, class U>
+typename BPlusTree<T, U>::Leaf* BPlusTree<T, U>::findLeaf(const T& keyP) const {
+
+	Node* current = root; // iterator
+
+	while (!current->isLeaf) {
+		Internal* in = static_cast<Internal*>(current);
+		current = in->children[childPosition(in, keyP)];
+	}
+
+	return static_cast<Leaf*>(current);
+
+}
+
+// HELPER FUNCTION: inserts separator sepKey and rightNode after the child taken at
+// path[depth - 1], splitting full internal nodes up to (and including) the root
+// USED BY: insert()
+template <class T, class U>
+void BPlusTree<T, U>::insertInParent(Internal** path, int* pathPos, int depth, T sepKey, Node* rightNode) {
+
+	while (depth > 0) {
+
+		Internal* parent = path[depth - 1];
+		int pos = pathPos[depth - 1]; // rightNode goes into child slot pos + 1
+
+		// if parent has room, shift separators and children right
+		if (parent->count < INTERNAL_SLOTS) {
+
+			for (int i = parent->count; i > pos; --i) {
+				parent->keys[i] = parent->keys[i - 1];
+				parent->children[i + 1] = parent->children[i];
+			}
+
+			parent->keys[pos] = sepKey;
+			parent->children[pos + 1] = rightNode;
+			parent->count++;
+			return;
+
+		}
+
+		// if parent is full, build the overfull key/child sequence and split it around its middle
+		T tmpKeys[INTERNAL_SLOTS + 1];
+		Node* tmpChildren[INTERNAL_SLOTS + 2];
+
+		for (int i = 0, j = 0; i <= INTERNAL_SLOTS; ++i) {
+			tmpKeys[i] = (i == pos) ? sepKey : parent->keys[j++];
+		}
+
+		for (int i = 0, j = 0; i <= INTERNAL_SLOTS + 1; ++i) {
+			tmpChildren[i] = (i == pos + 1) ? rightNode : parent->children[j++];
+		}
+
+		int mid = (INTERNAL_SLOTS + 1) / 2; // separator that moves up
+		Internal* sibling = newInternal();
+
+		parent->count = mid;
+
+		for (int i = 0; i < mid; ++i) {
+			parent->keys[i] = tmpKeys[i];
+		}
+
+		for (int i = 0; i <= mid; ++i) {
+			parent->children[i] = tmpChildren[i];
+		}
+
+		sibling->count = INTERNAL_SLOTS - mid;
+
+		for (int i = 0; i < sibling->count; ++i) {
+			sibling->keys[i] = tmpKeys[mid + 1 + i];
+		}
+
+		for (int i = 0; i <= sibling->count; ++i) {
+			sibling->children[i] = tmpChildren[mid + 1 + i];
+		}
+
+		sepKey = tmpKeys[mid];
+		rightNode = sibling;
+		depth--;
+
+	}
+
+	// the root was split, so the tree grows by one level
+	Internal* newRoot = newInternal();
+	newRoot->count = 1;
+	newRoot->keys[0] = sepKey;
+	newRoot->children[0] = root;
+	newRoot->children[1] = rightNode;
+	root = newRoot;
+
+}
+
+// HELPER FUNCTION: borrows a key from a sibling leaf, or merges with it,
+// so that lf (child pos of parent) is at least half full
+// USED BY: remove()
+template <class T, class U>
+void BPlusTree<T, U>::fixLeaf(Internal* parent, int pos, Leaf* lf) {
+
+	const int minKeys = LEAF_SLOTS / 2;
+	Leaf* leftSib = (pos > 0) ? static_cast<Leaf*>(parent->children[pos - 1]) : nullptr;
+	Leaf* rightSib = (pos < parent->count) ? static_cast<Leaf*>(parent->children[pos + 1]) : nullptr;
+
+	// borrow the largest key of the left sibling
+	if (leftSib != nullptr && leftSib->count > minKeys) {
+
+		for (int i = lf->count; i > 0; --i) {
+			lf->keys[i] = lf->keys[i - 1];
+			lf->vals[i] = lf->vals[i - 1];
+		}
+
+		lf->keys[0] = leftSib->keys[leftSib->count - 1];
+		lf->vals[0] = leftSib->vals[leftSib->count - 1];
+		lf->count++;
+		leftSib->count--;
+		parent->keys[pos - 1] = lf->keys[0];
+		return;
+
+	}
+
+	// borrow the smallest key of the right sibling
+	if (rightSib != nullptr && rightSib->count > minKeys) {
+
+		lf->keys[lf->count] = rightSib->keys[0];
+		lf->vals[lf->count] = rightSib->vals[0];
+		lf->count++;
+
+		for (int i = 0; i < rightSib->count - 1; ++i) {
+			rightSib->keys[i] = rightSib->keys[i + 1];
+			rightSib->vals[i] = rightSib->vals[i + 1];
+		}
+
+		rightSib->count--;
+		parent->keys[pos] = rightSib->keys[0];
+		return;
+
+	}
+
+	// merge the right one of the pair into the left one
+	Leaf* left = (leftSib != nullptr) ? leftSib : lf;
+	Leaf* right = (leftSib != nullptr) ? lf : rightSib;
+	int sepPos = (leftSib != nullptr) ? pos - 1 : pos; // separator between left and right
+
+	for (int i = 0; i < right->count; ++i) {
+		left->keys[left->count + i] = right->keys[i];
+		left->vals[left->count + i] = right->vals[i];
+	}
+
+	left->count += right->count;
+	left->next = right->next;
+
+	if (right->next != nullptr) {
+		right->next->prev = left;
+	}
+
+	delete right;
+
+	// drop the separator and the merged child from the parent
+	for (int i = sepPos; i < parent->count - 1; ++i) {
+		parent->keys[i] = parent->keys[i + 1];
+		parent->children[i + 1] = parent->children[i + 2];
+	}
+
+	parent->count--;
+
+}
+
+// HELPER FUNCTION: rotates a key through the parent from a sibling, or merges
+// with it, so that in (child pos of parent) is at least half full
+// USED BY: remove()
+template <class T, class U>
+void BPlusTree<T, U>::fixInternal(Internal* parent, int pos, Internal* in) {
+
+	const int minKeys = INTERNAL_SLOTS / 2;
+	Internal* leftSib = (pos > 0) ? static_cast<Internal*>(parent->children[pos - 1]) : nullptr;
+	Internal* rightSib = (pos < parent->count) ? static_cast<Internal*>(parent->children[pos + 1]) : nullptr;
+
+	// rotate right: the parent's separator comes down, the left sibling's last key goes up
+	if (leftSib != nullptr && leftSib->count > minKeys) {
+
+		for (int i = in->count; i > 0; --i) {
+			in->keys[i] = in->keys[i - 1];
+		}
+
+		for (int i = in->count + 1; i > 0; --i) {
+			in->children[i] = in->children[i - 1];
+		}
+
+		in->keys[0] = parent->keys[pos - 1];
+		in->children[0] = leftSib->children[leftSib->count];
+		in->count++;
+		parent->keys[pos - 1] = leftSib->keys[leftSib->count - 1];
+		leftSib->count--;
+		return;
+
+	}
+
+	// rotate left: the parent's separator comes down, the right sibling's first key goes up
+	if (rightSib != nullptr && rightSib->count > minKeys) {
+
+		in->keys[in->count] = parent->keys[pos];
+		in->children[in->count + 1] = rightSib->children[0];
+		in->count++;
+		parent->keys[pos] = rightSib->keys[0];
+
+		for (int i = 0; i < rightSib->count - 1; ++i) {
+			rightSib->keys[i] = rightSib->keys[i + 1];
+		}
+
+		for (int i = 0; i < rightSib->count; ++i) {
+			rightSib->children[i] = rightSib->children[i + 1];
+		}
+
+		rightSib->count--;
+		return;
+
+	}
+
+	// merge: left + separator + right
+	Internal* left = (leftSib != nullptr) ? leftSib : in;
+	Internal* right = (leftSib != nullptr) ? in : rightSib;
+	int sepPos = (leftSib != nullptr) ? pos - 1 : pos; // separator between left and right
+
+	left->keys[left->count] = parent->keys[sepPos];
+
+	for (int i = 0; i < right->count; ++i) {
+		left->keys[left->count + 1 + i] = right->keys[i];
+	}
+
+	for (int i = 0; i <= right->count; ++i) {
+		left->children[left->count + 1 + i] = right->children[i];
+	}
+
+	left->count += right->count + 1;
+	delete right;
+
+	// drop the separator and the merged child from the parent
+	for (int i = sepPos; i < parent->count - 1; ++i) {
+		parent->keys[i] = parent->keys[i + 1];
+		parent->children[i + 1] = parent->children[i + 2];
+	}
+
+	parent->count--;
+
+}
@@ -0,0 +1,839 @@
+/*
+ConcurrentRedBlackTree.h
+
+Red-Black Tree template class that implements an Ordered Map for
+read-mostly workloads shared between threads
+
+Readers never lock: they pin the current epoch, load the published root
+and walk an immutable version of the tree. A single writer at a time
+(writers are serialized by a mutex) path-copies the nodes it changes,
+publishes the new root atomically, and retires the replaced nodes.
+Retired nodes are freed once no reader pinned to an older epoch remains.
+
+Balancing follows the left-leaning variant of the Red-Black Tree, whose
+recursive insert and remove only touch nodes on or next to the search
+path, which keeps each update to O(log n) copied nodes.
+
+Authour: Fitz Laddaran
+Contact: fitzladdaran@gmail.com
+Last Updated: 27/08/2020
+*/
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <vector>
+
+using std::vector;
+using std::runtime_error;
+
+template <class T, class U>
+class ConcurrentNodeT {
+
+public:
+
+	T key; // unique value, occurs only once in tree
+	U value; // associated value with key, non-unique
+	ConcurrentNodeT<T, U>* left; // left child pointer
+	ConcurrentNodeT<T, U>* right; // right child pointer
+	bool isBlack; // checks the colour of a node
+	unsigned long version; // writer version that created this node
+
+	// constructor
+	ConcurrentNodeT(const T& data1, const U& data2, unsigned long ver) :
+		key(data1), value(data2) {
+		left = nullptr;
+		right = nullptr;
+		isBlack = false;
+		version = ver;
+	}
+
+};
+
+template <class T, class U>
+class ConcurrentRedBlackTree {
+
+public:
+
+	// a consistent, read-only view of one version of the tree;
+	// nodes it can reach are not freed until it is destroyed
+	// at most MAX_READERS (128) snapshots, including those the lock-free reads take
+	// for their duration, can be held at once across all threads; taking another
+	// waits up to PIN_WAIT_MS for one to be released, then throws runtime_error,
+	// so a thread holding all of them fails instead of waiting on itself
+	class Snapshot {
+
+	public:
+
+		Snapshot(Snapshot&& snap); // move constructor
+		~Snapshot(); // destructor, unpins the epoch
+
+		// search snapshot to see if key matches any of the nodes
+		bool search(const T& keyP) const;
+
+		// returns all values whose keys are between keyP1 - keyP2
+		vector<U> search(const T& keyP1, const T& keyP2) const;
+
+		// returns all values in ascending order of keys
+		vector<U> values() const;
+
+		// returns all keys in ascending order
+		vector<T> keys() const;
+
+	private:
+
+		friend class ConcurrentRedBlackTree;
+
+		Snapshot(const ConcurrentRedBlackTree* tree); // pins an epoch and loads the root
+		Snapshot(const Snapshot& snap) = delete;
+		Snapshot& operator=(const Snapshot& snap) = delete;
+
+		const ConcurrentRedBlackTree* owner; // tree the epoch is pinned in
+		int slot; // reader slot holding the pinned epoch, -1 once moved from
+		const ConcurrentNodeT<T, U>* root; // root of the pinned version
+
+	};
+
+	ConcurrentRedBlackTree(); // constructor
+	~ConcurrentRedBlackTree(); // destructor, no readers may be active
+
+	// inserts a node, if key is not present in R-B Tree
+	bool insert(const T& keyP, const U& valueP);
+
+	// removes a node, if key is present in R-B Tree
+	bool remove(const T& keyP);
+
+	// search R-B Tree to see if key matches any of the nodes (lock-free)
+	bool search(const T& keyP) const;
+
+	// returns all values whose keys are between keyP1 - keyP2 (lock-free)
+	vector<U> search(const T& keyP1, const T& keyP2) const;
+
+	// returns all values in ascending order of keys (lock-free)
+	vector<U> values() const;
+
+	// returns all keys in ascending order (lock-free)
+	vector<T> keys() const;
+
+	// returns number of items stored in the tree
+	int size() const;
+
+	// pins the current version for several consistent reads
+	Snapshot snapshot() const;
+
+private:
+
+	typedef ConcurrentNodeT<T, U> Node;
+
+	static const int MAX_READERS = 128; // concurrently pinned readers
+	static const int PIN_WAIT_MS = 1000; // longest wait for a free reader slot
+	static const unsigned long IDLE = ~0UL; // epoch of an unused reader slot
+
+	// one reader's pinned epoch, alone on its cache line
+	struct alignas(64) ReaderSlot {
+		std::atomic<unsigned long> epoch;
+	};
+
+	// nodes replaced by one published update
+	struct RetiredBatch {
+		unsigned long epoch; // epoch the update was published in
+		vector<Node*> nodes; // nodes unreachable from later versions
+	};
+
+	ConcurrentRedBlackTree(const ConcurrentRedBlackTree& tree) = delete;
+	ConcurrentRedBlackTree& operator=(const ConcurrentRedBlackTree& tree) = delete;
+
+	// attributes
+	std::atomic<Node*> root; // published root
+	std::atomic<int> currSize; // size of tree
+	mutable std::atomic<unsigned long> globalEpoch; // advanced after each publish
+	mutable ReaderSlot readers[MAX_READERS]; // pinned epochs of active readers
+	std::mutex writerLock; // serializes writers
+	unsigned long writerVersion; // version stamped on nodes copied by the current update
+	vector<Node*> pending; // nodes replaced by the current update
+	vector<RetiredBatch> retired; // published updates waiting for readers to leave
+
+	// helper functions: readers
+	int pin() const; // claims a reader slot at the current epoch
+	void unpin(int slot) const; // releases a reader slot
+	static bool find(const Node* nd, const T& keyP); // iterative search
+	static void inOrderSearch(const Node* nd, vector<U>& myVect, const T& low, const T& high); // in-order traversal for search()
+	static void inOrderValues(const Node* nd, vector<U>& myVect); // in-order traversal for values()
+	static void inOrderKeys(const Node* nd, vector<T>& myVect); // in-order traversal for keys()
+
+	// helper functions: writer (path copying)
+	Node* mutableNode(Node* nd); // copies nd unless it was created by the current update
+	void retire(Node* nd); // schedules nd to be freed
+	void publish(Node* newRoot); // publishes an update and reclaims old nodes
+	Node* insert(Node* nd, const T& keyP, const U& valueP); // recursive insert
+	Node* remove(Node* nd, const T& keyP); // recursive remove
+	Node* removeMin(Node* nd); // removes the smallest node under nd
+	Node* rotateLeft(Node* nd); // left rotation on nd
+	Node* rotateRight(Node* nd); // right rotation on nd
+	void flipColours(Node* nd); // flips colour of nd and its children
+	Node* moveRedLeft(Node* nd); // makes nd->left or one of its children red
+	Node* moveRedRight(Node* nd); // makes nd->right or one of its children red
+	Node* balance(Node* nd); // restores left-leaning invariants on the way up
+	static bool isRed(const Node* nd); // NULL nodes are black
+	static void clear(Node* nd); // deallocates dynamic memory
+
+};
+
+// constructor
+template <class T, class U>
+ConcurrentRedBlackTree<T, U>::ConcurrentRedBlackTree() {
+
+	root.store(nullptr);
+	currSize.store(0);
+	globalEpoch.store(0);
+	writerVersion = 0;
+
+	for (int i = 0; i < MAX_READERS; ++i) {
+		readers[i].epoch.store(IDLE);
+	}
+
+}
+
+// destructor
+template <class T, class U>
+ConcurrentRedBlackTree<T, U>::~ConcurrentRedBlackTree() {
+
+	clear(root.load());
+
+	for (size_t i = 0; i < retired.size(); ++i) {
+		for (size_t j = 0; j < retired[i].nodes.size(); ++j) {
+			delete retired[i].nodes[j];
+		}
+	}
+
+}
+
+// inserts node if key is not in R-B Tree and return true
+// otherwise return false without insertion
+template <class T, class U>
+bool ConcurrentRedBlackTree<T, U>::insert(const T& keyP, const U& valueP) {
+
+	std::lock_guard<std::mutex> guard(writerLock);
+	Node* current = root.load(std::memory_order_relaxed); // only writers change root
+
+	// if keyP is found, then return false without copying anything
+	if (find(current, keyP)) {
+		return false;
+	}
+
+	// copy the search path into a new version, then publish it
+	writerVersion++;
+	Node* newRoot = insert(current, keyP, valueP);
+	newRoot->isBlack = true;
+	currSize.fetch_add(1);
+	publish(newRoot);
+	return true;
+
+}
+
+// removes a node if key is in R-B Tree and return true
+// otherwise return false without removal
+template <class T, class U>
+bool ConcurrentRedBlackTree<T, U>::remove(const T& keyP) {
+
+	std::lock_guard<std::mutex> guard(writerLock);
+	Node* current = root.load(std::memory_order_relaxed); // only writers change root
+
+	// if keyP is not found, then return false without copying anything
+	if (!find(current, keyP)) {
+		return false;
+	}
+
+	writerVersion++;
+
+	// if both children of root are black, set root to red
+	if (!isRed(current->left) && !isRed(current->right)) {
+		current = mutableNode(current);
+		current->isBlack = false;
+	}
+
+	Node* newRoot = remove(current, keyP);
+
+	if (newRoot != nullptr) {
+		newRoot->isBlack = true;
+	}
+
+	currSize.fetch_sub(1);
+	publish(newRoot);
+	return true;
+
+}
+
+// search R-B Tree to see if key matches any node's key
+// return true if found, otherwise false
+template <class T, class U>
+bool ConcurrentRedBlackTree<T, U>::search(const T& keyP) const {
+
+	return snapshot().search(keyP);
+
+}
+
+// returns a vector containing all values whose keys are between
+// keyP1 - keyP2, based on ascending key order
+template <class T, class U>
+vector<U> ConcurrentRedBlackTree<T, U>::search(const T& keyP1, const T& keyP2) const {
+
+	return snapshot().search(keyP1, keyP2);
+
+}
+
+// returns a vector containing all values in ascending key order
+template <class T, class U>
+vector<U> ConcurrentRedBlackTree<T, U>::values() const {
+
+	return snapshot().values();
+
+}
+
+// returns a vector containing all keys in ascending order
+template <class T, class U>
+vector<T> ConcurrentRedBlackTree<T, U>::keys() const {
+
+	return snapshot().keys();
+
+}
+
+// returns the number of items stored in the tree
+template <class T, class U>
+int ConcurrentRedBlackTree<T, U>::size() const {
+
+	return currSize.load();
+
+}
+
+// returns a snapshot of the current version of the tree
+template <class T, class U>
+typename ConcurrentRedBlackTree<T, U>::Snapshot ConcurrentRedBlackTree<T, U>::snapshot() const {
+
+	return Snapshot(this);
+
+}
+
+// SNAPSHOT: pins the current epoch, then loads the root it protects
+template <class T, class U>
+ConcurrentRedBlackTree<T, U>::Snapshot::Snapshot(const ConcurrentRedBlackTree* tree) {
+
+	owner = tree;
+	slot = tree->pin();
+	root = tree->root.load(); // must not be reordered before pin()
+
+}
+
+// SNAPSHOT: move constructor, the moved-from snapshot no longer holds a slot
+template <class T, class U>
+ConcurrentRedBlackTree<T, U>::Snapshot::Snapshot(Snapshot&& snap) {
+
+	owner = snap.owner;
+	slot = snap.slot;
+	root = snap.root;
+	snap.slot = -1;
+
+}
+
+// SNAPSHOT: destructor
+template <class T, class U>
+ConcurrentRedBlackTree<T, U>::Snapshot::~Snapshot() {
+
+	if (slot != -1) {
+		owner->unpin(slot);
+	}
+
+}
+
+// SNAPSHOT: search to see if key matches any node's key
+template <class T, class U>
+bool ConcurrentRedBlackTree<T, U>::Snapshot::search(const T& keyP) const {
+
+	return find(root, keyP);
+
+}
+
+// SNAPSHOT: returns all values whose keys are between keyP1 - keyP2
+template <class T, class U>
+vector<U> ConcurrentRedBlackTree<T, U>::Snapshot::search(const T& keyP1, const T& keyP2) const {
+
+	vector<U> myVect;
+
+	// bounds may be given in either order
+	if (keyP2 < keyP1) {
+		inOrderSearch(root, myVect, keyP2, keyP1);
+	}
+
+	else {
+		inOrderSearch(root, myVect, keyP1, keyP2);
+	}
+
+	return myVect;
+
+}
+
+// SNAPSHOT: returns all values in ascending key order
+template <class T, class U>
+vector<U> ConcurrentRedBlackTree<T, U>::Snapshot::values() const {
+
+	vector<U> myVect;
+	inOrderValues(root, myVect);
+	return myVect;
+
+}
+
+// SNAPSHOT: returns all keys in ascending order
+template <class T, class U>
+vector<T> ConcurrentRedBlackTree<T, U>::Snapshot::keys() const {
+
+	vector<T> myVect;
+	inOrderKeys(root, myVect);
+	return myVect;
+
+}
+
+// HELPER FUNCTION: claims a free reader slot and pins it to the current epoch,
+// starting from a per-thread slot so that readers rarely share cache lines;
+// throws runtime_error if no slot frees up within PIN_WAIT_MS
+// USED BY: Snapshot
+template <class T, class U>
+int ConcurrentRedBlackTree<T, U>::pin() const {
+
+	static thread_local size_t hint = std::hash<std::thread::id>()(std::this_thread::get_id());
+	std::chrono::steady_clock::time_point deadline; // set once every slot has been found pinned
+	bool waiting = false;
+
+	while (true) {
+
+		for (int i = 0; i < MAX_READERS; ++i) {
+
+			int slot = (int)((hint + i) % MAX_READERS);
+			unsigned long idle = IDLE;
+
+			if (readers[slot].epoch.load(std::memory_order_relaxed) == IDLE &&
+				readers[slot].epoch.compare_exchange_strong(idle, globalEpoch.load())) {
+				hint = slot;
+				return slot;
+			}
+
+		}
+
+		// every slot is pinned, wait a bounded time for a reader to leave
+		if (!waiting) {
+			deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds((long)PIN_WAIT_MS);
+			waiting = true;
+		}
+
+		else if (std::chrono::steady_clock::now() >= deadline) {
+			throw runtime_error("Every reader slot is pinned, can't take another snapshot");
+		}
+
+		std::this_thread::yield();
+
+	}
+
+}
+
+// HELPER FUNCTION: releases a reader slot
+// USED BY: Snapshot
+template <class T, class U>
+void ConcurrentRedBlackTree<T, U>::unpin(int slot) const {
+
+	readers[slot].epoch.store(IDLE, std::memory_order_release);
+
+}
+
+// HELPER FUNCTION: iterative search from nd
+// USED BY: insert(), remove(), Snapshot::search()
+template <class T, class U>
+bool ConcurrentRedBlackTree<T, U>::find(const Node* nd, const T& keyP) {
+
+	while (nd != nullptr) {
+
+		if (keyP == nd->key) {
+			return true;
+		}
+
+		nd = (keyP < nd->key) ? nd->left : nd->right;
+
+	}
+
+	return false;
+
+}
+
+// HELPER FUNCTION: in-order traversal for search(T keyP1, T keyP2),
+// skipping subtrees that lie outside low - high
+// USED BY: Snapshot::search(T keyP1, T keyP2)
+template <class T, class U>
+void ConcurrentRedBlackTree<T, U>::inOrderSearch(const Node* nd, vector<U>& myVect, const T& low, const T& high) {
+
+	if (nd != nullptr) {
+
+		if (low < nd->key) {
+			inOrderSearch(nd->left, myVect, low, high);
+		}
+
+		if (!(nd->key < low) && !(high < nd->key)) {
+			myVect.push_back(nd->value);
+		}
+
+		if (nd->key < high) {
+			inOrderSearch(nd->right, myVect, low, high);
+		}
+
+	}
+
+}
+
+// HELPER FUNCTION: in-order traversal for values()
+// USED BY: Snapshot::values()
+template <class T, class U>
+void ConcurrentRedBlackTree<T, U>::inOrderValues(const Node* nd, vector<U>& myVect) {
+
+	if (nd != nullptr) {
+
+		inOrderValues(nd->left, myVect);
+		myVect.push_back(nd->value);
+		inOrderValues(nd->right, myVect);
+
+	}
+
+}
+
+// HELPER FUNCTION: in-order traversal for keys()
+// USED BY: Snapshot::keys()
+template <class T, class U>
+void ConcurrentRedBlackTree<T, U>::inOrderKeys(const Node* nd, vector<T>& myVect) {
+
+	if (nd != nullptr) {
+
+		inOrderKeys(nd->left, myVect);
+		myVect.push_back(nd->key);
+		inOrderKeys(nd->right, myVect);
+
+	}
+
+}
+
+// HELPER FUNCTION: returns a node of the current update that may be modified;
+// a node readers can see is copied and the original retired
+// USED BY: writer helpers
+template <class T, class U>
+typename ConcurrentRedBlackTree<T, U>::Node* ConcurrentRedBlackTree<T, U>::mutableNode(Node* nd) {
+
+	// created by this update, so no reader can see it yet
+	if (nd->version == writerVersion) {
+		return nd;
+	}
+
+	Node* newNode = new Node(nd->key, nd->value, writerVersion);
+	newNode->left = nd->left;
+	newNode->right = nd->right;
+	newNode->isBlack = nd->isBlack;
+	retire(nd);
+	return newNode;
+
+}
+
+// HELPER FUNCTION: schedules a node to be freed after the current update is published
+// USED BY: mutableNode(), remove(), removeMin()
+template <class T, class U>
+void ConcurrentRedBlackTree<T, U>::retire(Node* nd) {
+
+	pending.push_back(nd);
+
+}
+
+// HELPER FUNCTION: publishes newRoot, advances the epoch and frees every
+// batch retired before the oldest epoch still pinned by a reader
+// USED BY: insert(), remove()
+template <class T, class U>
+void ConcurrentRedBlackTree<T, U>::publish(Node* newRoot) {
+
+	root.store(newRoot);
+
+	// readers pinned at the old epoch may still hold the old root
+	RetiredBatch batch;
+	batch.epoch = globalEpoch.fetch_add(1);
+	batch.nodes.swap(pending);
+
+	if (!batch.nodes.empty()) {
+		retired.push_back(batch);
+	}
+
+	// find the oldest pinned epoch
+	unsigned long oldest = IDLE;
+
+	for (int i = 0; i < MAX_READERS; ++i) {
+
+		unsigned long epoch = readers[i].epoch.load();
+
+		if (epoch < oldest) {
+			oldest = epoch;
+		}
+
+	}
+
+	// free batches no reader can reach, keep the rest in order
+	size_t kept = 0;
+
+	for (size_t i = 0; i < retired.size(); ++i) {
+
+		if (retired[i].epoch < oldest) {
+			for (size_t j = 0; j < retired[i].nodes.size(); ++j) {
+				delete retired[i].nodes[j];
+			}
+		}
+
+		else {
+			retired[kept++].nodes.swap(retired[i].nodes);
+			retired[kept - 1].epoch = retired[i].epoch;
+		}
+
+	}
+
+	retired.resize(kept);
+
+}
+
+// HELPER FUNCTION: recursive insert, copying every node on the path
+// USED BY: insert()
+template <class T, class U>
+typename ConcurrentRedBlackTree<T, U>::Node* ConcurrentRedBlackTree<T, U>::insert(Node* nd, const T& keyP, const U& valueP) {
+
+	// new nodes are red
+	if (nd == nullptr) {
+		return new Node(keyP, valueP, writerVersion);
+	}
+
+	nd = mutableNode(nd);
+
+	if (keyP < nd->key) {
+		nd->left = insert(nd->left, keyP, valueP);
+	}
+
+	else {
+		nd->right = insert(nd->right, keyP, valueP);
+	}
+
+	// lean left, split temporary 4-nodes
+	if (isRed(nd->right) && !isRed(nd->left)) {
+		nd = rotateLeft(nd);
+	}
+
+	if (isRed(nd->left) && isRed(nd->left->left)) {
+		nd = rotateRight(nd);
+	}
+
+	if (isRed(nd->left) && isRed(nd->right)) {
+		flipColours(nd);
+	}
+
+	return nd;
+
+}
+
+// HELPER FUNCTION: recursive remove, keyP must be present under nd
+// USED BY: remove()
+template <class T, class U>
+typename ConcurrentRedBlackTree<T, U>::Node* ConcurrentRedBlackTree<T, U>::remove(Node* nd, const T& keyP) {
+
+	nd = mutableNode(nd);
+
+	// keyP is in the left subtree
+	if (keyP < nd->key) {
+
+		if (!isRed(nd->left) && !isRed(nd->left->left)) {
+			nd = moveRedLeft(nd);
+		}
+
+		nd->left = remove(nd->left, keyP);
+
+	}
+
+	// keyP is this node or in the right subtree
+	else {
+
+		if (isRed(nd->left)) {
+			nd = rotateRight(nd);
+		}
+
+		// keyP is at the bottom of the tree
+		if (keyP == nd->key && nd->right == nullptr) {
+			retire(nd);
+			return nullptr;
+		}
+
+		if (!isRed(nd->right) && !isRed(nd->right->left)) {
+			nd = moveRedRight(nd);
+		}
+
+		// replace with the successor, then remove the successor
+		if (keyP == nd->key) {
+
+			Node* successor = nd->right;
+
+			while (successor->left != nullptr) {
+				successor = successor->left;
+			}
+
+			nd->key = successor->key;
+			nd->value = successor->value;
+			nd->right = removeMin(nd->right);
+
+		}
+
+		else {
+			nd->right = remove(nd->right, keyP);
+		}
+	}
+
+	return balance(nd);
+
+}
+
+// HELPER FUNCTION: removes the smallest node under nd
+// USED BY: remove()
+template <class T, class U>
+typename ConcurrentRedBlackTree<T, U>::Node* ConcurrentRedBlackTree<T, U>::removeMin(Node* nd) {
+
+	// the smallest node has no children in a left-leaning tree
+	if (nd->left == nullptr) {
+		retire(nd);
+		return nullptr;
+	}
+
+	nd = mutableNode(nd);
+
+	if (!isRed(nd->left) && !isRed(nd->left->left)) {
+		nd = moveRedLeft(nd);
+	}
+
+	nd->left = removeMin(nd->left);
+	return balance(nd);
+
+}
+
+// HELPER FUNCTION: left-rotate on nd, nd must already be mutable
+// USED BY: insert(), moveRedLeft(), balance()
+template <class T, class U>
+typename ConcurrentRedBlackTree<T, U>::Node* ConcurrentRedBlackTree<T, U>::rotateLeft(Node* nd) {
+
+	Node* newParent = mutableNode(nd->right); // nd's soon-to-be new parent
+	nd->right = newParent->left;
+	newParent->left = nd;
+	newParent->isBlack = nd->isBlack;
+	nd->isBlack = false;
+	return newParent;
+
+}
+
+// HELPER FUNCTION: right-rotate on nd, nd must already be mutable
+// USED BY: insert(), remove(), moveRedLeft(), moveRedRight(), balance()
+template <class T, class U>
+typename ConcurrentRedBlackTree<T, U>::Node* ConcurrentRedBlackTree<T, U>::rotateRight(Node* nd) {
+
+	Node* newParent = mutableNode(nd->left); // nd's soon-to-be new parent
+	nd->left = newParent->right;
+	newParent->right = nd;
+	newParent->isBlack = nd->isBlack;
+	nd->isBlack = false;
+	return newParent;
+
+}
+
+// HELPER FUNCTION: flips the colour of nd and both of its children
+// USED BY: insert(), moveRedLeft(), moveRedRight(), balance()
+template <class T, class U>
+void ConcurrentRedBlackTree<T, U>::flipColours(Node* nd) {
+
+	nd->left = mutableNode(nd->left);
+	nd->right = mutableNode(nd->right);
+	nd->isBlack = !nd->isBlack;
+	nd->left->isBlack = !nd->left->isBlack;
+	nd->right->isBlack = !nd->right->isBlack;
+
+}
+
+// HELPER FUNCTION: makes nd->left or one of its children red before descending left
+// USED BY: remove(), removeMin()
+template <class T, class U>
+typename ConcurrentRedBlackTree<T, U>::Node* ConcurrentRedBlackTree<T, U>::moveRedLeft(Node* nd) {
+
+	flipColours(nd);
+
+	if (isRed(nd->right->left)) {
+		nd->right = rotateRight(nd->right);
+		nd = rotateLeft(nd);
+		flipColours(nd);
+	}
+
+	return nd;
+
+}
+
+// HELPER FUNCTION: makes nd->right or one of its children red before descending right
+// USED BY: remove()
+template <class T, class U>
+typename ConcurrentRedBlackTree<T, U>::Node* ConcurrentRedBlackTree<T, U>::moveRedRight(Node* nd) {
+
+	flipColours(nd);
+
+	if (isRed(nd->left->left)) {
+		nd = rotateRight(nd);
+		flipColours(nd);
+	}
+
+	return nd;
+
+}
+
+// HELPER FUNCTION: restores left-leaning invariants on the way back up
+// USED BY: remove(), removeMin()
+template <class T, class U>
+typename ConcurrentRedBlackTree<T, U>::Node* ConcurrentRedBlackTree<T, U>::balance(Node* nd) {
+
+	if (isRed(nd->right) && !isRed(nd->left)) {
+		nd = rotateLeft(nd);
+	}
+
+	if (isRed(nd->left) && isRed(nd->left->left)) {
+		nd = rotateRight(nd);
+	}
+
+	if (isRed(nd->left) && isRed(nd->right)) {
+		flipColours(nd);
+	}
+
+	return nd;
+
+}
+
+// HELPER FUNCTION: checks the colour of a node, NULL nodes are black
+// USED BY: writer helpers
+template <class T, class U>
+bool ConcurrentRedBlackTree<T, U>::isRed(const Node* nd) {
+
+	return nd != nullptr && !nd->isBlack;
+
+}
+
+// HELPER FUNCTION: removes all nodes and deallocates dynamic memory for every node
+// USED BY: destructor
+template <class T, class U>
+void ConcurrentRedBlackTree<T, U>::clear(Node* nd) {
+
+	if (nd != nullptr) {
+
+		clear(nd->left); // recursively delete left descendants
+		clear(nd->right); // recursively delete right descendants
+		delete nd;
+
+	}
+
+}
@@ -0,0 +1,773 @@
+/*
+IntervalTree.h
+
+Red-Black Tree template class that stores closed intervals [low, high]
+with an associated value. Every node also keeps the largest high endpoint
+in its sub-tree (maxEnd), updated by the rotations and fixups, so stabbing
+and overlap queries skip every sub-tree that cannot hold a match instead
+of scanning all values.
+
+Authour: Fitz Laddaran
+Contact: fitzladdaran@gmail.com
+Last Updated: 27/08/2020
+*/
+
+#pragma once
+#include <vector>
+#include <utility>
+
+using std::vector;
+using std::pair;
+
+template <class T, class U>
+class IntervalNodeT {
+
+public:
+
+	T low; // start of the interval, intervals are ordered by low then high
+	T high; // end of the interval, never less than low
+	T maxEnd; // largest high endpoint in the sub-tree rooted at this node
+	U value; // associated value with the interval, non-unique
+	IntervalNodeT<T, U>* left; // left child pointer
+	IntervalNodeT<T, U>* right; // right child pointer
+	IntervalNodeT<T, U>* parent; // parent pointer
+	bool isBlack; // checks the colour of a node
+
+	// constructor
+	IntervalNodeT(const T& lowP, const T& highP, const U& valueP) : low(lowP), high(highP), maxEnd(highP), value(valueP) {
+		left = nullptr;
+		right = nullptr;
+		parent = nullptr;
+		isBlack = false;
+	}
+
+};
+
+template <class T, class U>
+class IntervalTree {
+
+public:
+
+	IntervalTree(); // constructor
+	IntervalTree(const IntervalTree& iTree); // copy constructor
+	IntervalTree& operator=(const IntervalTree& iTree); // overloaded assignment operator
+	~IntervalTree(); // destructor
+
+	// inserts [lowP, highP], if that interval is not present and lowP <= highP
+	bool insert(const T& lowP, const T& highP, const U& valueP);
+
+	// removes [lowP, highP], if that interval is present
+	bool remove(const T& lowP, const T& highP);
+
+	// checks if the exact interval [lowP, highP] is present
+	bool search(const T& lowP, const T& highP) const;
+
+	// returns the values of all intervals containing point
+	// based on ascending order of intervals
+	vector<U> stab(const T& point) const;
+
+	// returns the values of all intervals overlapping [lowP, highP]
+	// based on ascending order of intervals
+	vector<U> overlap(const T& lowP, const T& highP) const;
+
+	// checks if any interval overlaps [lowP, highP], in O(log n)
+	bool overlapsAny(const T& lowP, const T& highP) const;
+
+	// returns all values in the tree
+	// based on ascending order of intervals
+	vector<U> values() const;
+
+	// returns all intervals in the tree in ascending order
+	vector<pair<T, T>> intervals() const;
+
+	// returns number of intervals stored in the tree
+	int size() const;
+
+	// returns a pointer to tree's root node
+	IntervalNodeT<T, U>* getRoot() const;
+
+private:
+
+	// attributes
+	IntervalNodeT<T, U>* root; // pointer to tree's root
+	int currSize; // size of tree
+
+	// helper functions
+	IntervalNodeT<T, U>* copy(IntervalNodeT<T, U>* nd, IntervalNodeT<T, U>* newParent); // deep copy every node in the tree
+	void clear(IntervalNodeT<T, U>* nd); // deallocates dynamic memory
+	static bool intervalLess(const T& lowA, const T& highA, const T& lowB, const T& highB); // orders intervals by low, then high
+	static bool isBlackNode(IntervalNodeT<T, U>* nd); // NULL children count as black
+	static IntervalNodeT<T, U>* minimum(IntervalNodeT<T, U>* nd); // finds the left-most node under nd
+	static void updateMax(IntervalNodeT<T, U>* nd); // recomputes maxEnd of nd from its children
+	IntervalNodeT<T, U>* findNode(const T& lowP, const T& highP) const; // finds the node holding [lowP, highP]
+	void transplant(IntervalNodeT<T, U>* oldNode, IntervalNodeT<T, U>* newNode); // puts newNode where oldNode hangs
+	void insertFix(IntervalNodeT<T, U>* nd); // restores R-B properties after an insertion
+	void removeFix(IntervalNodeT<T, U>* nd, IntervalNodeT<T, U>* parent); // restores R-B properties after a removal
+	void leftRotate(IntervalNodeT<T, U>* nd); // left rotation on nd
+	void rightRotate(IntervalNodeT<T, U>* nd); // right rotation on nd
+
+};
+
+// constructor
+template <class T, class U>
+IntervalTree<T, U>::IntervalTree() {
+
+	root = nullptr;
+	currSize = 0;
+
+}
+
+// copy constructor
+template <class T, class U>
+IntervalTree<T, U>::IntervalTree(const IntervalTree& iTree) {
+
+	root = copy(iTree.root, nullptr);
+	currSize = iTree.currSize;
+
+}
+
+// overloaded assignment operator
+template <class T, class U>
+IntervalTree<T, U>& IntervalTree<T, U>::operator=(const IntervalTree& iTree) {
+
+	// if it is not self-assignment
+	if (this != &iTree) {
+
+		clear(root);
+		root = copy(iTree.root, nullptr);
+		currSize = iTree.currSize;
+
+	}
+
+	return *this;
+
+}
+
+// destructor
+template <class T, class U>
+IntervalTree<T, U>::~IntervalTree() {
+
+	clear(root);
+
+}
+
+// inserts [lowP, highP] and returns true, otherwise returns false
+// if the interval is already present or is empty (highP < lowP)
+template <class T, class U>
+bool IntervalTree<T, U>::insert(const T& lowP, const T& highP, const U& valueP) {
+
+	if (highP < lowP) {
+		return false;
+	}
+
+	IntervalNodeT<T, U>* parent = nullptr; // parent of the new node
+	IntervalNodeT<T, U>* current = root; // iterator
+	bool goLeft = false; // checks if the new node is a left child
+
+	// find the parent, giving up if the interval is already present
+	while (current != nullptr) {
+
+		parent = current;
+
+		if (intervalLess(lowP, highP, current->low, current->high)) {
+			goLeft = true;
+			current = current->left;
+		}
+
+		else if (intervalLess(current->low, current->high, lowP, highP)) {
+			goLeft = false;
+			current = current->right;
+		}
+
+		else {
+			return false;
+		}
+
+	}
+
+	IntervalNodeT<T, U>* newNode = new IntervalNodeT<T, U>(lowP, highP, valueP);
+	newNode->parent = parent;
+
+	if (parent == nullptr) {
+		root = newNode;
+	}
+
+	else if (goLeft) {
+		parent->left = newNode;
+	}
+
+	else {
+		parent->right = newNode;
+	}
+
+	// maxEnd can only grow, so stop at the first ancestor already covering highP
+	for (IntervalNodeT<T, U>* nd = parent; nd != nullptr && nd->maxEnd < highP; nd = nd->parent) {
+		nd->maxEnd = highP;
+	}
+
+	insertFix(newNode);
+	currSize++;
+	return true;
+
+}
+
+// removes [lowP, highP] and returns true, otherwise returns false
+// if the interval is not present
+template <class T, class U>
+bool IntervalTree<T, U>::remove(const T& lowP, const T& highP) {
+
+	IntervalNodeT<T, U>* ndRemove = findNode(lowP, highP); // node holding the interval
+
+	// if interval is not found
+	if (ndRemove == nullptr) {
+		return false;
+	}
+
+	IntervalNodeT<T, U>* child = nullptr; // node that takes the removed position (can be NULL)
+	IntervalNodeT<T, U>* childParent = nullptr; // parent of child after the removal
+	bool removedBlack = ndRemove->isBlack; // colour taken out of the tree
+
+	// if ndRemove has one or no children, splice it out
+	if (ndRemove->left == nullptr) {
+		child = ndRemove->right;
+		childParent = ndRemove->parent;
+		transplant(ndRemove, ndRemove->right);
+	}
+
+	else if (ndRemove->right == nullptr) {
+		child = ndRemove->left;
+		childParent = ndRemove->parent;
+		transplant(ndRemove, ndRemove->left);
+	}
+
+	// if ndRemove has two children, its successor takes its place
+	else {
+
+		IntervalNodeT<T, U>* next = minimum(ndRemove->right); // in-order successor
+		removedBlack = next->isBlack;
+		child = next->right;
+
+		if (next->parent == ndRemove) {
+			childParent = next;
+		}
+
+		else {
+			childParent = next->parent;
+			transplant(next, next->right);
+			next->right = ndRemove->right;
+			next->right->parent = next;
+		}
+
+		transplant(ndRemove, next);
+		next->left = ndRemove->left;
+		next->left->parent = next;
+		next->isBlack = ndRemove->isBlack;
+
+	}
+
+	// every sub-tree that lost a node lies on the path from childParent to the root
+	for (IntervalNodeT<T, U>* nd = childParent; nd != nullptr; nd = nd->parent) {
+		updateMax(nd);
+	}
+
+	delete ndRemove;
+	currSize--;
+
+	if (removedBlack) {
+		removeFix(child, childParent);
+	}
+
+	return true;
+
+}
+
+// checks if the exact interval [lowP, highP] is present
+template <class T, class U>
+bool IntervalTree<T, U>::search(const T& lowP, const T& highP) const {
+
+	return findNode(lowP, highP) != nullptr;
+
+}
+
+// returns the values of all intervals containing point
+template <class T, class U>
+vector<U> IntervalTree<T, U>::stab(const T& point) const {
+
+	return overlap(point, point);
+
+}
+
+// returns the values of all intervals overlapping [lowP, highP], using an
+// in-order walk that skips sub-trees whose maxEnd is below lowP and stops
+// at the first interval starting after highP
+template <class T, class U>
+vector<U> IntervalTree<T, U>::overlap(const T& lowP, const T& highP) const {
+
+	vector<U> myVect;
+	vector<IntervalNodeT<T, U>*> path; // ancestors still to be visited
+	IntervalNodeT<T, U>* nd = root; // iterator
+
+	while (true) {
+
+		// descend left while the sub-tree can still reach lowP
+		while (nd != nullptr && !(nd->maxEnd < lowP)) {
+			path.push_back(nd);
+			nd = nd->left;
+		}
+
+		if (path.empty()) {
+			break;
+		}
+
+		nd = path.back();
+		path.pop_back();
+
+		// this interval and every later one start after highP
+		if (highP < nd->low) {
+			break;
+		}
+
+		if (!(nd->high < lowP)) {
+			myVect.push_back(nd->value);
+		}
+
+		nd = nd->right;
+
+	}
+
+	return myVect;
+
+}
+
+// checks if any interval overlaps [lowP, highP]; if the left sub-tree
+// reaches lowP it holds an overlap whenever any exists, so one path suffices
+template <class T, class U>
+bool IntervalTree<T, U>::overlapsAny(const T& lowP, const T& highP) const {
+
+	IntervalNodeT<T, U>* nd = root; // iterator
+
+	while (nd != nullptr) {
+
+		// if nd overlaps [lowP, highP]
+		if (!(highP < nd->low) && !(nd->high < lowP)) {
+			return true;
+		}
+
+		if (nd->left != nullptr && !(nd->left->maxEnd < lowP)) {
+			nd = nd->left;
+		}
+
+		else {
+			nd = nd->right;
+		}
+
+	}
+
+	return false;
+
+}
+
+// returns a vector containing all values in the tree
+template <class T, class U>
+vector<U> IntervalTree<T, U>::values() const {
+
+	vector<U> myVect;
+	myVect.reserve(currSize);
+	vector<IntervalNodeT<T, U>*> path; // ancestors still to be visited
+	IntervalNodeT<T, U>* nd = root; // iterator
+
+	while (nd != nullptr || !path.empty()) {
+
+		while (nd != nullptr) {
+			path.push_back(nd);
+			nd = nd->left;
+		}
+
+		nd = path.back();
+		path.pop_back();
+		myVect.push_back(nd->value);
+		nd = nd->right;
+
+	}
+
+	return myVect;
+
+}
+
+// returns a vector containing all intervals in the tree
+template <class T, class U>
+vector<pair<T, T>> IntervalTree<T, U>::intervals() const {
+
+	vector<pair<T, T>> myVect;
+	myVect.reserve(currSize);
+	vector<IntervalNodeT<T, U>*> path; // ancestors still to be visited
+	IntervalNodeT<T, U>* nd = root; // iterator
+
+	while (nd != nullptr || !path.empty()) {
+
+		while (nd != nullptr) {
+			path.push_back(nd);
+			nd = nd->left;
+		}
+
+		nd = path.back();
+		path.pop_back();
+		myVect.push_back(pair<T, T>(nd->low, nd->high));
+		nd = nd->right;
+
+	}
+
+	return myVect;
+
+}
+
+// returns the number of intervals stored in the tree
+template <class T, class U>
+int IntervalTree<T, U>::size() const {
+
+	return currSize;
+
+}
+
+// returns pointer to the root of the tree
+template <class T, class U>
+IntervalNodeT<T, U>* IntervalTree<T, U>::getRoot() const {
+
+	return root;
+
+}
+
+// HELPER FUNCTION: copies every node in tree (pre-order traversal),
+// recursion depth is bounded by the height of the tree
+// USED BY: copy constructor, overloaded assignment operator
+template <class T, class U>
+IntervalNodeT<T, U>* IntervalTree<T, U>::copy(IntervalNodeT<T, U>* nd, IntervalNodeT<T, U>* newParent) {
+
+	if (nd == nullptr) {
+		return nullptr;
+	}
+
+	IntervalNodeT<T, U>* newNode = new IntervalNodeT<T, U>(nd->low, nd->high, nd->value);
+	newNode->maxEnd = nd->maxEnd;
+	newNode->isBlack = nd->isBlack;
+	newNode->parent = newParent;
+	newNode->left = copy(nd->left, newNode);
+	newNode->right = copy(nd->right, newNode);
+	return newNode;
+
+}
+
+// HELPER FUNCTION: deallocates every node under nd (post-order traversal)
+// USED BY: destructor, overloaded assignment operator
+template <class T, class U>
+void IntervalTree<T, U>::clear(IntervalNodeT<T, U>* nd) {
+
+	if (nd == nullptr) {
+		return;
+	}
+
+	clear(nd->left);
+	clear(nd->right);
+	delete nd;
+
+}
+
+// HELPER FUNCTION: orders intervals by low endpoint, breaking ties by high endpoint
+// USED BY: insert(), findNode()
+template <class T, class U>
+bool IntervalTree<T, U>::intervalLess(const T& lowA, const T& highA, const T& lowB, const T& highB) {
+
+	return lowA < lowB || (!(lowB < lowA) && highA < highB);
+
+}
+
+// HELPER FUNCTION: checks the colour of nd, NULL children are black
+// USED BY: insertFix(), removeFix()
+template <class T, class U>
+bool IntervalTree<T, U>::isBlackNode(IntervalNodeT<T, U>* nd) {
+
+	return nd == nullptr || nd->isBlack;
+
+}
+
+// HELPER FUNCTION: finds the left-most node under nd
+// USED BY: remove()
+template <class T, class U>
+IntervalNodeT<T, U>* IntervalTree<T, U>::minimum(IntervalNodeT<T, U>* nd) {
+
+	while (nd->left != nullptr) {
+		nd = nd->left;
+	}
+
+	return nd;
+
+}
+
+// HELPER FUNCTION: recomputes maxEnd of nd from its own interval and its children
+// USED BY: remove(), leftRotate(), rightRotate()
+template <class T, class U>
+void IntervalTree<T, U>::updateMax(IntervalNodeT<T, U>* nd) {
+
+	nd->maxEnd = nd->high;
+
+	if (nd->left != nullptr && nd->maxEnd < nd->left->maxEnd) {
+		nd->maxEnd = nd->left->maxEnd;
+	}
+
+	if (nd->right != nullptr && nd->maxEnd < nd->right->maxEnd) {
+		nd->maxEnd = nd->right->maxEnd;
+	}
+}
+
+// HELPER FUNCTION: finds the node holding [lowP, highP], or NULL
+// USED BY: remove(), search()
+template <class T, class U>
+IntervalNodeT<T, U>* IntervalTree<T, U>::findNode(const T& lowP, const T& highP) const {
+
+	IntervalNodeT<T, U>* current = root; // iterator
+
+	while (current != nullptr) {
+
+		if (intervalLess(lowP, highP, current->low, current->high)) {
+			current = current->left;
+		}
+
+		else if (intervalLess(current->low, current->high, lowP, highP)) {
+			current = current->right;
+		}
+
+		else {
+			return current;
+		}
+
+	}
+
+	return nullptr;
+
+}
+
+// HELPER FUNCTION: replaces the sub-tree rooted at oldNode with the one rooted at newNode
+// USED BY: remove()
+template <class T, class U>
+void IntervalTree<T, U>::transplant(IntervalNodeT<T, U>* oldNode, IntervalNodeT<T, U>* newNode) {
+
+	if (oldNode->parent == nullptr) {
+		root = newNode;
+	}
+
+	else if (oldNode == oldNode->parent->left) {
+		oldNode->parent->left = newNode;
+	}
+
+	else {
+		oldNode->parent->right = newNode;
+	}
+
+	if (newNode != nullptr) {
+		newNode->parent = oldNode->parent;
+	}
+}
+
+// HELPER FUNCTION: recolours and rotates until no red node has a red parent
+// USED BY: insert()
+template <class T, class U>
+void IntervalTree<T, U>::insertFix(IntervalNodeT<T, U>* nd) {
+
+	// while nd is not the root and its parent is red
+	while (nd != root && !nd->parent->isBlack) {
+
+		IntervalNodeT<T, U>* grandparent = nd->parent->parent; // red parent is never the root
+
+		// if nd's parent is a left child
+		if (nd->parent == grandparent->left) {
+
+			IntervalNodeT<T, U>* uncle = grandparent->right;
+
+			// if uncle is red, recolour and move up
+			if (!isBlackNode(uncle)) {
+				nd->parent->isBlack = true;
+				uncle->isBlack = true;
+				grandparent->isBlack = false;
+				nd = grandparent;
+			}
+
+			// if uncle is black, rotate
+			else {
+
+				if (nd == nd->parent->right) {
+					nd = nd->parent;
+					leftRotate(nd);
+				}
+
+				nd->parent->isBlack = true;
+				grandparent->isBlack = false;
+				rightRotate(grandparent);
+
+			}
+		}
+
+		// if nd's parent is a right child (symmetric)
+		else {
+
+			IntervalNodeT<T, U>* uncle = grandparent->left;
+
+			if (!isBlackNode(uncle)) {
+				nd->parent->isBlack = true;
+				uncle->isBlack = true;
+				grandparent->isBlack = false;
+				nd = grandparent;
+			}
+
+			else {
+
+				if (nd == nd->parent->left) {
+					nd = nd->parent;
+					rightRotate(nd);
+				}
+
+				nd->parent->isBlack = true;
+				grandparent->isBlack = false;
+				leftRotate(grandparent);
+
+			}
+		}
+	}
+
+	root->isBlack = true;
+
+}
+
+// HELPER FUNCTION: pushes the extra black carried by nd (possibly NULL, so its
+// parent is passed too) up the tree or absorbs it with rotations
+// USED BY: remove()
+template <class T, class U>
+void IntervalTree<T, U>::removeFix(IntervalNodeT<T, U>* nd, IntervalNodeT<T, U>* parent) {
+
+	while (nd != root && isBlackNode(nd)) {
+
+		// if nd is a left child
+		if (nd == parent->left) {
+
+			IntervalNodeT<T, U>* sibling = parent->right; // never NULL, it has black height >= 1
+
+			// if sibling is red, rotate so that it becomes black
+			if (!sibling->isBlack) {
+				sibling->isBlack = true;
+				parent->isBlack = false;
+				leftRotate(parent);
+				sibling = parent->right;
+			}
+
+			// if both of sibling's children are black, move the extra black up
+			if (isBlackNode(sibling->left) && isBlackNode(sibling->right)) {
+				sibling->isBlack = false;
+				nd = parent;
+				parent = nd->parent;
+			}
+
+			else {
+
+				// make sibling's far child red
+				if (isBlackNode(sibling->right)) {
+					sibling->left->isBlack = true;
+					sibling->isBlack = false;
+					rightRotate(sibling);
+					sibling = parent->right;
+				}
+
+				sibling->isBlack = parent->isBlack;
+				parent->isBlack = true;
+				sibling->right->isBlack = true;
+				leftRotate(parent);
+				nd = root;
+
+			}
+		}
+
+		// if nd is a right child (symmetric)
+		else {
+
+			IntervalNodeT<T, U>* sibling = parent->left;
+
+			if (!sibling->isBlack) {
+				sibling->isBlack = true;
+				parent->isBlack = false;
+				rightRotate(parent);
+				sibling = parent->left;
+			}
+
+			if (isBlackNode(sibling->left) && isBlackNode(sibling->right)) {
+				sibling->isBlack = false;
+				nd = parent;
+				parent = nd->parent;
+			}
+
+			else {
+
+				if (isBlackNode(sibling->left)) {
+					sibling->right->isBlack = true;
+					sibling->isBlack = false;
+					leftRotate(sibling);
+					sibling = parent->left;
+				}
+
+				sibling->isBlack = parent->isBlack;
+				parent->isBlack = true;
+				sibling->left->isBlack = true;
+				rightRotate(parent);
+				nd = root;
+
+			}
+		}
+	}
+
+	if (nd != nullptr) {
+		nd->isBlack = true;
+	}
+}
+
+// HELPER FUNCTION: performs left rotation on nd; the rotated pair covers the
+// same intervals as before, so only their two maxEnd fields change
+// USED BY: insertFix(), removeFix()
+template <class T, class U>
+void IntervalTree<T, U>::leftRotate(IntervalNodeT<T, U>* nd) {
+
+	IntervalNodeT<T, U>* pivot = nd->right; // becomes the root of this sub-tree
+
+	nd->right = pivot->left;
+
+	if (pivot->left != nullptr) {
+		pivot->left->parent = nd;
+	}
+
+	transplant(nd, pivot);
+	pivot->left = nd;
+	nd->parent = pivot;
+
+	pivot->maxEnd = nd->maxEnd;
+	updateMax(nd);
+
+}
+
+// HELPER FUNCTION: performs right rotation on nd; the rotated pair covers the
+// same intervals as before, so only their two maxEnd fields change
+// USED BY: insertFix(), removeFix()
+template <class T, class U>
+void IntervalTree<T, U>::rightRotate(IntervalNodeT<T, U>* nd) {
+
+	IntervalNodeT<T, U>* pivot = nd->left; // becomes the root of this sub-tree
+
+	nd->left = pivot->right;
+
+	if (pivot->right != nullptr) {
+		pivot->right->parent = nd;
+	}
+
+	transplant(nd, pivot);
+	pivot->right = nd;
+	nd->parent = pivot;
+
+	pivot->maxEnd = nd->maxEnd;
+	updateMax(nd);
+
+}
@@ -0,0 +1,564 @@
+/*
+PersistentRedBlackTree.h
+
+Persistent (immutable) Red-Black Tree template class that implements an
+Ordered Map
+
+insert() and remove() leave the calling tree unchanged and return a new
+version. The new version copies only the nodes on (or next to) the search
+path and shares every other subtree with the old version, so each update
+costs O(log n) time and memory and copying a version costs O(1). Nodes are
+reference counted and freed once no version refers to them.
+
+Nodes have no parent pointers, since a shared subtree has a parent in every
+version that holds it, so the bottom-up fix-ups of RedBlackTree.h, which climb
+parent links, cannot be used. The left-leaning variant rebalances on the way
+back out of the recursion instead: each rotation or colour flip changes a node
+that the recursion has just copied, or one of its children, which is copied
+first. Each node records the update that created it, so a node copied once by
+an update is changed in place by that update's later rotations rather than
+copied again.
+
+Authour: Fitz Laddaran
+Contact: fitzladdaran@gmail.com
+Last Updated: 27/08/2020
+*/
+
+#pragma once
+#include <atomic>
+#include <memory>
+#include <vector>
+
+using std::shared_ptr;
+using std::vector;
+
+template <class T, class U>
+class PersistentNodeT {
+
+public:
+
+	T key; // unique value, occurs only once in tree
+	U value; // associated value with key, non-unique
+	shared_ptr<PersistentNodeT<T, U>> left; // left child pointer
+	shared_ptr<PersistentNodeT<T, U>> right; // right child pointer
+	bool isBlack; // checks the colour of a node
+	unsigned long version; // update that created this node, only it may modify the node
+
+	// constructor
+	PersistentNodeT(const T& data1, const U& data2, unsigned long ver) :
+		key(data1), value(data2) {
+		isBlack = false;
+		version = ver;
+	}
+
+};
+
+template <class T, class U>
+class PersistentRedBlackTree {
+
+public:
+
+	PersistentRedBlackTree(); // constructor, an empty version
+
+	// returns a version with key inserted, if key is not present
+	// otherwise returns this version
+	PersistentRedBlackTree insert(const T& keyP, const U& valueP) const;
+
+	// returns a version with key removed, if key is present
+	// otherwise returns this version
+	PersistentRedBlackTree remove(const T& keyP) const;
+
+	// search this version to see if key matches any of the nodes
+	bool search(const T& keyP) const;
+
+	// returns all values whose keys are between keyP1 - keyP2
+	// based on ascending order of keys
+	vector<U> search(const T& keyP1, const T& keyP2) const;
+
+	// returns all values in this version
+	// based on ascending order of keys
+	vector<U> values() const;
+
+	// returns all keys in this version
+	vector<T> keys() const;
+
+	// returns number of items stored in this version
+	int size() const;
+
+private:
+
+	typedef PersistentNodeT<T, U> Node;
+	typedef shared_ptr<Node> NodePtr;
+
+	PersistentRedBlackTree(const NodePtr& rootP, int sizeP); // wraps a new version
+
+	// attributes
+	NodePtr root; // pointer to version's root
+	int currSize; // size of version
+
+	// helper functions
+	static unsigned long nextVersion(); // unique stamp for one update
+	static bool find(const Node* nd, const T& keyP); // iterative search
+	static NodePtr mutableNode(const NodePtr& nd, unsigned long ver); // copies nd unless created by this update
+	static NodePtr insert(const NodePtr& nd, const T& keyP, const U& valueP, unsigned long ver); // recursive insert
+	static NodePtr remove(NodePtr nd, const T& keyP, unsigned long ver); // recursive remove
+	static NodePtr removeMin(NodePtr nd, unsigned long ver); // removes the smallest node under nd
+	static NodePtr rotateLeft(const NodePtr& nd, unsigned long ver); // left rotation on nd
+	static NodePtr rotateRight(const NodePtr& nd, unsigned long ver); // right rotation on nd
+	static void flipColours(const NodePtr& nd, unsigned long ver); // flips colour of nd and its children
+	static NodePtr moveRedLeft(NodePtr nd, unsigned long ver); // makes nd->left or one of its children red
+	static NodePtr moveRedRight(NodePtr nd, unsigned long ver); // makes nd->right or one of its children red
+	static NodePtr balance(NodePtr nd, unsigned long ver); // restores left-leaning invariants on the way up
+	static bool isRed(const NodePtr& nd); // NULL nodes are black
+	static void inOrderSearch(const Node* nd, vector<U>& myVect, const T& low, const T& high); // in-order traversal for search()
+	static void inOrderValues(const Node* nd, vector<U>& myVect); // in-order traversal for values()
+	static void inOrderKeys(const Node* nd, vector<T>& myVect); // in-order traversal for keys()
+
+};
+
+// constructor
+template <class T, class U>
+PersistentRedBlackTree<T, U>::PersistentRedBlackTree() {
+
+	currSize = 0;
+
+}
+
+// constructor, wraps the root of a new version
+template <class T, class U>
+PersistentRedBlackTree<T, U>::PersistentRedBlackTree(const NodePtr& rootP, int sizeP) {
+
+	root = rootP;
+	currSize = sizeP;
+
+}
+
+// returns a new version with key inserted if key is not in this version,
+// otherwise returns this version without insertion
+template <class T, class U>
+PersistentRedBlackTree<T, U> PersistentRedBlackTree<T, U>::insert(const T& keyP, const U& valueP) const {
+
+	// if keyP is found, then nothing needs to be copied
+	if (find(root.get(), keyP)) {
+		return *this;
+	}
+
+	unsigned long ver = nextVersion();
+	NodePtr newRoot = insert(root, keyP, valueP, ver);
+	newRoot->isBlack = true;
+	return PersistentRedBlackTree(newRoot, currSize + 1);
+
+}
+
+// returns a new version with key removed if key is in this version,
+// otherwise returns this version without removal
+template <class T, class U>
+PersistentRedBlackTree<T, U> PersistentRedBlackTree<T, U>::remove(const T& keyP) const {
+
+	// if keyP is not found, then nothing needs to be copied
+	if (!find(root.get(), keyP)) {
+		return *this;
+	}
+
+	unsigned long ver = nextVersion();
+	NodePtr current = root;
+
+	// if both children of root are black, set root to red
+	if (!isRed(current->left) && !isRed(current->right)) {
+		current = mutableNode(current, ver);
+		current->isBlack = false;
+	}
+
+	NodePtr newRoot = remove(current, keyP, ver);
+
+	if (newRoot) {
+		newRoot->isBlack = true;
+	}
+
+	return PersistentRedBlackTree(newRoot, currSize - 1);
+
+}
+
+// search this version to see if key matches any node's key
+// return true if found, otherwise false
+template <class T, class U>
+bool PersistentRedBlackTree<T, U>::search(const T& keyP) const {
+
+	return find(root.get(), keyP);
+
+}
+
+// returns a vector containing all values whose keys are between
+// keyP1 - keyP2, based on ascending key order
+template <class T, class U>
+vector<U> PersistentRedBlackTree<T, U>::search(const T& keyP1, const T& keyP2) const {
+
+	vector<U> myVect;
+
+	// bounds may be given in either order
+	if (keyP2 < keyP1) {
+		inOrderSearch(root.get(), myVect, keyP2, keyP1);
+	}
+
+	else {
+		inOrderSearch(root.get(), myVect, keyP1, keyP2);
+	}
+
+	return myVect;
+
+}
+
+// returns a vector containing all values in ascending key order
+// if tree is empty, vector is also empty
+template <class T, class U>
+vector<U> PersistentRedBlackTree<T, U>::values() const {
+
+	vector<U> myVect;
+	myVect.reserve(currSize);
+	inOrderValues(root.get(), myVect);
+	return myVect;
+
+}
+
+// returns a vector containing all keys in ascending order
+// if tree is empty, vector is also empty
+template <class T, class U>
+vector<T> PersistentRedBlackTree<T, U>::keys() const {
+
+	vector<T> myVect;
+	myVect.reserve(currSize);
+	inOrderKeys(root.get(), myVect);
+	return myVect;
+
+}
+
+// returns the number of items stored in this version
+template <class T, class U>
+int PersistentRedBlackTree<T, U>::size() const {
+
+	return currSize;
+
+}
+
+// HELPER FUNCTION: returns a stamp no other update has used,
+// so versions may be updated from several threads at once
+// USED BY: insert(), remove()
+template <class T, class U>
+unsigned long PersistentRedBlackTree<T, U>::nextVersion() {
+
+	static std::atomic<unsigned long> counter(0);
+	return ++counter;
+
+}
+
+// HELPER FUNCTION: iterative search from nd
+// USED BY: insert(), remove(), search()
+template <class T, class U>
+bool PersistentRedBlackTree<T, U>::find(const Node* nd, const T& keyP) {
+
+	while (nd != nullptr) {
+
+		if (keyP == nd->key) {
+			return true;
+		}
+
+		nd = (keyP < nd->key) ? nd->left.get() : nd->right.get();
+
+	}
+
+	return false;
+
+}
+
+// HELPER FUNCTION: returns a node that the current update may modify;
+// a node shared with other versions is copied, its children stay shared
+// USED BY: update helpers
+template <class T, class U>
+typename PersistentRedBlackTree<T, U>::NodePtr PersistentRedBlackTree<T, U>::mutableNode(const NodePtr& nd, unsigned long ver) {
+
+	// created by this update, so no other version refers to it
+	if (nd->version == ver) {
+		return nd;
+	}
+
+	NodePtr newNode = std::make_shared<Node>(nd->key, nd->value, ver);
+	newNode->left = nd->left;
+	newNode->right = nd->right;
+	newNode->isBlack = nd->isBlack;
+	return newNode;
+
+}
+
+// HELPER FUNCTION: recursive insert, copying every node on the path
+// USED BY: insert()
+template <class T, class U>
+typename PersistentRedBlackTree<T, U>::NodePtr PersistentRedBlackTree<T, U>::insert(const NodePtr& nd, const T& keyP, const U& valueP, unsigned long ver) {
+
+	// new nodes are red
+	if (!nd) {
+		return std::make_shared<Node>(keyP, valueP, ver);
+	}
+
+	NodePtr current = mutableNode(nd, ver);
+
+	if (keyP < current->key) {
+		current->left = insert(current->left, keyP, valueP, ver);
+	}
+
+	else {
+		current->right = insert(current->right, keyP, valueP, ver);
+	}
+
+	// lean left, split temporary 4-nodes
+	if (isRed(current->right) && !isRed(current->left)) {
+		current = rotateLeft(current, ver);
+	}
+
+	if (isRed(current->left) && isRed(current->left->left)) {
+		current = rotateRight(current, ver);
+	}
+
+	if (isRed(current->left) && isRed(current->right)) {
+		flipColours(current, ver);
+	}
+
+	return current;
+
+}
+
+// HELPER FUNCTION: recursive remove, keyP must be present under nd
+// USED BY: remove()
+template <class T, class U>
+typename PersistentRedBlackTree<T, U>::NodePtr PersistentRedBlackTree<T, U>::remove(NodePtr nd, const T& keyP, unsigned long ver) {
+
+	nd = mutableNode(nd, ver);
+
+	// keyP is in the left subtree
+	if (keyP < nd->key) {
+
+		if (!isRed(nd->left) && !isRed(nd->left->left)) {
+			nd = moveRedLeft(nd, ver);
+		}
+
+		nd->left = remove(nd->left, keyP, ver);
+
+	}
+
+	// keyP is this node or in the right subtree
+	else {
+
+		if (isRed(nd->left)) {
+			nd = rotateRight(nd, ver);
+		}
+
+		// keyP is at the bottom of the tree
+		if (keyP == nd->key && !nd->right) {
+			return NodePtr();
+		}
+
+		if (!isRed(nd->right) && !isRed(nd->right->left)) {
+			nd = moveRedRight(nd, ver);
+		}
+
+		// replace with the successor, then remove the successor
+		if (keyP == nd->key) {
+
+			const Node* successor = nd->right.get();
+
+			while (successor->left) {
+				successor = successor->left.get();
+			}
+
+			nd->key = successor->key;
+			nd->value = successor->value;
+			nd->right = removeMin(nd->right, ver);
+
+		}
+
+		else {
+			nd->right = remove(nd->right, keyP, ver);
+		}
+	}
+
+	return balance(nd, ver);
+
+}
+
+// HELPER FUNCTION: removes the smallest node under nd
+// USED BY: remove()
+template <class T, class U>
+typename PersistentRedBlackTree<T, U>::NodePtr PersistentRedBlackTree<T, U>::removeMin(NodePtr nd, unsigned long ver) {
+
+	// the smallest node has no children in a left-leaning tree
+	if (!nd->left) {
+		return NodePtr();
+	}
+
+	nd = mutableNode(nd, ver);
+
+	if (!isRed(nd->left) && !isRed(nd->left->left)) {
+		nd = moveRedLeft(nd, ver);
+	}
+
+	nd->left = removeMin(nd->left, ver);
+	return balance(nd, ver);
+
+}
+
+// HELPER FUNCTION: left-rotate on nd, nd must already be mutable
+// USED BY: insert(), moveRedLeft(), balance()
+template <class T, class U>
+typename PersistentRedBlackTree<T, U>::NodePtr PersistentRedBlackTree<T, U>::rotateLeft(const NodePtr& nd, unsigned long ver) {
+
+	NodePtr newParent = mutableNode(nd->right, ver); // nd's soon-to-be new parent
+	nd->right = newParent->left;
+	newParent->left = nd;
+	newParent->isBlack = nd->isBlack;
+	nd->isBlack = false;
+	return newParent;
+
+}
+
+// HELPER FUNCTION: right-rotate on nd, nd must already be mutable
+// USED BY: insert(), remove(), moveRedLeft(), moveRedRight(), balance()
+template <class T, class U>
+typename PersistentRedBlackTree<T, U>::NodePtr PersistentRedBlackTree<T, U>::rotateRight(const NodePtr& nd, unsigned long ver) {
+
+	NodePtr newParent = mutableNode(nd->left, ver); // nd's soon-to-be new parent
+	nd->left = newParent->right;
+	newParent->right = nd;
+	newParent->isBlack = nd->isBlack;
+	nd->isBlack = false;
+	return newParent;
+
+}
+
+// HELPER FUNCTION: flips the colour of nd and both of its children
+// USED BY: insert(), moveRedLeft(), moveRedRight(), balance()
+template <class T, class U>
+void PersistentRedBlackTree<T, U>::flipColours(const NodePtr& nd, unsigned long ver) {
+
+	nd->left = mutableNode(nd->left, ver);
+	nd->right = mutableNode(nd->right, ver);
+	nd->isBlack = !nd->isBlack;
+	nd->left->isBlack = !nd->left->isBlack;
+	nd->right->isBlack = !nd->right->isBlack;
+
+}
+
+// HELPER FUNCTION: makes nd->left or one of its children red before descending left
+// USED BY: remove(), removeMin()
+template <class T, class U>
+typename PersistentRedBlackTree<T, U>::NodePtr PersistentRedBlackTree<T, U>::moveRedLeft(NodePtr nd, unsigned long ver) {
+
+	flipColours(nd, ver);
+
+	if (isRed(nd->right->left)) {
+		nd->right = rotateRight(nd->right, ver);
+		nd = rotateLeft(nd, ver);
+		flipColours(nd, ver);
+	}
+
+	return nd;
+
+}
+
+// HELPER FUNCTION: makes nd->right or one of its children red before descending right
+// USED BY: remove()
+template <class T, class U>
+typename PersistentRedBlackTree<T, U>::NodePtr PersistentRedBlackTree<T, U>::moveRedRight(NodePtr nd, unsigned long ver) {
+
+	flipColours(nd, ver);
+
+	if (isRed(nd->left->left)) {
+		nd = rotateRight(nd, ver);
+		flipColours(nd, ver);
+	}
+
+	return nd;
+
+}
+
+// HELPER FUNCTION: restores left-leaning invariants on the way back up
+// USED BY: remove(), removeMin()
+template <class T, class U>
+typename PersistentRedBlackTree<T, U>::NodePtr PersistentRedBlackTree<T, U>::balance(NodePtr nd, unsigned long ver) {
+
+	if (isRed(nd->right) && !isRed(nd->left)) {
+		nd = rotateLeft(nd, ver);
+	}
+
+	if (isRed(nd->left) && isRed(nd->left->left)) {
+		nd = rotateRight(nd, ver);
+	}
+
+	if (isRed(nd->left) && isRed(nd->right)) {
+		flipColours(nd, ver);
+	}
+
+	return nd;
+
+}
+
+// HELPER FUNCTION: checks the colour of a node, NULL nodes are black
+// USED BY: update helpers
+template <class T, class U>
+bool PersistentRedBlackTree<T, U>::isRed(const NodePtr& nd) {
+
+	return nd && !nd->isBlack;
+
+}
+
+// HELPER FUNCTION: in-order traversal for search(T keyP1, T keyP2),
+// skipping subtrees that lie outside low - high
+// USED BY: search(T keyP1, T keyP2)
+template <class T, class U>
+void PersistentRedBlackTree<T, U>::inOrderSearch(const Node* nd, vector<U>& myVect, const T& low, const T& high) {
+
+	if (nd != nullptr) {
+
+		if (low < nd->key) {
+			inOrderSearch(nd->left.get(), myVect, low, high);
+		}
+
+		if (!(nd->key < low) && !(high < nd->key)) {
+			myVect.push_back(nd->value);
+		}
+
+		if (nd->key < high) {
+			inOrderSearch(nd->right.get(), myVect, low, high);
+		}
+
+	}
+
+}
+
+// HELPER FUNCTION: in-order traversal for values()
+// USED BY: values()
+template <class T, class U>
+void PersistentRedBlackTree<T, U>::inOrderValues(const Node* nd, vector<U>& myVect) {
+
+	if (nd != nullptr) {
+
+		inOrderValues(nd->left.get(), myVect);
+		myVect.push_back(nd->value);
+		inOrderValues(nd->right.get(), myVect);
+
+	}
+
+}
+
+// HELPER FUNCTION: in-order traversal for keys()
+// USED BY: keys()
+template <class T, class U>
+void PersistentRedBlackTree<T, U>::inOrderKeys(const Node* nd, vector<T>& myVect) {
+
+	if (nd != nullptr) {
+
+		inOrderKeys(nd->left.get(), myVect);
+		myVect.push_back(nd->key);
+		inOrderKeys(nd->right.get(), myVect);
+
+	}
+
+}
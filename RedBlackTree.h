@@ -10,18 +10,49 @@ Last Updated: 27/08/2020
 
 #pragma once
 #include <vector>
+#include <utility>
+#include <functional>
+#include <type_traits>
+#include <future>
+#include <thread>
 #include <iostream>
 
 using std::cout;
 using std::endl;
 using std::vector;
+using std::pair;
+
+// hints the CPU to start loading addr into cache, no-op on other compilers
+#if defined(__GNUC__) || defined(__clang__)
+#define RBT_PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define RBT_PREFETCH(addr) ((void)0)
+#endif
+
+// counts an event in statistics builds (compiled with -DRBTREE_STATS), no-op otherwise
+#ifdef RBTREE_STATS
+#define RBT_STAT(expr) ((void)(expr))
+#else
+#define RBT_STAT(expr) ((void)0)
+#endif
+
+#ifdef RBTREE_STATS
+// operation counters of one RedBlackTree, gathered only in statistics builds
+struct RedBlackTreeStats {
+	unsigned long comparisons = 0; // key comparisons
+	unsigned long rotations = 0; // left and right rotations
+	unsigned long insertFixups = 0; // iterations of the insertion fix loop
+	unsigned long removeFixups = 0; // iterations of the removal fix loop (rbFix)
+	unsigned long allocations = 0; // nodes allocated
+};
+#endif
 
 template <class T, class U>
 class NodeT {
 	
 public:
 
-	T key; // unique value, occurs only once in tree
+	T key; // unique value, occurs only once in tree unless the tree allows duplicates
 	U value; // associated value with key, non-unique
 	NodeT<T, U>* left; // left child pointer
 	NodeT<T, U>* right; // right child pointer
@@ -29,7 +60,7 @@ public:
 	bool isBlack; // checks the colour of a node
 
 	// constructor
-	NodeT(T data1, U data2) { 
+	NodeT(const T& data1, const U& data2) { 
 		key = data1;
 		value = data2;
 		left = nullptr;
@@ -40,28 +71,73 @@ public:
 
 };
 
-template <class T, class U>
+// checks if comparator C offers a three-way compare(a, b) returning <0, 0 or >0
+template <class C, class A, class B, class = void>
+struct HasThreeWayCompare : std::false_type {};
+
+template <class C, class A, class B>
+struct HasThreeWayCompare<C, A, B, decltype((void)std::declval<const C&>().compare(std::declval<const A&>(), std::declval<const B&>()))> : std::true_type {};
+
+// keys are ordered by Compare, a strict weak ordering (std::less<T> by default),
+// two keys are equal when neither is less than the other
+template <class T, class U, class Compare = std::less<T>>
 class RedBlackTree {
 
 public: 
 
+	// lazy in-order iterator, visits one node per increment without allocating
+	class Iterator {
+
+	public:
+
+		Iterator(NodeT<T, U>* nd); // iterator positioned at nd (NULL is end)
+		const NodeT<T, U>& operator*() const; // current node
+		const NodeT<T, U>* operator->() const; // current node
+		Iterator& operator++(); // advances to the next key in ascending order
+		bool operator==(const Iterator& other) const;
+		bool operator!=(const Iterator& other) const;
+
+	private:
+
+		NodeT<T, U>* current; // current node, NULL once past the last key
+
+	};
+
 	RedBlackTree(); // constructor
+	explicit RedBlackTree(const Compare& compP); // constructor with a comparator object
+	explicit RedBlackTree(bool allowDuplicatesP, const Compare& compP = Compare()); // constructor choosing the duplicate-key mode
 	RedBlackTree(const RedBlackTree& rbTree); // copy constructor
 	RedBlackTree& operator=(const RedBlackTree& rbTree); // overloaded assignment operator
 	~RedBlackTree(); // destructor
 
 	// inserts a node, if key is not present in R-B Tree
-	bool insert(const T keyP, const U valueP);
+	// if duplicates are allowed, always inserts, after any nodes with an equal key
+	bool insert(const T& keyP, const U& valueP);
 
 	// removes a node, if key is present in R-B Tree
-	bool remove(const T keyP);
+	// if duplicates are allowed, removes the first node with an equal key
+	bool remove(const T& keyP);
 
 	// search R-B Tree to see if key matches any of the nodes
-	bool search(const T keyP) const; 
+	bool search(const T& keyP) const; 
+
+	// searches by any key type the comparator can compare against T,
+	// available only if Compare declares is_transparent (e.g. std::less<>)
+	template <class K, class C = Compare, class = typename C::is_transparent>
+	bool search(const K& keyP) const;
 
 	// returns all values whose keys are between keyP1 - keyP2
 	// based on ascending order of keys
-	vector<U> search(const T keyP1, const T keyP2) const;
+	vector<U> search(const T& keyP1, const T& keyP2) const;
+
+	// looks up n keys at once, interleaving their descents to overlap cache misses
+	// found[i] tells if keysP[i] is present, and if so outValues[i] holds its value
+	// returns the number of keys found
+	int searchBatch(const T* keysP, int n, U* outValues, bool* found) const;
+
+	// looks up every key at once, outValues is resized to match keysP
+	// returns, per key, whether it is present
+	vector<bool> searchBatch(const vector<T>& keysP, vector<U>& outValues) const;
 
 	// returns all values in the tree
 	// based on ascending order of keys
@@ -70,60 +146,199 @@ public:
 	// returns all keys in the tree
 	vector<T> keys() const;
 
+	// returns all key-value pairs in the tree
+	// based on ascending order of keys
+	vector<pair<T, U>> items() const;
+
+	// iterators over the tree in ascending order of keys
+	Iterator begin() const;
+	Iterator end() const;
+
+	// iterator to the first key that is not less than keyP, or end()
+	Iterator lowerBound(const T& keyP) const;
+
+	// iterator to the first key that is greater than keyP, or end()
+	Iterator upperBound(const T& keyP) const;
+
+	// iterators spanning every node whose key equals keyP, in insertion order
+	pair<Iterator, Iterator> equalRange(const T& keyP) const;
+
+	// returns the number of nodes whose key equals keyP
+	int count(const T& keyP) const;
+
+	// checks if the tree keeps nodes with equal keys
+	bool allowsDuplicates() const;
+
+	// replaces the tree's contents with n key-value pairs in linear time,
+	// keys must be in strictly ascending order (non-descending if duplicates are allowed)
+	bool buildFromSorted(const T* keysP, const U* valuesP, int n);
+
+	// moves every key less than keyP into lessTree and every other key into
+	// greaterTree in O(log n) restructuring, leaving this tree empty,
+	// both halves take this tree's duplicate-key mode
+	// returns true if keyP was present (it goes to greaterTree)
+	bool split(const T& keyP, RedBlackTree& lessTree, RedBlackTree& greaterTree);
+
+	// replaces the tree's contents with lessTree, keyP and greaterTree, emptying both,
+	// every key of lessTree must be < keyP < every key of greaterTree
+	// (<= if duplicates are allowed), otherwise returns false without changing any tree
+	bool join(RedBlackTree& lessTree, const T& keyP, const U& valueP, RedBlackTree& greaterTree);
+
+	// adds every key of rbTree, keeping this tree's value for keys present in both
+	// if duplicates are allowed, keeps every node of both trees
+	void unionWith(const RedBlackTree& rbTree);
+	void unionWith(RedBlackTree&& rbTree); // reuses rbTree's nodes, leaving it empty
+
+	// keeps only the keys also present in rbTree
+	// if duplicates are allowed, keeps as many nodes per key as the smaller count of the two trees
+	void intersectWith(const RedBlackTree& rbTree);
+	void intersectWith(RedBlackTree&& rbTree); // leaves rbTree empty
+
+	// removes every key present in rbTree
+	// if duplicates are allowed, removes one node per node of rbTree with an equal key
+	void subtract(const RedBlackTree& rbTree);
+	void subtract(RedBlackTree&& rbTree); // leaves rbTree empty
+
 	// returns number of items stored in the tree
-	int size();
+	int size() const;
 
 	// returns a pointer to tree's root node
 	NodeT<T, U>* getRoot() const;
 
+	// returns a copy of the comparator ordering the keys
+	Compare keyComp() const;
+
+	// returns the number of nodes on the longest path from the root down to a leaf
+	int maxDepth() const;
+
+	// returns the average number of nodes on the paths from the root to every node
+	double averageDepth() const;
+
+	// returns the number of black nodes on any path from the root down to a leaf
+	int blackHeight() const;
+
+	// checks parent links, key order, size and every R-B Tree property,
+	// for debug builds and fuzz tests; returns false at the first violation
+	bool validate() const;
+
+#ifdef RBTREE_STATS
+	// returns the operation counters gathered since construction or resetStats(),
+	// counters are not synchronised, so gather them from one thread at a time
+	RedBlackTreeStats getStats() const;
+
+	// zeroes the operation counters
+	void resetStats();
+#endif
+
 	// in-order print
 	void inOrderPrint();
 
 private:
 
+	// number of descents searchBatch() keeps in flight
+	static const int BATCH_GROUP = 16;
+
+	// set operations on fewer keys than this run on the calling thread only
+	static const int PARALLEL_MIN_SIZE = 1 << 16;
+
+	// a sub-tree cut out of a tree by split(), join() and the set operations,
+	// its root is black and has no parent; carrying the black height along
+	// spares every join a walk down the tree to measure it
+	struct SubTree {
+		NodeT<T, U>* nd; // root of the sub-tree, NULL if empty
+		int height; // black nodes on any path from nd down to a leaf
+	};
+
 	// attributes
 	NodeT<T, U>* root; // pointer to tree's root
 	int currSize; // size of tree
+	Compare comp; // orders the keys
+	bool allowDuplicates; // checks if insert() keeps nodes with equal keys
+#ifdef RBTREE_STATS
+	mutable RedBlackTreeStats stats; // operation counters, statistics builds only
+#endif
 
 	// helper functions 
 	NodeT<T, U>* copy(NodeT<T, U>* nd, NodeT<T, U>* & newParent); // deep copy every node in the tree
 	void clear(); // deallocates memory and sets root to NULL
-	void clear(NodeT<T, U>* nd); // deallocates dynamic memory
-	NodeT<T, U>* BSTinsert(const T keyP, const U valueP); // BST Insert method
+	static void clear(NodeT<T, U>* nd); // deallocates dynamic memory
+	template <class A, class B> bool keyLess(const A& keyA, const B& keyB) const; // compares two keys with comp
+	template <class K> NodeT<T, U>* findNode(const K& keyP) const; // finds the node holding keyP
+	NodeT<T, U>* lowerBoundNode(const T& keyP) const; // finds the first node whose key is not less than keyP
+	NodeT<T, U>* upperBoundNode(const T& keyP) const; // finds the first node whose key is greater than keyP
+	void mergeDuplicates(RedBlackTree& rbTree, bool keepCommon); // multiset intersection or difference by a sorted merge
+	template <class K> NodeT<T, U>* findNode(const K& keyP, std::true_type threeWay) const; // findNode() with compare()
+	template <class K> NodeT<T, U>* findNode(const K& keyP, std::false_type threeWay) const; // findNode() with Compare alone
+	NodeT<T, U>* BSTinsert(const T& keyP, const U& valueP); // BST Insert method
 	NodeT<T, U>* predecessor(NodeT<T, U>* nd) const; // finds the predecessor 
+	static NodeT<T, U>* minimum(NodeT<T, U>* nd); // finds the left-most node under nd
+	static NodeT<T, U>* successor(NodeT<T, U>* nd); // finds the in-order successor using parent pointers
+	void insertFix(NodeT<T, U>* newNode); // RB Tree Fix algorithm after an insertion
 	void rbFix(NodeT<T, U>* nd, bool isLeafCheck); // RB Tree Fix algorithm
+	static SubTree wholeTree(NodeT<T, U>* nd); // wraps a tree's root, counting its black height
+	static SubTree childTree(NodeT<T, U>* child, int parentHeight); // cuts a child off its black parent
+	SubTree joinNodes(SubTree lessPart, NodeT<T, U>* mid, SubTree greaterPart) const; // joins two sub-trees around mid
+	SubTree joinNodes(SubTree lessPart, SubTree greaterPart) const; // joins two sub-trees without a middle node
+	void splitNodes(SubTree part, const T& keyP, SubTree& lessPart, NodeT<T, U>* & mid, SubTree& greaterPart) const; // splits a sub-tree around keyP
+	SubTree unionNodes(SubTree part, SubTree other, int& dropped, int levels) const; // union of two sub-trees
+	SubTree intersectNodes(SubTree part, SubTree other, int& dropped, int levels) const; // intersection of two sub-trees
+	SubTree subtractNodes(SubTree part, SubTree other, int& dropped, int levels) const; // difference of two sub-trees
+	int parallelLevels(int total) const; // levels of recursion that may fork a thread
+	int countSmaller(NodeT<T, U>* nd, NodeT<T, U>* other, int total) const; // counts nd's sub-tree in O(min) steps
 	int size(NodeT<T, U>* nd) const; // counts the number of nodes in the tree
 	bool empty() const; // checks if the tree is empty or not
 	void leftRotate(NodeT<T, U>* newNode); // left rotation on newNode
 	void rightRotate(NodeT<T, U>* newNode); // right rotation on newNode
-	void inOrderSearch(NodeT<T, U>* nd, vector<U>& myVect, const T keyP1, const T keyP2) const; // in-order traversal for search()
-	void inOrderValues(NodeT<T, U>* nd, vector<U>& myVect) const; // in-order traversal for values()
-	void inOrderKeys(NodeT<T, U>* nd, vector<T>& myVect) const; // in-order traversal for keys()
+	void inOrderSearch(NodeT<T, U>* nd, vector<U>& myVect, const T& keyP1, const T& keyP2) const; // in-order traversal for search()
 	void inOrderP(NodeT<T, U>* nd); // in-order print
+	NodeT<T, U>* buildSorted(const T* keysP, const U* valuesP, int low, int high, int depth, int redDepth, NodeT<T, U>* parent); // builds a balanced sub-tree
 
 };
 
 // constructor
-template <class T, class U>
-RedBlackTree<T, U>::RedBlackTree() {
+template <class T, class U, class Compare>
+RedBlackTree<T, U, Compare>::RedBlackTree() {
+
+	root = nullptr;
+	currSize = 0;
+	allowDuplicates = false;
+
+}
+
+// constructor with a comparator object, for comparators that carry state
+template <class T, class U, class Compare>
+RedBlackTree<T, U, Compare>::RedBlackTree(const Compare& compP) : comp(compP) {
+
+	root = nullptr;
+	currSize = 0;
+	allowDuplicates = false;
+
+}
+
+// constructor choosing whether insert() keeps nodes with equal keys (a multimap)
+template <class T, class U, class Compare>
+RedBlackTree<T, U, Compare>::RedBlackTree(bool allowDuplicatesP, const Compare& compP) : comp(compP) {
 
 	root = nullptr;
 	currSize = 0;
+	allowDuplicates = allowDuplicatesP;
 
 }
 
 // copy constructor
-template <class T, class U>
-RedBlackTree<T, U>::RedBlackTree(const RedBlackTree& rbTree) {
+template <class T, class U, class Compare>
+RedBlackTree<T, U, Compare>::RedBlackTree(const RedBlackTree& rbTree) : comp(rbTree.comp) {
 
 	NodeT<T, U>* newParent = nullptr;
 	root = copy(rbTree.root, newParent);
+	currSize = rbTree.currSize;
+	allowDuplicates = rbTree.allowDuplicates;
 
 }
 
 // overloaded assignment operator
-template <class T, class U>
-RedBlackTree<T, U>& RedBlackTree<T, U>::operator=(const RedBlackTree& rbTree)
+template <class T, class U, class Compare>
+RedBlackTree<T, U, Compare>& RedBlackTree<T, U, Compare>::operator=(const RedBlackTree& rbTree)
 {
 
 	/*
@@ -140,6 +355,9 @@ RedBlackTree<T, U>& RedBlackTree<T, U>::operator=(const RedBlackTree& rbTree)
 		// deep copy
 		NodeT<T, U>* newParent = nullptr;
 		root = copy(rbTree.root, newParent);
+		currSize = rbTree.currSize;
+		comp = rbTree.comp;
+		allowDuplicates = rbTree.allowDuplicates;
 
 	}
 
@@ -149,8 +367,8 @@ RedBlackTree<T, U>& RedBlackTree<T, U>::operator=(const RedBlackTree& rbTree)
 }
 
 // destructor
-template <class T, class U>
-RedBlackTree<T, U>::~RedBlackTree() {
+template <class T, class U, class Compare>
+RedBlackTree<T, U, Compare>::~RedBlackTree() {
 
 	clear();
 
@@ -158,11 +376,11 @@ RedBlackTree<T, U>::~RedBlackTree() {
 
 // inserts node if key is not in R-B Tree and return true
 // otherwise return false without insertion
-template <class T, class U>
-bool RedBlackTree<T, U>::insert(const T keyP, const U valueP) {
+template <class T, class U, class Compare>
+bool RedBlackTree<T, U, Compare>::insert(const T& keyP, const U& valueP) {
 
 	// if keyP is found, then return false without insertion 
-	if (search(keyP)) {
+	if (!allowDuplicates && findNode(keyP) != nullptr) {
 		return false;
 	}
 
@@ -170,77 +388,9 @@ bool RedBlackTree<T, U>::insert(const T keyP, const U valueP) {
 	else {
 
 		NodeT<T, U>* newNode = BSTinsert(keyP, valueP); // pointer to inserted node
+		currSize++;
 
-		// while newNode is not the root and its parents are red
-		while (newNode != root && newNode->parent->isBlack == false) {
-
-			// if newNode's parent is a left child
-			if (newNode->parent == newNode->parent->parent->left) {
-
-				// uncle of newNode, sibling of newNode's parents
-				NodeT<T, U>* uncle = newNode->parent->parent->right;
-
-				// if uncle is red (ensure it is not NULL to have a colour)
-				if (uncle != nullptr && uncle->isBlack == false) {
-
-					newNode->parent->isBlack = true;
-					uncle->isBlack = true;
-					newNode->parent->parent->isBlack = false;
-					newNode = newNode->parent->parent;
-
-				}
-
-				// if uncle is NULL (hence it has a black colour)
-				else {
-
-					if (newNode == newNode->parent->right) {
-
-						newNode = newNode->parent;
-						leftRotate(newNode);
-
-					}
-
-					newNode->parent->isBlack = true;
-					newNode->parent->parent->isBlack = false;
-					rightRotate(newNode->parent->parent);
-
-				}
-			}
-
-			// if newNode's parent is a right child
-			else {
-
-				// uncle of newNode, sibling of newNode's parents
-				NodeT<T, U>* uncle = newNode->parent->parent->left;
-
-				// if uncle is red (ensure it is not NULL to have a colour)
-				if (uncle != nullptr && uncle->isBlack == false) {
-
-					newNode->parent->isBlack = true;
-					uncle->isBlack = true;
-					newNode->parent->parent->isBlack = false;
-					newNode = newNode->parent->parent;
-
-				}
-
-				// if uncle is NULL (hence it has a black colour)
-				else {
-
-					if (newNode == newNode->parent->left) {
-
-						newNode = newNode->parent;
-						rightRotate(newNode);
-
-					}
-
-					newNode->parent->isBlack = true;
-					newNode->parent->parent->isBlack = false;
-					leftRotate(newNode->parent->parent);
-
-				}
-			}
-		}
-
+		insertFix(newNode);
 		root->isBlack = true;
 		return true;
 
@@ -249,42 +399,19 @@ bool RedBlackTree<T, U>::insert(const T keyP, const U valueP) {
 
 // removes a node if key is not in R-B Tree and return true
 // otherwise return false without removal
-template <class T, class U>
-bool RedBlackTree<T, U>::remove(const T keyP) {
+template <class T, class U, class Compare>
+bool RedBlackTree<T, U, Compare>::remove(const T& keyP) {
 
-	NodeT<T, U>* current = root; // iterator
+	// among equal keys, remove the first one
+	NodeT<T, U>* current = allowDuplicates ? lowerBoundNode(keyP) : findNode(keyP); // node holding keyP
 
-	// if tree is empty
-	if (root == nullptr) {
-		return false; 
+	if (allowDuplicates && current != nullptr && keyLess(keyP, current->key)) {
+		current = nullptr;
 	}
 
-	// iterate through tree
-	while (current->key != keyP) {
-
-		// if keyP is not found, then return false without removal
-
-		// descend left child
-		if (keyP < current->key) {
-
-			if (current->left == nullptr) {
-				return false;
-			}
-
-			current = current->left;
-
-		}
-
-		// descend right child
-		else {
-
-			if (current->right == nullptr) {
-				return false;
-			}
-
-			current = current->right;
-
-		}
+	// if keyP is not found, then return false without removal
+	if (current == nullptr) {
+		return false; 
 	}
 
 	// keyP is found, therefore return true after removal 
@@ -309,6 +436,7 @@ bool RedBlackTree<T, U>::remove(const T keyP) {
 	if (ndRemove->left == nullptr && ndRemove->right == nullptr) {
 
 		ndRemoveChild = new NodeT<T, U>(current->key, current->value); // initialize object for NULL node
+		RBT_STAT(stats.allocations++);
 		ndRemoveChild->isBlack = true; // NULL has a black colour
 		isLeaf = true; // ndRemove is a leaf
 
@@ -384,214 +512,1058 @@ bool RedBlackTree<T, U>::remove(const T keyP) {
 		// therefore eliminating all relationships with the RB Tree
 		ndRemoveChild->parent = nullptr;
 		delete ndRemoveChild; // delete temporary node
+		delete ndRemove; // delete physical node removed
 	} 
 
 	else {
 		delete ndRemove; // delete physical node removed
 	}
 
+	currSize--;
 	return true;
 
 }
 
 // search R-B Tree to see if key matches any node's key
 // return true if found, otherwise false
-template <class T, class U>
-bool RedBlackTree<T, U>::search(const T keyP) const {
+template <class T, class U, class Compare>
+bool RedBlackTree<T, U, Compare>::search(const T& keyP) const {
 
-	NodeT<T, U>* current = root; // iterator
+	return findNode(keyP) != nullptr;
 
-	// loop until iterator is NULL
-	while (current != nullptr) {
+}
 
-		// if key-parameter = current's key
-		if (keyP == current->key) {
-			return true;
-		}
+// search R-B Tree with a key of another type, e.g. a string_view
+// against string keys, without constructing a T
+template <class T, class U, class Compare>
+template <class K, class C, class>
+bool RedBlackTree<T, U, Compare>::search(const K& keyP) const {
 
-		// if key-parameter < current's key
-		if (keyP < current->key) {
-			current = current->left;
-		}
+	return findNode(keyP) != nullptr;
 
-		// if key-parameter > current's key
-		else {
-			current = current->right;
+}
+
+// returns a vector containing all values whose keys are between 
+// keyP1 - keyP2, based on ascending key order
+template <class T, class U, class Compare>
+vector<U> RedBlackTree<T, U, Compare>::search(const T& keyP1, const T& keyP2) const {
+
+	vector<U> myVect;
+	inOrderSearch(root, myVect, keyP1, keyP2);
+	return myVect;
+
+}
+
+// looks up keys in groups of BATCH_GROUP, advancing every descent in the group
+// by one level per round and prefetching the next node, so the cache misses of
+// different keys overlap instead of stalling one after another
+template <class T, class U, class Compare>
+int RedBlackTree<T, U, Compare>::searchBatch(const T* keysP, int n, U* outValues, bool* found) const {
+
+	int foundCount = 0; // counter: number of keys found
+
+	for (int start = 0; start < n; start += BATCH_GROUP) {
+
+		NodeT<T, U>* current[BATCH_GROUP]; // next node to visit for each key in the group
+		NodeT<T, U>* candidate[BATCH_GROUP]; // deepest node passed whose key is <= the searched key
+		int lanes[BATCH_GROUP]; // keys of the group whose descent is unfinished
+		int active = (n - start < BATCH_GROUP) ? n - start : BATCH_GROUP;
+
+		for (int i = 0; i < active; ++i) {
+			current[i] = root;
+			candidate[i] = nullptr;
+			lanes[i] = i;
+			found[start + i] = false;
 		}
 
+		// one round moves every unfinished descent down one level
+		while (active > 0) {
+
+			int lane = 0;
+
+			while (lane < active) {
+
+				int i = lanes[lane];
+				NodeT<T, U>* nd = current[i];
+				const T& key = keysP[start + i];
+
+				// at the bottom, key is present only if it equals the candidate
+				if (nd == nullptr) {
+
+					NodeT<T, U>* match = candidate[i];
+
+					if (match != nullptr && !keyLess(match->key, key)) {
+						outValues[start + i] = match->value;
+						found[start + i] = true;
+						foundCount++;
+					}
+
+					lanes[lane] = lanes[--active];
+					continue;
+
+				}
+
+				// one comparison per level, equality is settled at the bottom
+				if (keyLess(key, nd->key)) {
+					nd = nd->left;
+				}
+
+				else {
+					candidate[i] = nd;
+					nd = nd->right;
+				}
+
+				RBT_PREFETCH(nd);
+				current[i] = nd;
+				lane++;
+
+			}
+		}
 	}
 
-	// if key is not found
-	return false;
+	return foundCount;
 
 }
 
-// returns a vector containing all values whose keys are between 
-// keyP1 - keyP2, based on ascending key order
-template <class T, class U>
-vector<U> RedBlackTree<T, U>::search(const T keyP1, const T keyP2) const {
+// looks up every key of keysP at once
+// returns a vector telling, per key, whether it was found
+template <class T, class U, class Compare>
+vector<bool> RedBlackTree<T, U, Compare>::searchBatch(const vector<T>& keysP, vector<U>& outValues) const {
 
-	vector<U> myVect;
-	inOrderSearch(root, myVect, keyP1, keyP2);
+	int n = (int)keysP.size();
+	bool* found = new bool[n > 0 ? n : 1]; // vector<bool> can't hand out a bool array
+	outValues.resize(n);
+
+	searchBatch(keysP.data(), n, outValues.data(), found);
+
+	vector<bool> myVect(found, found + n);
+	delete[] found;
 	return myVect;
 
 }
 
 // returns a vector containing all values in ascending key oder
 // if tree is empty, vector is also empty
-template <class T, class U>
-vector<U> RedBlackTree<T, U>::values() const {
+template <class T, class U, class Compare>
+vector<U> RedBlackTree<T, U, Compare>::values() const {
 
 	vector<U> myVect;
-	inOrderValues(root, myVect);
+	myVect.reserve(currSize);
+
+	// walk successors from the left-most node
+	for (NodeT<T, U>* nd = minimum(root); nd != nullptr; nd = successor(nd)) {
+		myVect.push_back(nd->value);
+	}
+
 	return myVect;
 
 }
 
 // returns a vector containing all keys in ascending order
 // if tree is empty, vector is also empty
-template <class T, class U>
-vector<T> RedBlackTree<T, U>::keys() const {
+template <class T, class U, class Compare>
+vector<T> RedBlackTree<T, U, Compare>::keys() const {
 
 	vector<T> myVect;
-	inOrderKeys(root, myVect);
+	myVect.reserve(currSize);
+
+	// walk successors from the left-most node
+	for (NodeT<T, U>* nd = minimum(root); nd != nullptr; nd = successor(nd)) {
+		myVect.push_back(nd->key);
+	}
+
 	return myVect;
 
 }
 
-// returns the number of items stored in the tree
-template <class T, class U>
-int RedBlackTree<T, U>::size() {
+// returns a vector containing all key-value pairs in ascending key order,
+// collected in a single pass
+// if tree is empty, vector is also empty
+template <class T, class U, class Compare>
+vector<pair<T, U>> RedBlackTree<T, U, Compare>::items() const {
 
-	NodeT<T, U>* current = root; // iterator
+	vector<pair<T, U>> myVect;
+	myVect.reserve(currSize);
 
-	if (current == nullptr) {
-		currSize = 0;
+	// walk successors from the left-most node
+	for (NodeT<T, U>* nd = minimum(root); nd != nullptr; nd = successor(nd)) {
+		myVect.push_back(pair<T, U>(nd->key, nd->value));
 	}
 
-	else {
-		currSize = size(current);
-	}
+	return myVect;
 
-	return currSize;
 }
 
-// returns a pointer to the root
-template <class T, class U>
-NodeT<T, U>* RedBlackTree<T, U>::getRoot() const {
-	
-	return root;
+// returns an iterator at the smallest key
+template <class T, class U, class Compare>
+typename RedBlackTree<T, U, Compare>::Iterator RedBlackTree<T, U, Compare>::begin() const {
+
+	return Iterator(minimum(root));
 
 }
 
-// HELPER FUNCTION: copies every node in tree (pre-order traversal)
-// USED BY: copy constructor, overloaded assignment operator
-template <class T, class U>
-NodeT<T, U>* RedBlackTree<T, U>::copy(NodeT<T, U>* nd, NodeT<T, U>*& newParent) {
+// returns an iterator past the largest key
+template <class T, class U, class Compare>
+typename RedBlackTree<T, U, Compare>::Iterator RedBlackTree<T, U, Compare>::end() const {
 
-	// if node is not NULL
-	if (nd != nullptr) {
+	return Iterator(nullptr);
 
-		NodeT<T, U>* newNode = new NodeT<T, U>(nd->key, nd->value); // create new node for parameter node
-		newNode->isBlack = nd->isBlack; // copy colour attribute
-		newNode->parent = newParent; // copy parent attribute
-		newNode->left = copy(nd->left, newNode); // recursively copy left descendants 
-		newNode->right = copy(nd->right, newNode); // recursively copy right descendants 
-		return newNode;
+}
 
-	}
+// returns an iterator to the first key that is not less than keyP
+template <class T, class U, class Compare>
+typename RedBlackTree<T, U, Compare>::Iterator RedBlackTree<T, U, Compare>::lowerBound(const T& keyP) const {
+
+	return Iterator(lowerBoundNode(keyP));
 
-	// if node is NULL
-	return nullptr;
 }
 
-// HELPER FUNCTION: calls clear(NodeT* nd), and sets root = NULL
-// USED BY: destructor, overloaded assignment operator 
-template <class T, class U>
-void RedBlackTree<T, U>::clear() {
+// returns an iterator to the first key that is greater than keyP
+template <class T, class U, class Compare>
+typename RedBlackTree<T, U, Compare>::Iterator RedBlackTree<T, U, Compare>::upperBound(const T& keyP) const {
 
-	clear(root);
-	root = nullptr;
+	return Iterator(upperBoundNode(keyP));
 
 }
 
-// HELPER FUNCTION: removes all nodes and deallocates dynamic memory for every node
-// USED BY: clear()
-template <class T, class U>
-void RedBlackTree<T, U>::clear(NodeT<T, U>* nd) {
+// returns the iterators [first, last) over every node whose key equals keyP,
+// empty (first == last) if keyP is not present
+template <class T, class U, class Compare>
+pair<typename RedBlackTree<T, U, Compare>::Iterator, typename RedBlackTree<T, U, Compare>::Iterator> RedBlackTree<T, U, Compare>::equalRange(const T& keyP) const {
 
-	// if node is not NULL
-	if (nd != nullptr) {
+	NodeT<T, U>* first = lowerBoundNode(keyP);
+
+	// a unique key spans at most one node
+	if (!allowDuplicates) {
+
+		if (first == nullptr || keyLess(keyP, first->key)) {
+			return pair<Iterator, Iterator>(Iterator(first), Iterator(first));
+		}
 
-		clear(nd->left); // recursively check if there's a left descendant
-		clear(nd->right); // recursively check if there's a right descendant
-		delete nd; // if no descendants, delete current node
+		return pair<Iterator, Iterator>(Iterator(first), Iterator(successor(first)));
 
 	}
 
+	return pair<Iterator, Iterator>(Iterator(first), Iterator(upperBoundNode(keyP)));
+
 }
 
-// HELPER FUNCTION: inserts a node in the appropriate location in a tree
-// USED BY: insert()
-template <class T, class U>
-NodeT<T, U>* RedBlackTree<T, U>::BSTinsert(const T keyP, const U valueP) {
+// returns the number of nodes whose key equals keyP
+template <class T, class U, class Compare>
+int RedBlackTree<T, U, Compare>::count(const T& keyP) const {
 
-	NodeT<T, U>* newNode = new NodeT<T, U>(keyP, valueP); // create new node
-	NodeT<T, U>* parent = root; // keep track of parent of the node we want to insert
-	NodeT<T, U>* next = root; // to determine what is ahead of current node
+	int total = 0; // counter: nodes with an equal key
+	pair<Iterator, Iterator> range = equalRange(keyP);
 
-	// if tree is empty
-	if (empty()) {
-		root = newNode;
+	for (Iterator it = range.first; it != range.second; ++it) {
+		total++;
 	}
 
-	// if tree is not empty
-	else {
-
-		// finding parent of new node
-		while (next != nullptr) {
+	return total;
 
-			parent = next; // keep track of parent
+}
 
-			// descend left-subtree
-			if (keyP < parent->key) {
-				next = parent->left;
-			}
+// checks if the tree keeps nodes with equal keys
+template <class T, class U, class Compare>
+bool RedBlackTree<T, U, Compare>::allowsDuplicates() const {
 
-			// descend right-subtree
-			else {
-				next = parent->right;
-			}
+	return allowDuplicates;
 
-		}
+}
 
-		// insert new node
-		if (keyP < parent->key) {
+// replaces the tree's contents with a balanced tree built from sorted arrays,
+// returns false without changing the tree if keys are not strictly ascending
+template <class T, class U, class Compare>
+bool RedBlackTree<T, U, Compare>::buildFromSorted(const T* keysP, const U* valuesP, int n) {
 
-			parent->left = newNode; // left-child
-			newNode->parent = parent; // new node's parent is matched
+	for (int i = 1; i < n; ++i) {
 
+		// equal neighbours are allowed only in duplicate-key mode
+		if (allowDuplicates ? keyLess(keysP[i], keysP[i - 1]) : !keyLess(keysP[i - 1], keysP[i])) {
+			return false;
 		}
 
-		else {
+	}
 
-			parent->right = newNode; // right-child
-			newNode->parent = parent; // new node's parent is matched
+	clear();
 
-		}
+	// if there's nothing to build
+	if (n <= 0) {
+		return true;
+	}
 
+	// depth of the deepest (possibly partial) level; its nodes are red,
+	// which keeps the number of black nodes equal on every path
+	int redDepth = 0;
+
+	while ((2 << redDepth) <= n) {
+		redDepth++;
 	}
 
-	return newNode;
-}
+	root = buildSorted(keysP, valuesP, 0, n - 1, 0, redDepth, nullptr);
+	root->isBlack = true;
+	currSize = n;
+	return true;
 
-// HELPER FUNCTION: finds the predecessor 
-// USED BY: remove()
-template <class T, class U>
-NodeT<T, U>* RedBlackTree<T, U>::predecessor(NodeT<T, U>* nd) const {
+}
 
-	// enter left sub-tree
-	nd = nd->left;
+// moves keys less than keyP into lessTree and the rest into greaterTree,
+// both trees' previous contents are deallocated
+template <class T, class U, class Compare>
+bool RedBlackTree<T, U, Compare>::split(const T& keyP, RedBlackTree& lessTree, RedBlackTree& greaterTree) {
+
+	// the two halves need two distinct trees
+	if (&lessTree == &greaterTree) {
+		return false;
+	}
+
+	NodeT<T, U>* nd = root; // take the nodes first, this tree may be one of the halves
+	int total = currSize;
+	root = nullptr;
+	currSize = 0;
+
+	lessTree.clear();
+	greaterTree.clear();
+	lessTree.allowDuplicates = allowDuplicates;
+	greaterTree.allowDuplicates = allowDuplicates;
+
+	SubTree lessPart;
+	SubTree greaterPart;
+	NodeT<T, U>* mid = nullptr;
+	splitNodes(wholeTree(nd), keyP, lessPart, mid, greaterPart);
+
+	// keyP is the smallest key of greaterTree
+	if (mid != nullptr) {
+		SubTree empty = { nullptr, 0 };
+		greaterPart = joinNodes(empty, mid, greaterPart);
+	}
+
+	lessTree.root = lessPart.nd;
+	lessTree.currSize = countSmaller(lessPart.nd, greaterPart.nd, total);
+	greaterTree.root = greaterPart.nd;
+	greaterTree.currSize = total - lessTree.currSize;
+
+	// with duplicates the split keeps equal keys together, so look at greaterTree's smallest
+	if (allowDuplicates) {
+		return greaterPart.nd != nullptr && !keyLess(keyP, minimum(greaterPart.nd)->key);
+	}
+
+	return mid != nullptr;
+
+}
+
+// joins lessTree, a new node for keyP and greaterTree into this tree
+template <class T, class U, class Compare>
+bool RedBlackTree<T, U, Compare>::join(RedBlackTree& lessTree, const T& keyP, const U& valueP, RedBlackTree& greaterTree) {
+
+	// the two halves need two distinct trees
+	if (&lessTree == &greaterTree && lessTree.root != nullptr) {
+		return false;
+	}
+
+	NodeT<T, U>* largest = lessTree.root; // right-most node of lessTree
+
+	while (largest != nullptr && largest->right != nullptr) {
+		largest = largest->right;
+	}
+
+	// keys must be ordered lessTree < keyP < greaterTree
+	if (!allowDuplicates && ((largest != nullptr && !keyLess(largest->key, keyP)) ||
+		(greaterTree.root != nullptr && !keyLess(keyP, minimum(greaterTree.root)->key)))) {
+		return false;
+	}
+
+	// or lessTree <= keyP <= greaterTree if duplicates are allowed
+	if (allowDuplicates && ((largest != nullptr && keyLess(keyP, largest->key)) ||
+		(greaterTree.root != nullptr && keyLess(minimum(greaterTree.root)->key, keyP)))) {
+		return false;
+	}
+
+	NodeT<T, U>* lessNd = lessTree.root; // take the nodes first, this tree may be one of the halves
+	NodeT<T, U>* greaterNd = greaterTree.root;
+	int total = lessTree.currSize + greaterTree.currSize + 1;
+	lessTree.root = nullptr;
+	lessTree.currSize = 0;
+	greaterTree.root = nullptr;
+	greaterTree.currSize = 0;
+
+	clear();
+	RBT_STAT(stats.allocations++);
+	root = joinNodes(wholeTree(lessNd), new NodeT<T, U>(keyP, valueP), wholeTree(greaterNd)).nd;
+	currSize = total;
+	return true;
+
+}
+
+// adds a copy of every key of rbTree
+template <class T, class U, class Compare>
+void RedBlackTree<T, U, Compare>::unionWith(const RedBlackTree& rbTree) {
+
+	RedBlackTree other(rbTree);
+	unionWith(static_cast<RedBlackTree&&>(other));
+
+}
+
+// splits rbTree around this tree's keys and joins the pieces back, the two
+// halves of each split are combined on separate threads near the top
+template <class T, class U, class Compare>
+void RedBlackTree<T, U, Compare>::unionWith(RedBlackTree&& rbTree) {
+
+	// union with itself changes nothing, unless it doubles every key of a multimap
+	if (&rbTree == this && !allowDuplicates) {
+		return;
+	}
+
+	// rbTree's own equal keys would survive the split-based union, insert one by one
+	if (rbTree.allowDuplicates && !allowDuplicates) {
+
+		for (Iterator it = rbTree.begin(); it != rbTree.end(); ++it) {
+			insert(it->key, it->value);
+		}
+
+		rbTree.clear();
+		return;
+
+	}
+
+	// a multimap united with itself needs a copy to split
+	if (&rbTree == this) {
+		RedBlackTree other(rbTree);
+		unionWith(static_cast<RedBlackTree&&>(other));
+		return;
+	}
+
+	int total = currSize + rbTree.currSize;
+	int dropped = 0; // counter: nodes deallocated as duplicates
+	NodeT<T, U>* other = rbTree.root;
+	rbTree.root = nullptr;
+	rbTree.currSize = 0;
+
+	root = unionNodes(wholeTree(root), wholeTree(other), dropped, parallelLevels(total)).nd;
+	currSize = total - dropped;
+
+}
+
+// keeps the keys also in a copy of rbTree
+template <class T, class U, class Compare>
+void RedBlackTree<T, U, Compare>::intersectWith(const RedBlackTree& rbTree) {
+
+	// intersection with itself changes nothing
+	if (&rbTree == this) {
+		return;
+	}
+
+	RedBlackTree other(rbTree);
+	intersectWith(static_cast<RedBlackTree&&>(other));
+
+}
+
+// keeps the keys also in rbTree, deallocating every other node of both trees
+template <class T, class U, class Compare>
+void RedBlackTree<T, U, Compare>::intersectWith(RedBlackTree&& rbTree) {
+
+	// intersection with itself changes nothing
+	if (&rbTree == this) {
+		return;
+	}
+
+	// counts of equal keys matter, which the split-based intersection ignores
+	if (allowDuplicates) {
+		mergeDuplicates(rbTree, true);
+		return;
+	}
+
+	int total = currSize + rbTree.currSize;
+	int dropped = 0; // counter: nodes deallocated
+	NodeT<T, U>* other = rbTree.root;
+	rbTree.root = nullptr;
+	rbTree.currSize = 0;
+
+	root = intersectNodes(wholeTree(root), wholeTree(other), dropped, parallelLevels(total)).nd;
+	currSize = total - dropped;
+
+}
+
+// removes the keys of a copy of rbTree
+template <class T, class U, class Compare>
+void RedBlackTree<T, U, Compare>::subtract(const RedBlackTree& rbTree) {
+
+	// every key is removed
+	if (&rbTree == this) {
+		clear();
+		return;
+	}
+
+	RedBlackTree other(rbTree);
+	subtract(static_cast<RedBlackTree&&>(other));
+
+}
+
+// removes the keys of rbTree, deallocating every node of rbTree
+template <class T, class U, class Compare>
+void RedBlackTree<T, U, Compare>::subtract(RedBlackTree&& rbTree) {
+
+	// every key is removed
+	if (&rbTree == this) {
+		clear();
+		return;
+	}
+
+	// counts of equal keys matter, which the split-based difference ignores
+	if (allowDuplicates) {
+		mergeDuplicates(rbTree, false);
+		return;
+	}
+
+	int total = currSize + rbTree.currSize;
+	int dropped = 0; // counter: nodes deallocated
+	NodeT<T, U>* other = rbTree.root;
+	rbTree.root = nullptr;
+	rbTree.currSize = 0;
+
+	root = subtractNodes(wholeTree(root), wholeTree(other), dropped, parallelLevels(total)).nd;
+	currSize = total - dropped;
+
+}
+
+// returns the number of items stored in the tree
+template <class T, class U, class Compare>
+int RedBlackTree<T, U, Compare>::size() const {
+
+	return currSize;
+
+}
+
+// returns a pointer to the root
+template <class T, class U, class Compare>
+NodeT<T, U>* RedBlackTree<T, U, Compare>::getRoot() const {
+	
+	return root;
+
+}
+
+// returns the comparator ordering the keys
+template <class T, class U, class Compare>
+Compare RedBlackTree<T, U, Compare>::keyComp() const {
+
+	return comp;
+
+}
+
+// returns the depth of the deepest node, counting the root as depth 1
+template <class T, class U, class Compare>
+int RedBlackTree<T, U, Compare>::maxDepth() const {
+
+	int deepest = 0;
+	vector<pair<NodeT<T, U>*, int>> pending; // nodes still to visit, with their depths
+
+	if (root != nullptr) {
+		pending.push_back(pair<NodeT<T, U>*, int>(root, 1));
+	}
+
+	while (!pending.empty()) {
+
+		pair<NodeT<T, U>*, int> top = pending.back();
+		pending.pop_back();
+
+		if (top.second > deepest) {
+			deepest = top.second;
+		}
+
+		if (top.first->left != nullptr) {
+			pending.push_back(pair<NodeT<T, U>*, int>(top.first->left, top.second + 1));
+		}
+
+		if (top.first->right != nullptr) {
+			pending.push_back(pair<NodeT<T, U>*, int>(top.first->right, top.second + 1));
+		}
+
+	}
+
+	return deepest;
+
+}
+
+// returns the mean depth of all nodes, the average cost of a successful search
+template <class T, class U, class Compare>
+double RedBlackTree<T, U, Compare>::averageDepth() const {
+
+	double depthSum = 0;
+	int nodes = 0;
+	vector<pair<NodeT<T, U>*, int>> pending; // nodes still to visit, with their depths
+
+	if (root != nullptr) {
+		pending.push_back(pair<NodeT<T, U>*, int>(root, 1));
+	}
+
+	while (!pending.empty()) {
+
+		pair<NodeT<T, U>*, int> top = pending.back();
+		pending.pop_back();
+		depthSum += top.second;
+		nodes++;
+
+		if (top.first->left != nullptr) {
+			pending.push_back(pair<NodeT<T, U>*, int>(top.first->left, top.second + 1));
+		}
+
+		if (top.first->right != nullptr) {
+			pending.push_back(pair<NodeT<T, U>*, int>(top.first->right, top.second + 1));
+		}
+
+	}
+
+	return (nodes == 0) ? 0 : depthSum / nodes;
+
+}
+
+// returns the black height of the root, counted down the left spine
+template <class T, class U, class Compare>
+int RedBlackTree<T, U, Compare>::blackHeight() const {
+
+	return wholeTree(root).height;
+
+}
+
+// walks every node once, checking its links and colours and the black
+// height of every leaf, then walks the keys in order to check their order
+template <class T, class U, class Compare>
+bool RedBlackTree<T, U, Compare>::validate() const {
+
+	// root must be black and parentless
+	if (root != nullptr && (!root->isBlack || root->parent != nullptr)) {
+		return false;
+	}
+
+	int height = blackHeight();
+	int nodes = 0;
+	vector<pair<NodeT<T, U>*, int>> pending; // nodes still to visit, with the black nodes above them
+
+	if (root != nullptr) {
+		pending.push_back(pair<NodeT<T, U>*, int>(root, 0));
+	}
+
+	while (!pending.empty()) {
+
+		NodeT<T, U>* nd = pending.back().first;
+		int blacks = pending.back().second + (nd->isBlack ? 1 : 0);
+		pending.pop_back();
+		nodes++;
+
+		NodeT<T, U>* children[2] = { nd->left, nd->right };
+
+		for (int i = 0; i < 2; ++i) {
+
+			// a missing child ends a path, which must hold as many black nodes as any other
+			if (children[i] == nullptr) {
+
+				if (blacks != height) {
+					return false;
+				}
+
+				continue;
+
+			}
+
+			// child must point back to nd, and a red node has no red child
+			if (children[i]->parent != nd || (!nd->isBlack && !children[i]->isBlack)) {
+				return false;
+			}
+
+			pending.push_back(pair<NodeT<T, U>*, int>(children[i], blacks));
+
+		}
+	}
+
+	if (nodes != currSize) {
+		return false;
+	}
+
+	// keys must ascend, strictly unless duplicates are allowed
+	for (NodeT<T, U>* nd = minimum(root); nd != nullptr; nd = successor(nd)) {
+
+		NodeT<T, U>* next = successor(nd);
+
+		if (next != nullptr && (allowDuplicates ? keyLess(next->key, nd->key) : !keyLess(nd->key, next->key))) {
+			return false;
+		}
+
+	}
+
+	return true;
+
+}
+
+#ifdef RBTREE_STATS
+// returns a copy of the operation counters
+template <class T, class U, class Compare>
+RedBlackTreeStats RedBlackTree<T, U, Compare>::getStats() const {
+
+	return stats;
+
+}
+
+// zeroes the operation counters
+template <class T, class U, class Compare>
+void RedBlackTree<T, U, Compare>::resetStats() {
+
+	stats = RedBlackTreeStats();
+
+}
+#endif
+
+// HELPER FUNCTION: copies every node in tree (pre-order traversal),
+// walking the source with parent pointers while building the copy in lockstep
+// USED BY: copy constructor, overloaded assignment operator
+template <class T, class U, class Compare>
+NodeT<T, U>* RedBlackTree<T, U, Compare>::copy(NodeT<T, U>* nd, NodeT<T, U>*& newParent) {
+
+	// if node is NULL
+	if (nd == nullptr) {
+		return nullptr;
+	}
+
+	NodeT<T, U>* newRoot = new NodeT<T, U>(nd->key, nd->value); // create new node for parameter node
+	RBT_STAT(stats.allocations++);
+	newRoot->isBlack = nd->isBlack; // copy colour attribute
+	newRoot->parent = newParent; // copy parent attribute
+
+	NodeT<T, U>* source = nd; // iterator over the original
+	NodeT<T, U>* dest = newRoot; // matching node in the copy
+
+	while (true) {
+
+		// descend into a left child that hasn't been copied yet
+		if (source->left != nullptr && dest->left == nullptr) {
+
+			dest->left = new NodeT<T, U>(source->left->key, source->left->value);
+			RBT_STAT(stats.allocations++);
+			dest->left->isBlack = source->left->isBlack;
+			dest->left->parent = dest;
+			source = source->left;
+			dest = dest->left;
+
+		}
+
+		// descend into a right child that hasn't been copied yet
+		else if (source->right != nullptr && dest->right == nullptr) {
+
+			dest->right = new NodeT<T, U>(source->right->key, source->right->value);
+			RBT_STAT(stats.allocations++);
+			dest->right->isBlack = source->right->isBlack;
+			dest->right->parent = dest;
+			source = source->right;
+			dest = dest->right;
+
+		}
+
+		// both subtrees are copied, climb back up
+		else {
+
+			if (source == nd) {
+				break;
+			}
+
+			source = source->parent;
+			dest = dest->parent;
+
+		}
+	}
+
+	return newRoot;
+}
+
+// HELPER FUNCTION: calls clear(NodeT* nd), and sets root = NULL
+// USED BY: destructor, overloaded assignment operator 
+template <class T, class U, class Compare>
+void RedBlackTree<T, U, Compare>::clear() {
+
+	clear(root);
+	root = nullptr;
+	currSize = 0;
+
+}
+
+// HELPER FUNCTION: removes all nodes and deallocates dynamic memory for every node
+// USED BY: clear(), intersectNodes(), subtractNodes()
+template <class T, class U, class Compare>
+void RedBlackTree<T, U, Compare>::clear(NodeT<T, U>* nd) {
+
+	NodeT<T, U>* top = nd; // subtree root, the last node deleted
+
+	// post-order walk: descend to a leaf, delete it, climb to its parent
+	while (nd != nullptr) {
+
+		if (nd->left != nullptr) {
+			nd = nd->left;
+		}
+
+		else if (nd->right != nullptr) {
+			nd = nd->right;
+		}
+
+		// no descendants, delete current node and detach it from its parent
+		else {
+
+			if (nd == top) {
+				delete nd;
+				break;
+			}
+
+			NodeT<T, U>* parent = nd->parent;
+
+			if (parent->left == nd) {
+				parent->left = nullptr;
+			}
+
+			else {
+				parent->right = nullptr;
+			}
+
+			delete nd;
+			nd = parent;
+
+		}
+	}
+
+}
+
+// HELPER FUNCTION: compares two keys with the tree's comparator, every key
+// comparison goes through here so statistics builds can count them
+// USED BY: every function that orders keys
+template <class T, class U, class Compare>
+template <class A, class B>
+bool RedBlackTree<T, U, Compare>::keyLess(const A& keyA, const B& keyB) const {
+
+	RBT_STAT(stats.comparisons++);
+	return comp(keyA, keyB);
+
+}
+
+// HELPER FUNCTION: finds the node holding keyP, or NULL if key is not present,
+// uses the comparator's compare() when it has one
+// USED BY: insert(), remove(), search()
+template <class T, class U, class Compare>
+template <class K>
+NodeT<T, U>* RedBlackTree<T, U, Compare>::findNode(const K& keyP) const {
+
+	return findNode(keyP, HasThreeWayCompare<Compare, K, T>());
+
+}
+
+// HELPER FUNCTION: descent with a three-way compare(), one call per level
+// that stops as soon as keyP is matched
+// USED BY: findNode(K keyP)
+template <class T, class U, class Compare>
+template <class K>
+NodeT<T, U>* RedBlackTree<T, U, Compare>::findNode(const K& keyP, std::true_type) const {
+
+	NodeT<T, U>* current = root; // iterator
+
+	while (current != nullptr) {
+
+		RBT_STAT(stats.comparisons++);
+		int order = comp.compare(keyP, current->key);
+
+		// if key-parameter = current's key
+		if (order == 0) {
+			return current;
+		}
+
+		current = (order < 0) ? current->left : current->right;
+
+	}
+
+	return nullptr;
+
+}
+
+// HELPER FUNCTION: descent with one comparison per level instead of an equality
+// and a less-than test, remembering the last node whose key is <= keyP;
+// a single comparison at the bottom decides whether that node matches
+// USED BY: findNode(K keyP)
+template <class T, class U, class Compare>
+template <class K>
+NodeT<T, U>* RedBlackTree<T, U, Compare>::findNode(const K& keyP, std::false_type) const {
+
+	NodeT<T, U>* current = root; // iterator
+	NodeT<T, U>* candidate = nullptr; // deepest node passed whose key is <= keyP
+
+	while (current != nullptr) {
+
+		// if key-parameter < current's key
+		if (keyLess(keyP, current->key)) {
+			current = current->left;
+		}
+
+		// if key-parameter >= current's key
+		else {
+			candidate = current;
+			current = current->right;
+		}
+
+	}
+
+	// candidate's key <= keyP, so they are equal unless candidate's key < keyP
+	if (candidate != nullptr && !keyLess(candidate->key, keyP)) {
+		return candidate;
+	}
+
+	return nullptr;
+
+}
+
+// HELPER FUNCTION: finds the first node whose key is not less than keyP, or NULL
+// USED BY: lowerBound(), equalRange(), remove()
+template <class T, class U, class Compare>
+NodeT<T, U>* RedBlackTree<T, U, Compare>::lowerBoundNode(const T& keyP) const {
+
+	NodeT<T, U>* current = root; // iterator
+	NodeT<T, U>* first = nullptr; // smallest node seen whose key is >= keyP
+
+	while (current != nullptr) {
+
+		if (keyLess(current->key, keyP)) {
+			current = current->right;
+		}
+
+		else {
+			first = current;
+			current = current->left;
+		}
+
+	}
+
+	return first;
+
+}
+
+// HELPER FUNCTION: finds the first node whose key is greater than keyP, or NULL
+// USED BY: upperBound(), equalRange()
+template <class T, class U, class Compare>
+NodeT<T, U>* RedBlackTree<T, U, Compare>::upperBoundNode(const T& keyP) const {
+
+	NodeT<T, U>* current = root; // iterator
+	NodeT<T, U>* first = nullptr; // smallest node seen whose key is > keyP
+
+	while (current != nullptr) {
+
+		if (keyLess(keyP, current->key)) {
+			first = current;
+			current = current->left;
+		}
+
+		else {
+			current = current->right;
+		}
+
+	}
+
+	return first;
+
+}
+
+// HELPER FUNCTION: multiset intersection (keepCommon) or difference of this tree
+// and rbTree by one sorted merge of both, pairing each node of rbTree with at most
+// one equal node of this tree; the kept pairs are rebuilt into a balanced tree
+// USED BY: intersectWith(), subtract()
+template <class T, class U, class Compare>
+void RedBlackTree<T, U, Compare>::mergeDuplicates(RedBlackTree& rbTree, bool keepCommon) {
+
+	vector<T> keptKeys;
+	vector<U> keptValues;
+	keptKeys.reserve(currSize);
+	keptValues.reserve(currSize);
+	Iterator other = rbTree.begin();
+
+	for (Iterator it = begin(); it != end(); ++it) {
+
+		// skip rbTree's keys that are smaller than the current one
+		while (other != rbTree.end() && keyLess(other->key, it->key)) {
+			++other;
+		}
+
+		bool paired = other != rbTree.end() && !keyLess(it->key, other->key);
+
+		// each node of rbTree pairs with one node of this tree
+		if (paired) {
+			++other;
+		}
+
+		if (paired == keepCommon) {
+			keptKeys.push_back(it->key);
+			keptValues.push_back(it->value);
+		}
+
+	}
+
+	rbTree.clear();
+	buildFromSorted(keptKeys.data(), keptValues.data(), (int)keptKeys.size());
+
+}
+
+// HELPER FUNCTION: inserts a node in the appropriate location in a tree
+// USED BY: insert()
+template <class T, class U, class Compare>
+NodeT<T, U>* RedBlackTree<T, U, Compare>::BSTinsert(const T& keyP, const U& valueP) {
+
+	NodeT<T, U>* newNode = new NodeT<T, U>(keyP, valueP); // create new node
+	RBT_STAT(stats.allocations++);
+	NodeT<T, U>* parent = root; // keep track of parent of the node we want to insert
+	NodeT<T, U>* next = root; // to determine what is ahead of current node
+
+	// if tree is empty
+	if (empty()) {
+		root = newNode;
+	}
+
+	// if tree is not empty
+	else {
+
+		// finding parent of new node
+		while (next != nullptr) {
+
+			parent = next; // keep track of parent
+
+			// descend left-subtree
+			if (keyLess(keyP, parent->key)) {
+				next = parent->left;
+			}
+
+			// descend right-subtree
+			else {
+				next = parent->right;
+			}
+
+		}
+
+		// insert new node
+		if (keyLess(keyP, parent->key)) {
+
+			parent->left = newNode; // left-child
+			newNode->parent = parent; // new node's parent is matched
+
+		}
+
+		else {
+
+			parent->right = newNode; // right-child
+			newNode->parent = parent; // new node's parent is matched
+
+		}
+
+	}
+
+	return newNode;
+}
+
+// HELPER FUNCTION: finds the predecessor 
+// USED BY: remove()
+template <class T, class U, class Compare>
+NodeT<T, U>* RedBlackTree<T, U, Compare>::predecessor(NodeT<T, U>* nd) const {
+
+	// enter left sub-tree
+	nd = nd->left;
 
 	// find right-most node (predecessor)
 	while (nd->right != nullptr) {
@@ -602,16 +1574,58 @@ NodeT<T, U>* RedBlackTree<T, U>::predecessor(NodeT<T, U>* nd) const {
 
 }
 
+// HELPER FUNCTION: finds the left-most (smallest) node under nd
+// USED BY: values(), keys(), items(), begin(), size(NodeT* nd)
+template <class T, class U, class Compare>
+NodeT<T, U>* RedBlackTree<T, U, Compare>::minimum(NodeT<T, U>* nd) {
+
+	if (nd == nullptr) {
+		return nullptr;
+	}
+
+	while (nd->left != nullptr) {
+		nd = nd->left;
+	}
+
+	return nd;
+
+}
+
+// HELPER FUNCTION: finds the in-order successor using parent pointers,
+// returns NULL if nd holds the largest key
+// USED BY: values(), keys(), items(), inOrderSearch(), Iterator
+template <class T, class U, class Compare>
+NodeT<T, U>* RedBlackTree<T, U, Compare>::successor(NodeT<T, U>* nd) {
+
+	// smallest node of the right sub-tree
+	if (nd->right != nullptr) {
+		return minimum(nd->right);
+	}
+
+	// otherwise the first ancestor reached from its left sub-tree
+	NodeT<T, U>* parent = nd->parent;
+
+	while (parent != nullptr && nd == parent->right) {
+		nd = parent;
+		parent = parent->parent;
+	}
+
+	return parent;
+
+}
+
 // HELPER FUNCTION: fixes the RB Tree
 // USED BY: remove()
-template <class T, class U>
-void RedBlackTree<T, U>::rbFix(NodeT<T, U>* nd, bool isLeafCheck) {
+template <class T, class U, class Compare>
+void RedBlackTree<T, U, Compare>::rbFix(NodeT<T, U>* nd, bool isLeafCheck) {
 
 	NodeT<T, U>* ndCopy = nd; // copy of ndRemoveChild, to be deleted if a NULL node
 
 	// if ndRemoveChild is not the root and is black
 	while (nd != root && nd->isBlack == true) {
 
+		RBT_STAT(stats.removeFixups++);
+
 		// ndRemoveChild is a left child
 		if (nd == nd->parent->left) {
 
@@ -737,28 +1751,517 @@ void RedBlackTree<T, U>::rbFix(NodeT<T, U>* nd, bool isLeafCheck) {
 
 }
 
-// HELPER FUNCTION: counts the number of nodes stored in a tree
-// USED BY: size()
-template <class T, class U>
-int RedBlackTree<T, U>::size(NodeT<T, U>* nd) const{
+// HELPER FUNCTION: counts the number of nodes stored in a sub-tree
+// USED BY: intersectNodes(), subtractNodes(), size() is kept up to date by insert() and remove()
+template <class T, class U, class Compare>
+int RedBlackTree<T, U, Compare>::size(NodeT<T, U>* nd) const{
+
+	// if sub-tree is empty
+	if (nd == nullptr) {
+		return 0;
+	}
 
-	int count = 1;
+	int count = 0;
+	NodeT<T, U>* last = nd; // right-most node, the last one in nd's sub-tree
 
-	if (nd->left != nullptr) {
-		count += size(nd->left);
+	while (last->right != nullptr) {
+		last = last->right;
 	}
 
-	if (nd->right != nullptr) {
-		count += size(nd->right);
+	// walk successors from the left-most node up to the right-most one
+	for (NodeT<T, U>* current = minimum(nd); current != last; current = successor(current)) {
+		count++;
+	}
+
+	return count + 1;
+}
+
+// HELPER FUNCTION: recolours and rotates upwards from the red node newNode
+// until no red node has a red parent, only the root may be left red
+// USED BY: insert(), joinNodes()
+template <class T, class U, class Compare>
+void RedBlackTree<T, U, Compare>::insertFix(NodeT<T, U>* newNode) {
+
+	// while newNode is not the root and its parents are red
+	while (newNode != root && newNode->parent->isBlack == false) {
+
+		RBT_STAT(stats.insertFixups++);
+
+		// if newNode's parent is a left child
+		if (newNode->parent == newNode->parent->parent->left) {
+
+			// uncle of newNode, sibling of newNode's parents
+			NodeT<T, U>* uncle = newNode->parent->parent->right;
+
+			// if uncle is red (ensure it is not NULL to have a colour)
+			if (uncle != nullptr && uncle->isBlack == false) {
+
+				newNode->parent->isBlack = true;
+				uncle->isBlack = true;
+				newNode->parent->parent->isBlack = false;
+				newNode = newNode->parent->parent;
+
+			}
+
+			// if uncle is NULL (hence it has a black colour)
+			else {
+
+				if (newNode == newNode->parent->right) {
+
+					newNode = newNode->parent;
+					leftRotate(newNode);
+
+				}
+
+				newNode->parent->isBlack = true;
+				newNode->parent->parent->isBlack = false;
+				rightRotate(newNode->parent->parent);
+
+			}
+		}
+
+		// if newNode's parent is a right child
+		else {
+
+			// uncle of newNode, sibling of newNode's parents
+			NodeT<T, U>* uncle = newNode->parent->parent->left;
+
+			// if uncle is red (ensure it is not NULL to have a colour)
+			if (uncle != nullptr && uncle->isBlack == false) {
+
+				newNode->parent->isBlack = true;
+				uncle->isBlack = true;
+				newNode->parent->parent->isBlack = false;
+				newNode = newNode->parent->parent;
+
+			}
+
+			// if uncle is NULL (hence it has a black colour)
+			else {
+
+				if (newNode == newNode->parent->left) {
+
+					newNode = newNode->parent;
+					rightRotate(newNode);
+
+				}
+
+				newNode->parent->isBlack = true;
+				newNode->parent->parent->isBlack = false;
+				leftRotate(newNode->parent->parent);
+
+			}
+		}
+	}
+}
+
+// HELPER FUNCTION: wraps the root of a whole tree, whose black height is
+// counted once down its left spine
+// USED BY: split(), join(), unionWith(), intersectWith(), subtract()
+template <class T, class U, class Compare>
+typename RedBlackTree<T, U, Compare>::SubTree RedBlackTree<T, U, Compare>::wholeTree(NodeT<T, U>* nd) {
+
+	SubTree part = { nd, 0 };
+
+	for (; nd != nullptr; nd = nd->left) {
+		if (nd->isBlack) {
+			part.height++;
+		}
+	}
+
+	return part;
+
+}
+
+// HELPER FUNCTION: cuts child off its black parent of black height parentHeight;
+// a red child is coloured black, which keeps it a valid R-B Tree one level taller
+// USED BY: splitNodes(), unionNodes(), intersectNodes(), subtractNodes()
+template <class T, class U, class Compare>
+typename RedBlackTree<T, U, Compare>::SubTree RedBlackTree<T, U, Compare>::childTree(NodeT<T, U>* child, int parentHeight) {
+
+	SubTree part = { child, parentHeight - 1 };
+
+	if (child != nullptr) {
+
+		if (!child->isBlack) {
+			child->isBlack = true;
+			part.height++;
+		}
+
+		child->parent = nullptr;
+
+	}
+
+	return part;
+
+}
+
+// HELPER FUNCTION: joins two sub-trees around mid, whose key lies between them;
+// mid is hung as a red node on the inner spine of the taller sub-tree where the
+// black heights match, then the usual insertion fix repairs any red-red pair above it
+// USED BY: join(), split(), splitNodes(), unionNodes(), intersectNodes(), subtractNodes()
+template <class T, class U, class Compare>
+typename RedBlackTree<T, U, Compare>::SubTree RedBlackTree<T, U, Compare>::joinNodes(SubTree lessPart, NodeT<T, U>* mid, SubTree greaterPart) const {
+
+	mid->parent = nullptr;
+
+	// if both sides are equally tall, mid becomes their common black root
+	if (lessPart.height == greaterPart.height) {
+
+		mid->left = lessPart.nd;
+		mid->right = greaterPart.nd;
+		mid->isBlack = true;
+
+		if (lessPart.nd != nullptr) {
+			lessPart.nd->parent = mid;
+		}
+
+		if (greaterPart.nd != nullptr) {
+			greaterPart.nd->parent = mid;
+		}
+
+		SubTree joined = { mid, lessPart.height + 1 };
+		return joined;
+
+	}
+
+	bool lessTaller = lessPart.height > greaterPart.height;
+	SubTree taller = lessTaller ? lessPart : greaterPart;
+	NodeT<T, U>* current = taller.nd; // iterator down the inner spine
+	NodeT<T, U>* parent = nullptr; // parent of current
+	int height = taller.height; // black height of current
+	int target = lessTaller ? greaterPart.height : lessPart.height; // black height of the shorter side
+
+	// descend to the first black node (or NULL) as tall as the shorter side
+	while (current != nullptr && !(current->isBlack && height == target)) {
+
+		if (current->isBlack) {
+			height--;
+		}
+
+		parent = current;
+		current = lessTaller ? current->right : current->left;
+
+	}
+
+	mid->isBlack = false;
+	mid->parent = parent;
+	mid->left = lessTaller ? current : lessPart.nd;
+	mid->right = lessTaller ? greaterPart.nd : current;
+
+	if (mid->left != nullptr) {
+		mid->left->parent = mid;
+	}
+
+	if (mid->right != nullptr) {
+		mid->right->parent = mid;
+	}
+
+	if (lessTaller) {
+		parent->right = mid;
+	}
+
+	else {
+		parent->left = mid;
+	}
+
+	RedBlackTree work(comp); // scratch tree, its root follows the rotations of the fix
+	work.root = taller.nd;
+	work.insertFix(mid);
+	RBT_STAT(stats.rotations += work.stats.rotations);
+	RBT_STAT(stats.insertFixups += work.stats.insertFixups);
+
+	SubTree joined = { work.root, taller.height };
+	work.root = nullptr; // the nodes belong to the caller
+
+	// the fix may push a red node up to the root, colouring it black adds a level
+	if (!joined.nd->isBlack) {
+		joined.nd->isBlack = true;
+		joined.height++;
+	}
+
+	return joined;
+
+}
+
+// HELPER FUNCTION: joins two sub-trees without a middle key, by splitting the
+// smallest node off greaterPart and using it as the middle; relies on the
+// unique-key split, as do its callers
+// USED BY: intersectNodes(), subtractNodes()
+template <class T, class U, class Compare>
+typename RedBlackTree<T, U, Compare>::SubTree RedBlackTree<T, U, Compare>::joinNodes(SubTree lessPart, SubTree greaterPart) const {
+
+	if (greaterPart.nd == nullptr) {
+		return lessPart;
+	}
+
+	SubTree unused; // nothing is smaller than the smallest key
+	SubTree rest;
+	NodeT<T, U>* mid = nullptr;
+	splitNodes(greaterPart, minimum(greaterPart.nd)->key, unused, mid, rest);
+	return joinNodes(lessPart, mid, rest);
+
+}
+
+// HELPER FUNCTION: splits a sub-tree into the keys less than keyP, the node holding
+// keyP (or NULL) and the keys greater than keyP; every node on the search path is
+// rejoined to the side it belongs to, so no node is allocated; with duplicates
+// allowed, nodes equal to keyP go to greaterPart and mid is always NULL
+// USED BY: split(), joinNodes(), unionNodes(), intersectNodes(), subtractNodes()
+template <class T, class U, class Compare>
+void RedBlackTree<T, U, Compare>::splitNodes(SubTree part, const T& keyP, SubTree& lessPart, NodeT<T, U>* & mid, SubTree& greaterPart) const {
+
+	NodeT<T, U>* nd = part.nd;
+
+	// if sub-tree is empty
+	if (nd == nullptr) {
+		lessPart = part;
+		mid = nullptr;
+		greaterPart = part;
+		return;
 	}
 
-	return count;
+	SubTree left = childTree(nd->left, part.height);
+	SubTree right = childTree(nd->right, part.height);
+	nd->left = nullptr;
+	nd->right = nullptr;
+
+	SubTree piece; // part of a child sub-tree that goes with nd
+
+	// keyP is in the left sub-tree, equal keys go right with duplicates allowed
+	if (keyLess(keyP, nd->key) || (allowDuplicates && !keyLess(nd->key, keyP))) {
+		splitNodes(left, keyP, lessPart, mid, piece);
+		greaterPart = joinNodes(piece, nd, right);
+	}
+
+	// keyP is in the right sub-tree
+	else if (keyLess(nd->key, keyP)) {
+		splitNodes(right, keyP, piece, mid, greaterPart);
+		lessPart = joinNodes(left, nd, piece);
+	}
+
+	// nd holds keyP
+	else {
+		lessPart = left;
+		mid = nd;
+		greaterPart = right;
+	}
+}
+
+// HELPER FUNCTION: union of two sub-trees, reusing their nodes; other is split
+// around the key of part's root and each side is merged with that root's children,
+// forking the left side onto another thread while levels > 0
+// USED BY: unionWith()
+template <class T, class U, class Compare>
+typename RedBlackTree<T, U, Compare>::SubTree RedBlackTree<T, U, Compare>::unionNodes(SubTree part, SubTree other, int& dropped, int levels) const {
+
+	if (part.nd == nullptr) {
+		return other;
+	}
+
+	if (other.nd == nullptr) {
+		return part;
+	}
+
+	NodeT<T, U>* nd = part.nd;
+	SubTree left = childTree(nd->left, part.height);
+	SubTree right = childTree(nd->right, part.height);
+
+	SubTree otherLess;
+	SubTree otherGreater;
+	NodeT<T, U>* same = nullptr; // other's node with nd's key, if any
+	splitNodes(other, nd->key, otherLess, same, otherGreater);
+
+	// this tree's value wins for keys present in both
+	if (same != nullptr) {
+		delete same;
+		dropped++;
+	}
+
+	SubTree newLeft;
+	SubTree newRight;
+	int droppedLeft = 0; // counter of the left side, which may run on another thread
+
+	if (levels > 0) {
+		std::future<SubTree> task = std::async(std::launch::async, [&]() {
+			return unionNodes(left, otherLess, droppedLeft, levels - 1);
+		});
+		newRight = unionNodes(right, otherGreater, dropped, levels - 1);
+		newLeft = task.get();
+	}
+
+	else {
+		newLeft = unionNodes(left, otherLess, droppedLeft, 0);
+		newRight = unionNodes(right, otherGreater, dropped, 0);
+	}
+
+	dropped += droppedLeft;
+	return joinNodes(newLeft, nd, newRight);
+
+}
+
+// HELPER FUNCTION: intersection of two sub-trees, keeping part's nodes and
+// deallocating every other node, forking like unionNodes()
+// USED BY: intersectWith()
+template <class T, class U, class Compare>
+typename RedBlackTree<T, U, Compare>::SubTree RedBlackTree<T, U, Compare>::intersectNodes(SubTree part, SubTree other, int& dropped, int levels) const {
+
+	if (part.nd == nullptr || other.nd == nullptr) {
+		dropped += size(part.nd) + size(other.nd);
+		clear(part.nd);
+		clear(other.nd);
+		SubTree empty = { nullptr, 0 };
+		return empty;
+	}
+
+	NodeT<T, U>* nd = part.nd;
+	SubTree left = childTree(nd->left, part.height);
+	SubTree right = childTree(nd->right, part.height);
+	nd->left = nullptr;
+	nd->right = nullptr;
+
+	SubTree otherLess;
+	SubTree otherGreater;
+	NodeT<T, U>* same = nullptr; // other's node with nd's key, if any
+	splitNodes(other, nd->key, otherLess, same, otherGreater);
+
+	SubTree newLeft;
+	SubTree newRight;
+	int droppedLeft = 0; // counter of the left side, which may run on another thread
+
+	if (levels > 0) {
+		std::future<SubTree> task = std::async(std::launch::async, [&]() {
+			return intersectNodes(left, otherLess, droppedLeft, levels - 1);
+		});
+		newRight = intersectNodes(right, otherGreater, dropped, levels - 1);
+		newLeft = task.get();
+	}
+
+	else {
+		newLeft = intersectNodes(left, otherLess, droppedLeft, 0);
+		newRight = intersectNodes(right, otherGreater, dropped, 0);
+	}
+
+	dropped += droppedLeft;
+
+	// nd's key is in both trees
+	if (same != nullptr) {
+		delete same;
+		dropped++;
+		return joinNodes(newLeft, nd, newRight);
+	}
+
+	delete nd;
+	dropped++;
+	return joinNodes(newLeft, newRight);
+
+}
+
+// HELPER FUNCTION: difference of two sub-trees, deallocating other's nodes and
+// part's nodes whose keys are in other, forking like unionNodes()
+// USED BY: subtract()
+template <class T, class U, class Compare>
+typename RedBlackTree<T, U, Compare>::SubTree RedBlackTree<T, U, Compare>::subtractNodes(SubTree part, SubTree other, int& dropped, int levels) const {
+
+	if (part.nd == nullptr || other.nd == nullptr) {
+		dropped += size(other.nd);
+		clear(other.nd);
+		return part;
+	}
+
+	NodeT<T, U>* nd = part.nd;
+	SubTree left = childTree(nd->left, part.height);
+	SubTree right = childTree(nd->right, part.height);
+	nd->left = nullptr;
+	nd->right = nullptr;
+
+	SubTree otherLess;
+	SubTree otherGreater;
+	NodeT<T, U>* same = nullptr; // other's node with nd's key, if any
+	splitNodes(other, nd->key, otherLess, same, otherGreater);
+
+	SubTree newLeft;
+	SubTree newRight;
+	int droppedLeft = 0; // counter of the left side, which may run on another thread
+
+	if (levels > 0) {
+		std::future<SubTree> task = std::async(std::launch::async, [&]() {
+			return subtractNodes(left, otherLess, droppedLeft, levels - 1);
+		});
+		newRight = subtractNodes(right, otherGreater, dropped, levels - 1);
+		newLeft = task.get();
+	}
+
+	else {
+		newLeft = subtractNodes(left, otherLess, droppedLeft, 0);
+		newRight = subtractNodes(right, otherGreater, dropped, 0);
+	}
+
+	dropped += droppedLeft;
+
+	// nd's key is not removed
+	if (same == nullptr) {
+		return joinNodes(newLeft, nd, newRight);
+	}
+
+	delete same;
+	delete nd;
+	dropped += 2;
+	return joinNodes(newLeft, newRight);
+
+}
+
+// HELPER FUNCTION: levels of set-operation recursion that fork a thread,
+// enough to give every hardware thread a share of large inputs
+// USED BY: unionWith(), intersectWith(), subtract()
+template <class T, class U, class Compare>
+int RedBlackTree<T, U, Compare>::parallelLevels(int total) const {
+
+	if (total < PARALLEL_MIN_SIZE) {
+		return 0;
+	}
+
+#ifdef RBTREE_STATS
+	// counters are plain integers, statistics builds stay on one thread
+	return 0;
+#endif
+
+	int threads = (int)std::thread::hardware_concurrency();
+	int levels = 0;
+
+	while ((2 << levels) <= threads && levels < 6) {
+		levels++;
+	}
+
+	return levels;
+
+}
+
+// HELPER FUNCTION: walks the sub-trees at nd and other side by side until one
+// ends, so the cost is the size of the smaller one; total is both sizes summed
+// returns the number of nodes under nd
+// USED BY: split()
+template <class T, class U, class Compare>
+int RedBlackTree<T, U, Compare>::countSmaller(NodeT<T, U>* nd, NodeT<T, U>* other, int total) const {
+
+	NodeT<T, U>* first = minimum(nd);
+	NodeT<T, U>* second = minimum(other);
+	int steps = 0;
+
+	while (first != nullptr && second != nullptr) {
+		first = successor(first);
+		second = successor(second);
+		steps++;
+	}
+
+	return (first == nullptr) ? steps : total - steps;
+
 }
 
 // HELPER FUNCTION: checks if the tree is empty or not
 // USED BY: BSTinsert()
-template <class T, class U>
-bool RedBlackTree<T, U>::empty() const{
+template <class T, class U, class Compare>
+bool RedBlackTree<T, U, Compare>::empty() const{
 
 	return root == nullptr;
 
@@ -766,8 +2269,10 @@ bool RedBlackTree<T, U>::empty() const{
 
 // HELPER FUNCTION: left-rotate on newNode
 // USED BY: insert(), remove()
-template <class T, class U>
-void RedBlackTree<T, U>::leftRotate(NodeT<T, U>* newNode) {
+template <class T, class U, class Compare>
+void RedBlackTree<T, U, Compare>::leftRotate(NodeT<T, U>* newNode) {
+
+	RBT_STAT(stats.rotations++);
 
 	NodeT<T, U>* newParent = newNode->right; // newNode's soon-to-be new parent
 	newNode->right = newParent->left; // attach newParent's left child as newNode's right child
@@ -801,8 +2306,10 @@ void RedBlackTree<T, U>::leftRotate(NodeT<T, U>* newNode) {
 
 // HELPER FUNCTION: right-rotate on newNode
 // USED BY: insert(), remove()
-template <class T, class U>
-void RedBlackTree<T, U>::rightRotate(NodeT<T, U>* newNode) {
+template <class T, class U, class Compare>
+void RedBlackTree<T, U, Compare>::rightRotate(NodeT<T, U>* newNode) {
+
+	RBT_STAT(stats.rotations++);
 
 	NodeT<T, U>* newParent = newNode->left; // newNode's soon-to-be new parent
 	newNode->left = newParent->right; // attach newParent's right child as newNode's left child
@@ -834,59 +2341,39 @@ void RedBlackTree<T, U>::rightRotate(NodeT<T, U>* newNode) {
 	newNode->parent = newParent; // attach newParent as newNode's new parent
 }
 
-// HELPER FUNCTION: in-order traversal for search(T keyP1, T keyP2)
+// HELPER FUNCTION: in-order traversal for search(T keyP1, T keyP2),
+// descends to the first key in range, then walks successors until the range ends
 // USED BY: search(T keyP1, T keyP2)
-template <class T, class U>
-void RedBlackTree<T, U>::inOrderSearch(NodeT<T, U>* nd, vector<U>& myVect, const T keyP1, const T keyP2) const {
+template <class T, class U, class Compare>
+void RedBlackTree<T, U, Compare>::inOrderSearch(NodeT<T, U>* nd, vector<U>& myVect, const T& keyP1, const T& keyP2) const {
 
-	if (nd != nullptr) {
+	// bounds may be given in either order
+	const T& low = keyLess(keyP2, keyP1) ? keyP2 : keyP1;
+	const T& high = keyLess(keyP2, keyP1) ? keyP1 : keyP2;
+	NodeT<T, U>* first = nullptr; // smallest node with key >= low
 
-		inOrderSearch(nd->left, myVect, keyP1, keyP2);
+	while (nd != nullptr) {
 
-		if ((nd->key >= keyP1 && nd->key <= keyP2) || 
-			(nd->key >= keyP2 && nd->key <= keyP1)) {
-			myVect.push_back(nd->value);
+		if (keyLess(nd->key, low)) {
+			nd = nd->right;
 		}
 
-		inOrderSearch(nd->right, myVect, keyP1, keyP2);
+		else {
+			first = nd;
+			nd = nd->left;
+		}
 
 	}
-}
-
-// HELPER FUNCTION: in-order traversal for values()
-// USED BY: values()
-template <class T, class U>
-void RedBlackTree<T, U>::inOrderValues(NodeT<T, U>* nd, vector<U>& myVect) const {
 
-	if (nd != nullptr) {
-
-		inOrderValues(nd->left, myVect);
+	for (nd = first; nd != nullptr && !keyLess(high, nd->key); nd = successor(nd)) {
 		myVect.push_back(nd->value);
-		inOrderValues(nd->right, myVect);
-
-	}
-
-}
-
-// HELPER FUNCTION: in-order traversal for keys()
-// USED BY: keys()
-template <class T, class U>
-void RedBlackTree<T, U>::inOrderKeys(NodeT<T, U>* nd, vector<T>& myVect) const {
-
-	if (nd != nullptr) {
-
-		inOrderKeys(nd->left, myVect);
-		myVect.push_back(nd->key);
-		inOrderKeys(nd->right, myVect);
-
 	}
-
 }
 
 // HELPER FUNCTION: check if tree is properly in-order
 // USED BY: inOrderPrint()
-template <class T, class U>
-void RedBlackTree<T, U>::inOrderP(NodeT<T, U>* nd) {
+template <class T, class U, class Compare>
+void RedBlackTree<T, U, Compare>::inOrderP(NodeT<T, U>* nd) {
 
 	if (nd != nullptr) {
 
@@ -905,11 +2392,82 @@ void RedBlackTree<T, U>::inOrderP(NodeT<T, U>* nd) {
 
 }
 
+// HELPER FUNCTION: builds a balanced sub-tree from keysP[low..high], splitting at the middle
+// so that all leaves are on the last two levels
+// USED BY: buildFromSorted()
+template <class T, class U, class Compare>
+NodeT<T, U>* RedBlackTree<T, U, Compare>::buildSorted(const T* keysP, const U* valuesP, int low, int high, int depth, int redDepth, NodeT<T, U>* parent) {
+
+	// if range is empty
+	if (low > high) {
+		return nullptr;
+	}
+
+	int mid = low + (high - low) / 2;
+	NodeT<T, U>* newNode = new NodeT<T, U>(keysP[mid], valuesP[mid]);
+	RBT_STAT(stats.allocations++);
+	newNode->isBlack = (depth != redDepth);
+	newNode->parent = parent;
+	newNode->left = buildSorted(keysP, valuesP, low, mid - 1, depth + 1, redDepth, newNode);
+	newNode->right = buildSorted(keysP, valuesP, mid + 1, high, depth + 1, redDepth, newNode);
+	return newNode;
+
+}
+
 // HELPER FUNCTION: in-order print
 // USED BY: main() 
-template <class T, class U>
-void RedBlackTree<T, U>::inOrderPrint() {
+template <class T, class U, class Compare>
+void RedBlackTree<T, U, Compare>::inOrderPrint() {
 
 	inOrderP(root);
 
 }
+
+// ITERATOR: constructor
+template <class T, class U, class Compare>
+RedBlackTree<T, U, Compare>::Iterator::Iterator(NodeT<T, U>* nd) {
+
+	current = nd;
+
+}
+
+// ITERATOR: returns the current node
+template <class T, class U, class Compare>
+const NodeT<T, U>& RedBlackTree<T, U, Compare>::Iterator::operator*() const {
+
+	return *current;
+
+}
+
+// ITERATOR: returns a pointer to the current node
+template <class T, class U, class Compare>
+const NodeT<T, U>* RedBlackTree<T, U, Compare>::Iterator::operator->() const {
+
+	return current;
+
+}
+
+// ITERATOR: advances to the in-order successor
+template <class T, class U, class Compare>
+typename RedBlackTree<T, U, Compare>::Iterator& RedBlackTree<T, U, Compare>::Iterator::operator++() {
+
+	current = successor(current);
+	return *this;
+
+}
+
+// ITERATOR: checks if both iterators are at the same node
+template <class T, class U, class Compare>
+bool RedBlackTree<T, U, Compare>::Iterator::operator==(const Iterator& other) const {
+
+	return current == other.current;
+
+}
+
+// ITERATOR: checks if the iterators are at different nodes
+template <class T, class U, class Compare>
+bool RedBlackTree<T, U, Compare>::Iterator::operator!=(const Iterator& other) const {
+
+	return current != other.current;
+
+}
@@ -0,0 +1,397 @@
+/*
+RedBlackTreeSnapshot.h
+
+Compact on-disk snapshots of a RedBlackTree<T, U> whose keys and values
+are trivially copyable
+
+A snapshot file holds a fixed header followed by every key in ascending
+order and then every value in the same order, each array aligned to a
+cache line. RedBlackTreeSnapshot memory-maps a file and answers queries
+read-only in place with a binary search over the key array, so a service
+can serve lookups straight after start-up. load() rebuilds a live tree in
+linear time with RedBlackTree::buildFromSorted().
+
+Authour: Fitz Laddaran
+Contact: fitzladdaran@gmail.com
+Last Updated: 27/08/2020
+*/
+
+#pragma once
+#include "RedBlackTree.h"
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <stdint.h>
+#include <type_traits>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using std::vector;
+
+// fixed-size header at the start of every snapshot file
+struct RedBlackTreeSnapshotHeader {
+	char magic[8]; // "RBTSNAP" followed by '\0'
+	uint32_t version; // format version
+	uint32_t keySize; // sizeof(T) of the writer
+	uint32_t valueSize; // sizeof(U) of the writer
+	uint32_t reserved; // always 0
+	uint64_t count; // number of key-value pairs
+	uint64_t keysOffset; // byte offset of the key array
+	uint64_t valuesOffset; // byte offset of the value array
+};
+
+const char RBT_SNAPSHOT_MAGIC[8] = { 'R', 'B', 'T', 'S', 'N', 'A', 'P', '\0' };
+const uint32_t RBT_SNAPSHOT_VERSION = 1;
+const uint64_t RBT_SNAPSHOT_ALIGN = 64;
+
+// writes every key-value pair of rbTree to a snapshot file at path, through a
+// temporary file named path followed by ".tmp" that is then renamed over path,
+// so a snapshot still mapped from path keeps reading the old contents after a
+// re-save and path is never left half written
+// returns false if the file cannot be written or renamed, leaving path unchanged
+template <class T, class U, class Compare>
+bool saveSnapshot(const RedBlackTree<T, U, Compare>& rbTree, const char* path);
+
+// rebuilds rbTree from the snapshot file at path
+// returns false (leaving rbTree unchanged) if the file is missing or invalid
+template <class T, class U, class Compare>
+bool loadSnapshot(RedBlackTree<T, U, Compare>& rbTree, const char* path);
+
+// keys are ordered by Compare, which must match the comparator of the saved tree
+template <class T, class U, class Compare = std::less<T>>
+class RedBlackTreeSnapshot {
+
+	static_assert(std::is_trivially_copyable<T>::value, "snapshot keys must be trivially copyable");
+	static_assert(std::is_trivially_copyable<U>::value, "snapshot values must be trivially copyable");
+
+public:
+
+	RedBlackTreeSnapshot(); // constructor
+	explicit RedBlackTreeSnapshot(const Compare& compP); // constructor with a comparator object
+	~RedBlackTreeSnapshot(); // destructor, unmaps the file
+
+	// maps the snapshot file at path, replacing any mapped file
+	// returns false if the file is missing or invalid
+	bool open(const char* path);
+
+	// unmaps the snapshot file
+	void close();
+
+	// search snapshot to see if key is present
+	bool search(const T& keyP) const;
+
+	// returns a pointer to the value mapped to keyP, or NULL if key is not present
+	const U* find(const T& keyP) const;
+
+	// returns all values whose keys are between keyP1 - keyP2
+	// based on ascending order of keys
+	vector<U> search(const T& keyP1, const T& keyP2) const;
+
+	// rebuilds rbTree from the mapped pairs in linear time
+	bool load(RedBlackTree<T, U, Compare>& rbTree) const;
+
+	// returns number of items stored in the snapshot
+	int size() const;
+
+	// sorted keys and their values, valid while the file is mapped
+	const T* keys() const;
+	const U* values() const;
+
+private:
+
+	RedBlackTreeSnapshot(const RedBlackTreeSnapshot& snap) = delete;
+	RedBlackTreeSnapshot& operator=(const RedBlackTreeSnapshot& snap) = delete;
+
+	// attributes
+	void* mapping; // start of the mapped file
+	size_t mappingSize; // length of the mapped file
+	const T* keyArr; // sorted keys inside the mapping
+	const U* valueArr; // values inside the mapping
+	int count; // number of key-value pairs
+	Compare comp; // orders the keys
+
+	// helper functions
+	int lowerBound(const T& keyP) const; // first slot whose key is >= keyP
+
+};
+
+// HELPER FUNCTION: rounds offset up to the snapshot alignment
+// USED BY: saveSnapshot()
+inline uint64_t snapshotAlign(uint64_t offset) {
+
+	return (offset + RBT_SNAPSHOT_ALIGN - 1) / RBT_SNAPSHOT_ALIGN * RBT_SNAPSHOT_ALIGN;
+
+}
+
+// writes the header, then the keys, then the values (two in-order passes) into a
+// temporary file renamed over path
+template <class T, class U, class Compare>
+bool saveSnapshot(const RedBlackTree<T, U, Compare>& rbTree, const char* path) {
+
+	static_assert(std::is_trivially_copyable<T>::value, "snapshot keys must be trivially copyable");
+	static_assert(std::is_trivially_copyable<U>::value, "snapshot values must be trivially copyable");
+
+	RedBlackTreeSnapshotHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, RBT_SNAPSHOT_MAGIC, sizeof(header.magic));
+	header.version = RBT_SNAPSHOT_VERSION;
+	header.keySize = sizeof(T);
+	header.valueSize = sizeof(U);
+	header.count = rbTree.size();
+	header.keysOffset = snapshotAlign(sizeof(header));
+	header.valuesOffset = snapshotAlign(header.keysOffset + header.count * sizeof(T));
+
+	// truncating path itself would pull the pages out from under a mapping of it
+	std::string tempPath = std::string(path) + ".tmp";
+	FILE* f = fopen(tempPath.c_str(), "wb");
+
+	if (f == nullptr) {
+		return false;
+	}
+
+	const char padding[RBT_SNAPSHOT_ALIGN] = { 0 };
+	bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+	ok = ok && fwrite(padding, 1, header.keysOffset - sizeof(header), f) == header.keysOffset - sizeof(header);
+
+	for (typename RedBlackTree<T, U, Compare>::Iterator it = rbTree.begin(); ok && it != rbTree.end(); ++it) {
+		ok = fwrite(&it->key, sizeof(T), 1, f) == 1;
+	}
+
+	uint64_t keysEnd = header.keysOffset + header.count * sizeof(T);
+	ok = ok && fwrite(padding, 1, header.valuesOffset - keysEnd, f) == header.valuesOffset - keysEnd;
+
+	for (typename RedBlackTree<T, U, Compare>::Iterator it = rbTree.begin(); ok && it != rbTree.end(); ++it) {
+		ok = fwrite(&it->value, sizeof(U), 1, f) == 1;
+	}
+
+	// fclose() flushes buffered writes, which may fail too
+	ok = fclose(f) == 0 && ok;
+
+	// if the file is incomplete or cannot replace path
+	if (!ok || rename(tempPath.c_str(), path) != 0) {
+		remove(tempPath.c_str());
+		return false;
+	}
+
+	return true;
+
+}
+
+// maps the snapshot, then bulk-builds the tree from it
+template <class T, class U, class Compare>
+bool loadSnapshot(RedBlackTree<T, U, Compare>& rbTree, const char* path) {
+
+	RedBlackTreeSnapshot<T, U, Compare> snap(rbTree.keyComp());
+	return snap.open(path) && snap.load(rbTree);
+
+}
+
+// constructor
+template <class T, class U, class Compare>
+RedBlackTreeSnapshot<T, U, Compare>::RedBlackTreeSnapshot() {
+
+	mapping = nullptr;
+	mappingSize = 0;
+	keyArr = nullptr;
+	valueArr = nullptr;
+	count = 0;
+
+}
+
+// constructor with a comparator object
+template <class T, class U, class Compare>
+RedBlackTreeSnapshot<T, U, Compare>::RedBlackTreeSnapshot(const Compare& compP) : comp(compP) {
+
+	mapping = nullptr;
+	mappingSize = 0;
+	keyArr = nullptr;
+	valueArr = nullptr;
+	count = 0;
+
+}
+
+// destructor
+template <class T, class U, class Compare>
+RedBlackTreeSnapshot<T, U, Compare>::~RedBlackTreeSnapshot() {
+
+	close();
+
+}
+
+// maps the file read-only and validates its header
+template <class T, class U, class Compare>
+bool RedBlackTreeSnapshot<T, U, Compare>::open(const char* path) {
+
+	close();
+
+	int fd = ::open(path, O_RDONLY);
+
+	if (fd == -1) {
+		return false;
+	}
+
+	struct stat info;
+
+	if (fstat(fd, &info) == -1 || (size_t)info.st_size < sizeof(RedBlackTreeSnapshotHeader)) {
+		::close(fd);
+		return false;
+	}
+
+	void* addr = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd); // the mapping stays valid after the descriptor is closed
+
+	if (addr == MAP_FAILED) {
+		return false;
+	}
+
+	const RedBlackTreeSnapshotHeader* header = static_cast<const RedBlackTreeSnapshotHeader*>(addr);
+	uint64_t fileSize = info.st_size;
+
+	// reject files written by another format, or for other key/value types
+	bool valid = memcmp(header->magic, RBT_SNAPSHOT_MAGIC, sizeof(header->magic)) == 0 &&
+		header->version == RBT_SNAPSHOT_VERSION &&
+		header->keySize == sizeof(T) &&
+		header->valueSize == sizeof(U) &&
+		header->count <= (uint64_t)0x7fffffff &&
+		header->keysOffset % alignof(T) == 0 &&
+		header->valuesOffset % alignof(U) == 0 &&
+		header->keysOffset <= fileSize &&
+		header->valuesOffset <= fileSize &&
+		header->count <= (fileSize - header->keysOffset) / sizeof(T) &&
+		header->count <= (fileSize - header->valuesOffset) / sizeof(U);
+
+	if (!valid) {
+		munmap(addr, info.st_size);
+		return false;
+	}
+
+	mapping = addr;
+	mappingSize = info.st_size;
+	keyArr = reinterpret_cast<const T*>(static_cast<const char*>(addr) + header->keysOffset);
+	valueArr = reinterpret_cast<const U*>(static_cast<const char*>(addr) + header->valuesOffset);
+	count = (int)header->count;
+	return true;
+
+}
+
+// unmaps the file, if one is mapped
+template <class T, class U, class Compare>
+void RedBlackTreeSnapshot<T, U, Compare>::close() {
+
+	if (mapping != nullptr) {
+		munmap(mapping, mappingSize);
+	}
+
+	mapping = nullptr;
+	mappingSize = 0;
+	keyArr = nullptr;
+	valueArr = nullptr;
+	count = 0;
+
+}
+
+// search snapshot to see if key matches any stored key
+template <class T, class U, class Compare>
+bool RedBlackTreeSnapshot<T, U, Compare>::search(const T& keyP) const {
+
+	return find(keyP) != nullptr;
+
+}
+
+// returns a pointer into the mapping for the value of keyP, or NULL
+template <class T, class U, class Compare>
+const U* RedBlackTreeSnapshot<T, U, Compare>::find(const T& keyP) const {
+
+	int pos = lowerBound(keyP);
+
+	if (pos < count && !comp(keyP, keyArr[pos])) {
+		return &valueArr[pos];
+	}
+
+	return nullptr;
+
+}
+
+// returns a vector containing all values whose keys are between
+// keyP1 - keyP2, based on ascending key order
+template <class T, class U, class Compare>
+vector<U> RedBlackTreeSnapshot<T, U, Compare>::search(const T& keyP1, const T& keyP2) const {
+
+	// bounds may be given in either order
+	const T& low = comp(keyP2, keyP1) ? keyP2 : keyP1;
+	const T& high = comp(keyP2, keyP1) ? keyP1 : keyP2;
+	int first = lowerBound(low);
+	int last = first;
+
+	while (last < count && !comp(high, keyArr[last])) {
+		last++;
+	}
+
+	return vector<U>(valueArr + first, valueArr + last);
+
+}
+
+// rebuilds rbTree from the mapped pairs
+template <class T, class U, class Compare>
+bool RedBlackTreeSnapshot<T, U, Compare>::load(RedBlackTree<T, U, Compare>& rbTree) const {
+
+	// nothing is mapped
+	if (mapping == nullptr) {
+		return false;
+	}
+
+	return rbTree.buildFromSorted(keyArr, valueArr, count);
+
+}
+
+// returns the number of items stored in the snapshot
+template <class T, class U, class Compare>
+int RedBlackTreeSnapshot<T, U, Compare>::size() const {
+
+	return count;
+
+}
+
+// returns the mapped key array
+template <class T, class U, class Compare>
+const T* RedBlackTreeSnapshot<T, U, Compare>::keys() const {
+
+	return keyArr;
+
+}
+
+// returns the mapped value array
+template <class T, class U, class Compare>
+const U* RedBlackTreeSnapshot<T, U, Compare>::values() const {
+
+	return valueArr;
+
+}
+
+// HELPER FUNCTION: branch-free binary search for the first slot whose key is >= keyP,
+// the loop always runs log2(count) times so it does not mispredict
+// USED BY: find(), search(T keyP1, T keyP2)
+template <class T, class U, class Compare>
+int RedBlackTreeSnapshot<T, U, Compare>::lowerBound(const T& keyP) const {
+
+	// if snapshot is empty
+	if (count == 0) {
+		return 0;
+	}
+
+	const T* base = keyArr;
+	int n = count;
+
+	while (n > 1) {
+		int half = n / 2;
+		base = comp(base[half], keyP) ? base + half : base;
+		n -= half;
+	}
+
+	return (int)(base - keyArr) + (comp(*base, keyP) ? 1 : 0);
+
+}
@@ -11,6 +11,7 @@
 
 #include "list.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <assert.h>
 #include <pthread.h>
 
@@ -34,95 +35,117 @@ struct List_s {
     int count;
     List* pNextFreeHead;
     enum ListOutOfBounds lastOutOfBoundsReason;
+    pthread_mutex_t mutex;
 };
 
 
-static List s_heads[LIST_MAX_NUM_HEADS];
-static Node s_nodes[LIST_MAX_NUM_NODES];
+// Node and head pools: the initial heads and nodes are static, and when a free
+// list runs dry another chunk is malloc'd and linked into it. Chunks are kept for
+// the life of the process; freed heads and nodes go back onto the free lists.
+static List s_heads[LIST_INITIAL_NUM_HEADS];
+static Node s_nodes[LIST_INITIAL_NUM_NODES];
 static List *s_pFirstFreeHead;
 static Node *s_pFirstFreeNode;
-static bool s_isInitialized = false;
+static pthread_once_t s_initOnce = PTHREAD_ONCE_INIT;
+
+// Pool usage for List_getPoolStats(); the in-use counts and high-water marks are
+// updated atomically since nodes come and go through the thread caches without
+// the pool lock, the allocated counts under the pool lock
+static int s_nodesInUse = 0;
+static int s_nodesHighWater = 0;
+static int s_nodesAllocated = 0;
+static int s_headsInUse = 0;
+static int s_headsHighWater = 0;
+static int s_headsAllocated = 0;
+
+// Per-thread node cache: up to LIST_THREAD_CACHE_SIZE free nodes linked through
+// pNext, refilled from and returned to the pool half of that at a time. The key's
+// destructor returns a thread's cache to the pool when the thread exits.
+static __thread Node *t_pCachedNodes = NULL;
+static __thread int t_cachedCount = 0;
+static __thread bool t_isCacheRegistered = false;
+static pthread_key_t s_cacheKey;
 
 /* Private Headers */
 static void initializeDataStructures();
 static bool isOOBAtStart();
 static bool isOOBAtEnd();
-
-// thread-safe (recursive)
-static pthread_mutex_t s_listMutex = PTHREAD_MUTEX_INITIALIZER;
-static void mutexInitialize(void) 
-{   
-    // Recursive mutex
-    // https://stackoverflow.com/questions/7037481/c-how-do-you-declare-a-recursive-mutex-with-posix-threads
-    pthread_mutexattr_t Attr;
-    pthread_mutexattr_init(&Attr);
-    pthread_mutexattr_settype(&Attr, PTHREAD_MUTEX_RECURSIVE);
-
-    pthread_mutex_init(&s_listMutex, &Attr);
-    
-    pthread_mutexattr_destroy(&Attr);
+static Node* allocateNode(void);
+static void releaseNode(Node* pNode);
+static List* allocateHead(void);
+static void releaseHead(List* pList);
+
+// pool lock: free lists, chunk allocation and the allocated counts
+static pthread_mutex_t s_poolMutex = PTHREAD_MUTEX_INITIALIZER;
+static void poolLock(void)
+{
+    pthread_mutex_lock(&s_poolMutex);
 }
-static void mutexLock(void)
+static void poolUnlock(void)
 {
-    pthread_mutex_lock(&s_listMutex);
+    pthread_mutex_unlock(&s_poolMutex);
 }
-static void mutexUnlock(void)
+
+// Locking: every list has its own mutex, taken once by each List_* function; the
+// helpers below work on a list whose mutex the caller holds, so no lock is ever
+// re-entered and unrelated lists never wait for each other. List_concat locks its
+// two lists in address order. A list's mutex may be held while taking the pool
+// lock, never the other way round.
+static void mutexLock(List* pList)
 {
-    pthread_mutex_unlock(&s_listMutex);
+    pthread_mutex_lock(&pList->mutex);
+}
+static void mutexUnlock(List* pList)
+{
+    pthread_mutex_unlock(&pList->mutex);
 }
 
 
 List* List_create()
 {
-    if (!s_isInitialized) {
-        initializeDataStructures();
-    }
-
-    mutexLock();
+    pthread_once(&s_initOnce, initializeDataStructures);
 
     // Get next free head
-    List* pList = s_pFirstFreeHead;
-    if (pList) {
-        s_pFirstFreeHead = s_pFirstFreeHead->pNextFreeHead;
-        pList->pNextFreeHead = NULL;
-    }
+    return allocateHead();
+}
 
-    mutexUnlock();
-    return pList;
+void List_getPoolStats(ListPoolStats* pStats)
+{
+    pthread_once(&s_initOnce, initializeDataStructures);
+
+    poolLock();
+    pStats->nodesInUse = __atomic_load_n(&s_nodesInUse, __ATOMIC_RELAXED);
+    pStats->nodesHighWater = __atomic_load_n(&s_nodesHighWater, __ATOMIC_RELAXED);
+    pStats->nodesAllocated = s_nodesAllocated;
+    pStats->headsInUse = __atomic_load_n(&s_headsInUse, __ATOMIC_RELAXED);
+    pStats->headsHighWater = __atomic_load_n(&s_headsHighWater, __ATOMIC_RELAXED);
+    pStats->headsAllocated = s_headsAllocated;
+    poolUnlock();
 }
 
 
-int List_count(List* pList)
+// Helpers for a locked list
+static void* currentItem(List* pList)
 {
-    mutexLock();
-    int count = pList->count;
-    mutexUnlock();
-    return count;
+    void* pItem = NULL;
+    if (pList->pCurrentNode != NULL) {
+        pItem = pList->pCurrentNode->pItem;
+    }
+    return pItem;
 }
-
-void* List_first(List* pList)
+static void* moveToFirst(List* pList)
 {
-    mutexLock();
     // Point current to first
     pList->pCurrentNode = pList->pFirstNode;
-    void *pItem = List_curr(pList);
-    mutexUnlock();
-    return pItem;
+    return currentItem(pList);
 }
-
-void* List_last(List* pList)
+static void* moveToLast(List* pList)
 {
-    mutexLock();
     pList->pCurrentNode = pList->pLastNode;
-    void *pItem = List_curr(pList);
-    mutexUnlock();
-    return pItem;
+    return currentItem(pList);
 }
-
-
-void* List_next(List* pList)
+static void* moveToNext(List* pList)
 {
-    mutexLock();
     // When before the list, move to first node
     if (isOOBAtStart(pList)) {
         pList->pCurrentNode = pList->pFirstNode;
@@ -136,16 +159,10 @@ void* List_next(List* pList)
     if (pList->pCurrentNode == NULL) {
         pList->lastOutOfBoundsReason = LIST_OOB_END;
     }
-
-    void* pItem = List_curr(pList);
-    mutexUnlock();
-    return pItem;
+    return currentItem(pList);
 }
-
-
-void* List_prev(List* pList)
+static void* moveToPrev(List* pList)
 {
-    mutexLock();
     // When after the list, move to last node
     if (isOOBAtEnd(pList)) {
        pList->pCurrentNode = pList->pLastNode;
@@ -155,38 +172,120 @@ void* List_prev(List* pList)
         pList->pCurrentNode = pList->pCurrentNode->pPrev;
     }
 
-    // If after the list; record reason
+    // If before the list; record reason
     if (pList->pCurrentNode == NULL) {
         pList->lastOutOfBoundsReason = LIST_OOB_START;
     }
-    void* pItem = List_curr(pList);
-    mutexUnlock();
+    return currentItem(pList);
+}
+static void* removeCurrent(List* pList)
+{
+    if (pList->count == 0
+        || isOOBAtStart(pList)
+        || isOOBAtEnd(pList)
+    ) {
+        return NULL;
+    }
+
+    // Get node/item
+    Node* pRemoveNode = pList->pCurrentNode;
+    void* pItem = pRemoveNode->pItem;
+
+    // Unlink forwards
+    Node* pPrevNode = pRemoveNode->pPrev;
+    Node* pNextNode = pRemoveNode->pNext;
+    if (pPrevNode != NULL) {
+        pPrevNode->pNext = pNextNode;
+    } else {
+        pList->pFirstNode = pNextNode;
+    }
+
+    // Unlink backwards
+    if (pNextNode != NULL) {
+        pNextNode->pPrev = pPrevNode;
+    } else {
+        pList->pLastNode = pPrevNode;
+    }
+    pList->count --;
+
+    // Recover node
+    releaseNode(pRemoveNode);
+
+    // Reset current to last (smartly)
+    pList->pCurrentNode = pNextNode;
+    if (pList->pCurrentNode == NULL) {
+        pList->lastOutOfBoundsReason = LIST_OOB_END;
+    }
+    return pItem;
+}
+static void* trimLast(List* pList)
+{
+    moveToLast(pList);
+    void* pItem = removeCurrent(pList);
+    moveToLast(pList);
     return pItem;
 }
 
-void* List_curr(List* pList)
+
+int List_count(List* pList)
 {
-    mutexLock();
-    void* pItem = NULL;
-    if (pList->pCurrentNode != NULL) {
-        pItem = pList->pCurrentNode->pItem;
-    }
-    mutexUnlock();
+    mutexLock(pList);
+    int count = pList->count;
+    mutexUnlock(pList);
+    return count;
+}
+
+void* List_first(List* pList)
+{
+    mutexLock(pList);
+    void *pItem = moveToFirst(pList);
+    mutexUnlock(pList);
+    return pItem;
+}
+
+void* List_last(List* pList)
+{
+    mutexLock(pList);
+    void *pItem = moveToLast(pList);
+    mutexUnlock(pList);
     return pItem;
 }
 
 
-static bool haveNoFreeNodes()
+void* List_next(List* pList)
 {
-    return s_pFirstFreeNode == NULL;
+    mutexLock(pList);
+    void* pItem = moveToNext(pList);
+    mutexUnlock(pList);
+    return pItem;
+}
+
+
+void* List_prev(List* pList)
+{
+    mutexLock(pList);
+    void* pItem = moveToPrev(pList);
+    mutexUnlock(pList);
+    return pItem;
 }
+
+void* List_curr(List* pList)
+{
+    mutexLock(pList);
+    void* pItem = currentItem(pList);
+    mutexUnlock(pList);
+    return pItem;
+}
+
+
+// Returns NULL if the node pool could not grow
 static Node* makeNewNode(void* pItem) 
 {
-    assert(!haveNoFreeNodes());
-    Node* pNode = s_pFirstFreeNode;
-    pNode->pItem = pItem;
-    s_pFirstFreeNode = s_pFirstFreeNode->pNext;
-    pNode->pNext = NULL;
+    Node* pNode = allocateNode();
+    if (pNode != NULL) {
+        pNode->pItem = pItem;
+        pNode->pNext = NULL;
+    }
     return pNode;
 }
 static void linkNodeAtStart(List* pList, Node* pNode)
@@ -242,137 +341,101 @@ static void linkNodeAfterCurrent(List* pList, Node* pNode)
 // Add after current
 int List_add(List* pList, void* pItem)
 {
-    mutexLock();
+    mutexLock(pList);
     // Get free node
-    if (haveNoFreeNodes()) {
-        mutexUnlock();
+    Node* pNode = makeNewNode(pItem);
+    if (pNode == NULL) {
+        mutexUnlock(pList);
         return LIST_FAIL;
     }
-    Node* pNode = makeNewNode(pItem);
     
     // Insert
     linkNodeAfterCurrent(pList, pNode);
-    mutexUnlock();
+    mutexUnlock(pList);
     return LIST_SUCCESS;
 }
 
 // Add before current
 int List_insert(List* pList, void* pItem)
 {
-    mutexLock();
+    mutexLock(pList);
     // Get free node
-    if (haveNoFreeNodes()) {
-        mutexUnlock();
+    Node* pNode = makeNewNode(pItem);
+    if (pNode == NULL) {
+        mutexUnlock(pList);
         return LIST_FAIL;
     }
-    Node* pNode = makeNewNode(pItem);
     
     // Insert
-    List_prev(pList);
+    moveToPrev(pList);
     linkNodeAfterCurrent(pList, pNode);
-    mutexUnlock();
+    mutexUnlock(pList);
     return LIST_SUCCESS;
 }
 
 // Add at end
 int List_append(List* pList, void* pItem)
 {
-    mutexLock();
+    mutexLock(pList);
     // Get free node
-    if (haveNoFreeNodes()) {
-        mutexUnlock();
+    Node* pNode = makeNewNode(pItem);
+    if (pNode == NULL) {
+        mutexUnlock(pList);
         return LIST_FAIL;
     }
-    Node* pNode = makeNewNode(pItem);
     
     // Insert
     pList->pCurrentNode = pList->pLastNode;
     linkNodeAtEnd(pList, pNode);
-    mutexUnlock();
+    mutexUnlock(pList);
     return LIST_SUCCESS;
 }
 
 // Add at beginning
 int List_prepend(List* pList, void* pItem)
 {
-    mutexLock();
+    mutexLock(pList);
 
     // Get free node
-    if (haveNoFreeNodes()) {
-        mutexUnlock();
+    Node* pNode = makeNewNode(pItem);
+    if (pNode == NULL) {
+        mutexUnlock(pList);
         return LIST_FAIL;
     }
-    Node* pNode = makeNewNode(pItem);
     
     // Insert
     linkNodeAtStart(pList, pNode);
-    mutexUnlock();
+    mutexUnlock(pList);
     return LIST_SUCCESS;
 }
 
 // Remove current
 void* List_remove(List* pList)
 {
-    mutexLock();
-
-    if (pList->count == 0
-        || isOOBAtStart(pList)
-        || isOOBAtEnd(pList)
-    ) {
-        mutexUnlock();
-        return NULL;
-    }
-
-    // Get node/item
-    Node* pRemoveNode = pList->pCurrentNode;
-    void* pItem = pRemoveNode->pItem;
-
-    // Unlink forwards
-    Node* pPrevNode = pRemoveNode->pPrev;
-    Node* pNextNode = pRemoveNode->pNext;
-    if (pPrevNode != NULL) {
-        pPrevNode->pNext = pNextNode;
-    } else {
-        pList->pFirstNode = pNextNode;
-    }
-
-    // Unlink backwards
-    if (pNextNode != NULL) {
-        pNextNode->pPrev = pPrevNode;
-    } else {
-        pList->pLastNode = pPrevNode;
-    }
-    pList->count --;
-
-    // Recover node
-    pRemoveNode->pNext = s_pFirstFreeNode;
-    s_pFirstFreeNode = pRemoveNode;
-
-    // Reset current to last (smartly)
-    pList->pCurrentNode = pNextNode;
-    if (pList->pCurrentNode == NULL) {
-        pList->lastOutOfBoundsReason = LIST_OOB_END;
-    }
-    mutexUnlock();
+    mutexLock(pList);
+    void* pItem = removeCurrent(pList);
+    mutexUnlock(pList);
     return pItem;
 }
 
 // Remove last
 void* List_trim(List* pList)
 {
-    mutexLock();
-
-    List_last(pList);
-    void* pItem = List_remove(pList);
-    List_last(pList);
-    
-    mutexUnlock();
+    mutexLock(pList);
+    void* pItem = trimLast(pList);
+    mutexUnlock(pList);
     return pItem;
 }
 
 void List_concat(List* pList1, List* pList2)
 {
-    mutexLock();
+    assert(pList1 != pList2);
+
+    // Lock in address order so two concats of the same lists can't deadlock
+    List* pFirstLocked = pList1 < pList2 ? pList1 : pList2;
+    List* pSecondLocked = pList1 < pList2 ? pList2 : pList1;
+    mutexLock(pFirstLocked);
+    mutexLock(pSecondLocked);
 
     // Relink Nodes from list 2 to list 1:
     Node* pTail1 = pList1->pLastNode;
@@ -394,30 +457,40 @@ void List_concat(List* pList1, List* pList2)
     pList2->pFirstNode = NULL;
     pList2->pLastNode = NULL;
 
+    mutexUnlock(pSecondLocked);
+    mutexUnlock(pFirstLocked);
+
     // Delete the list
     // O(1) because the list is empty.
-    List_free(pList2, NULL);
-
-    mutexUnlock();
+    releaseHead(pList2);
 }
 
 void List_free(List* pList, FREE_FN pItemFreeFn)
 {
-    mutexLock();
-    // Free all nodes
-    while (List_count(pList) > 0) {
-        Node* pNode = List_trim(pList);
+    mutexLock(pList);
+    // Detach all nodes, so the free function runs without the list's mutex
+    Node* pNode = pList->pLastNode;
+    pList->pFirstNode = NULL;
+    pList->pLastNode = NULL;
+    pList->pCurrentNode = NULL;
+    pList->count = 0;
+    mutexUnlock(pList);
+
+    // Free all nodes, last first
+    while (pNode != NULL) {
+        Node* pPrevNode = pNode->pPrev;
+        void* pItem = pNode->pItem;
+        releaseNode(pNode);
 
         // Call free function (possibly cleaning up memory)
         if (pItemFreeFn != NULL) {
-            (*pItemFreeFn)(pNode);
+            (*pItemFreeFn)(pItem);
         }
+        pNode = pPrevNode;
     }
 
     // Free list
-    pList->pNextFreeHead = s_pFirstFreeHead;
-    s_pFirstFreeHead = pList;
-    mutexUnlock();
+    releaseHead(pList);
 }
 
 // Search pList, starting at the current item, until the end is reached or a match is found. 
@@ -431,21 +504,22 @@ void List_free(List* pList, FREE_FN pItemFreeFn)
 // the list and a NULL pointer is returned.
 void* List_search(List* pList, COMPARATOR_FN pComparator, void* pComparisonArg)
 {
-    mutexLock();
+    mutexLock(pList);
     if (isOOBAtStart(pList)) {
-        List_first(pList);
+        moveToFirst(pList);
     }
 
     while(pList->pCurrentNode != NULL) {
         // Match? 
         void* pItem = pList->pCurrentNode->pItem;
         if ( (*pComparator)(pItem, pComparisonArg) == 1) {
+            mutexUnlock(pList);
             return pItem;
         }
 
-        List_next(pList);
+        moveToNext(pList);
     }
-    mutexUnlock();
+    mutexUnlock(pList);
     return NULL;
 }
 
@@ -458,41 +532,191 @@ void* List_search(List* pList, COMPARATOR_FN pComparator, void* pComparisonArg)
 /*
     PRIVATE FUNCTIONS
 */
+// Links count nodes into a free list ending in pRest; returns its first node
+static Node* linkFreeNodes(Node* pNodes, int count, Node* pRest)
+{
+    for (int i = 0; i < count; i++) {
+        pNodes[i].pItem = NULL;
+        pNodes[i].pPrev = NULL;
+        pNodes[i].pNext = i + 1 < count ? &pNodes[i + 1] : pRest;
+    }
+    return &pNodes[0];
+}
+
+// Links count heads into a free list ending in pRest; returns its first head
+static List* linkFreeHeads(List* pHeads, int count, List* pRest)
+{
+    for (int i = 0; i < count; i++) {
+        pHeads[i].count = 0;
+        pHeads[i].pCurrentNode = NULL;
+        pHeads[i].lastOutOfBoundsReason = LIST_OOB_START;
+        pHeads[i].pFirstNode = NULL;
+        pHeads[i].pLastNode = NULL;
+        pHeads[i].pNextFreeHead = i + 1 < count ? &pHeads[i + 1] : pRest;
+        pthread_mutex_init(&pHeads[i].mutex, NULL);
+    }
+    return &pHeads[0];
+}
+
+// Returns the thread's cached nodes to the pool; runs when a thread that used
+// the cache exits
+static void flushThreadCache(void* pUnused)
+{
+    (void) pUnused;
+    poolLock();
+    while (t_pCachedNodes != NULL) {
+        Node* pNode = t_pCachedNodes;
+        t_pCachedNodes = pNode->pNext;
+        pNode->pNext = s_pFirstFreeNode;
+        s_pFirstFreeNode = pNode;
+    }
+    t_cachedCount = 0;
+    t_isCacheRegistered = false;
+    poolUnlock();
+}
+
 static void initializeDataStructures() {
-    mutexInitialize();
-    
-    mutexLock();
+    pthread_key_create(&s_cacheKey, flushThreadCache);
 
-    assert(LIST_MAX_NUM_NODES > 0);
-    assert(LIST_MAX_NUM_HEADS > 0);
+    assert(LIST_INITIAL_NUM_NODES > 0);
+    assert(LIST_INITIAL_NUM_HEADS > 0);
+    assert(LIST_NODE_CHUNK_SIZE > 0);
+    assert(LIST_HEAD_CHUNK_SIZE > 0);
 
+    poolLock();
 
     // Nodes
-    s_pFirstFreeNode = &s_nodes[0];
-    for (int i = 0; i < LIST_MAX_NUM_NODES; i++) {
-        s_nodes[i].pItem = NULL;
-        s_nodes[i].pPrev = NULL;
-        s_nodes[i].pNext = NULL;
-        if (i + 1 < LIST_MAX_NUM_NODES) {
-            s_nodes[i].pNext = &s_nodes[i+1];
+    s_pFirstFreeNode = linkFreeNodes(s_nodes, LIST_INITIAL_NUM_NODES, NULL);
+    s_nodesAllocated = LIST_INITIAL_NUM_NODES;
+
+    // Heads
+    s_pFirstFreeHead = linkFreeHeads(s_heads, LIST_INITIAL_NUM_HEADS, NULL);
+    s_headsAllocated = LIST_INITIAL_NUM_HEADS;
+
+    poolUnlock();
+}
+
+// Adds delta to *pInUse and raises *pHighWater to the new count if it is higher
+static void countInUse(int* pInUse, int* pHighWater, int delta)
+{
+    int inUse = __atomic_add_fetch(pInUse, delta, __ATOMIC_RELAXED);
+    int highWater = __atomic_load_n(pHighWater, __ATOMIC_RELAXED);
+    while (inUse > highWater
+        && !__atomic_compare_exchange_n(pHighWater, &highWater, inUse, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        // highWater was reloaded; try again
+    }
+}
+
+// Registers the thread's cache so it is flushed when the thread exits
+static void registerThreadCache(void)
+{
+    if (!t_isCacheRegistered) {
+        pthread_setspecific(s_cacheKey, &t_pCachedNodes);
+        t_isCacheRegistered = true;
+    }
+}
+
+// Moves up to half a cache of free nodes from the pool into the thread's cache,
+// allocating another chunk if the pool is empty. Pool lock must be held.
+static void refillThreadCache(void)
+{
+    for (int i = 0; i < LIST_THREAD_CACHE_SIZE / 2 || t_pCachedNodes == NULL; i++) {
+        if (s_pFirstFreeNode == NULL) {
+            Node* pChunk = malloc(sizeof(Node) * LIST_NODE_CHUNK_SIZE);
+            if (pChunk == NULL) {
+                return;
+            }
+            s_pFirstFreeNode = linkFreeNodes(pChunk, LIST_NODE_CHUNK_SIZE, NULL);
+            s_nodesAllocated += LIST_NODE_CHUNK_SIZE;
         }
+
+        Node* pNode = s_pFirstFreeNode;
+        s_pFirstFreeNode = pNode->pNext;
+        pNode->pNext = t_pCachedNodes;
+        t_pCachedNodes = pNode;
+        t_cachedCount++;
     }
+}
 
-    // Heads
-    s_pFirstFreeHead = &s_heads[0];
-    for (int i = 0; i < LIST_MAX_NUM_HEADS; i++) {
-        s_heads[i].count = 0;
-        s_heads[i].pCurrentNode = NULL;
-        s_heads[i].lastOutOfBoundsReason = LIST_OOB_START;
-        s_heads[i].pFirstNode = NULL;
-        s_heads[i].pLastNode = NULL;
-        s_heads[i].pNextFreeHead = NULL;
-        if (i + 1 < LIST_MAX_NUM_HEADS) {
-            s_heads[i].pNextFreeHead = &s_heads[i + 1];
+// Takes a node from the thread's cache, refilling it from the pool when empty.
+// Returns NULL if the pool could not grow.
+static Node* allocateNode(void)
+{
+    if (t_pCachedNodes == NULL) {
+        registerThreadCache();
+        poolLock();
+        refillThreadCache();
+        poolUnlock();
+        if (t_pCachedNodes == NULL) {
+            return NULL;
+        }
+    }
+
+    Node* pNode = t_pCachedNodes;
+    t_pCachedNodes = pNode->pNext;
+    t_cachedCount--;
+    countInUse(&s_nodesInUse, &s_nodesHighWater, 1);
+    return pNode;
+}
+
+// Puts a node into the thread's cache, returning half of the cache to the pool
+// when it is full
+static void releaseNode(Node* pNode)
+{
+    registerThreadCache();
+    pNode->pItem = NULL;
+    pNode->pPrev = NULL;
+    pNode->pNext = t_pCachedNodes;
+    t_pCachedNodes = pNode;
+    t_cachedCount++;
+    countInUse(&s_nodesInUse, &s_nodesHighWater, -1);
+
+    if (t_cachedCount > LIST_THREAD_CACHE_SIZE) {
+        poolLock();
+        for (int i = 0; i < LIST_THREAD_CACHE_SIZE / 2; i++) {
+            Node* pReturned = t_pCachedNodes;
+            t_pCachedNodes = pReturned->pNext;
+            pReturned->pNext = s_pFirstFreeNode;
+            s_pFirstFreeNode = pReturned;
         }
+        t_cachedCount -= LIST_THREAD_CACHE_SIZE / 2;
+        poolUnlock();
     }
-    s_isInitialized = true;
-    mutexUnlock();
+}
+
+// Takes a head from the pool, allocating another chunk if the pool is empty.
+// Returns NULL if the pool could not grow.
+static List* allocateHead(void)
+{
+    poolLock();
+    if (s_pFirstFreeHead == NULL) {
+        List* pChunk = malloc(sizeof(List) * LIST_HEAD_CHUNK_SIZE);
+        if (pChunk == NULL) {
+            poolUnlock();
+            return NULL;
+        }
+        s_pFirstFreeHead = linkFreeHeads(pChunk, LIST_HEAD_CHUNK_SIZE, NULL);
+        s_headsAllocated += LIST_HEAD_CHUNK_SIZE;
+    }
+
+    List* pList = s_pFirstFreeHead;
+    s_pFirstFreeHead = pList->pNextFreeHead;
+    pList->pNextFreeHead = NULL;
+    poolUnlock();
+
+    countInUse(&s_headsInUse, &s_headsHighWater, 1);
+    return pList;
+}
+
+// Puts an empty head back into the pool
+static void releaseHead(List* pList)
+{
+    poolLock();
+    pList->pNextFreeHead = s_pFirstFreeHead;
+    s_pFirstFreeHead = pList;
+    poolUnlock();
+
+    countInUse(&s_headsInUse, &s_headsHighWater, -1);
 }
 
 static bool isOOBAtStart(List* pList) {
@@ -24,13 +24,32 @@ typedef struct List_s List;
 struct List_s;
 
 
-// Maximum number of unique lists the system can support
+// Number of list heads statically allocated; when they are all in use, more are
+// allocated LIST_HEAD_CHUNK_SIZE at a time
 // (You may modify its value for your needs)
-#define LIST_MAX_NUM_HEADS 10
+#define LIST_INITIAL_NUM_HEADS 10
+#define LIST_HEAD_CHUNK_SIZE 16
 
-// Maximum total number of nodes (statically allocated) to be shared across all lists
+// Number of nodes statically allocated, shared across all lists; when they are all
+// in use, more are allocated LIST_NODE_CHUNK_SIZE at a time
 // (You may modify its value for your needs)
-#define LIST_MAX_NUM_NODES 100
+#define LIST_INITIAL_NUM_NODES 100
+#define LIST_NODE_CHUNK_SIZE 1024
+
+// Most free nodes each thread keeps for itself, so adding and removing items
+// rarely takes the pool lock
+#define LIST_THREAD_CACHE_SIZE 64
+
+// Pool usage, filled in by List_getPoolStats()
+typedef struct ListPoolStats_s ListPoolStats;
+struct ListPoolStats_s {
+    int nodesInUse;        // nodes holding an item
+    int nodesHighWater;    // most nodes that held an item at once
+    int nodesAllocated;    // nodes in the pool, static and allocated
+    int headsInUse;        // lists that exist
+    int headsHighWater;    // most lists that existed at once
+    int headsAllocated;    // heads in the pool, static and allocated
+};
 
 // General Error Handling:
 // Client code is assumed never to call these functions with a NULL List pointer, or 
@@ -41,6 +60,9 @@ struct List_s;
 // Returns a NULL pointer on failure.
 List* List_create();
 
+// Fills in pStats with the current use and the high-water marks of the node and head pools.
+void List_getPoolStats(ListPoolStats* pStats);
+
 // Returns the number of items in pList.
 int List_count(List* pList);
 
@@ -68,7 +90,7 @@ void* List_curr(List* pList);
 // Adds the new item to pList directly after the current item, and makes item the current item. 
 // If the current pointer is before the start of the pList, the item is added at the start. If 
 // the current pointer is beyond the end of the pList, the item is added at the end. 
-// Returns 0 on success, -1 on failure.
+// Returns 0 on success, -1 on failure (the node pool could not grow).
 int List_add(List* pList, void* pItem);
 
 // Adds item to pList directly before the current item, and makes the new item the current one. 
@@ -100,6 +122,8 @@ void List_concat(List* pList1, List* pList2);
 // pList and all its nodes no longer exists after the operation; its head and nodes are 
 // available for future operations.
 // UPDATED: Changed function pointer type, May 19
+// pItemFreeFn runs after the nodes are taken out of pList and its lock released, so it
+// may use other lists; pList itself must not be used once List_free has been called.
 typedef void (*FREE_FN)(void* pItem);
 void List_free(List* pList, FREE_FN pItemFreeFn);
 
@@ -120,6 +144,10 @@ void* List_trim(List* pList);
 // UPDATED: Added May 19
 // If the current pointer is before the start of the pList, then start searching from
 // the first node in the list (if any).
+//
+// The comparator runs while pList's lock is held (the current pointer must not move under
+// the search), so it must not call any List_* function on pList, which would deadlock;
+// other lists are fine.
 typedef bool (*COMPARATOR_FN)(void* pItem, void* pComparisonArg);
 void* List_search(List* pList, COMPARATOR_FN pComparator, void* pComparisonArg);
 
@@ -0,0 +1,175 @@
+/*
+ * list_benchmark.c
+ *
+ * Contention benchmark for list.c: N threads each append to and remove from their
+ * own list, the way lets-talk.c uses its send and receive queues, and then the same
+ * threads share one list. With one lock per list the separate lists should scale
+ * with the thread count while the shared list shows the cost of contention. Prints
+ * one JSON object per result, followed by the pool statistics.
+ *
+ * Build:
+ *	make list_benchmark
+ *
+ * Usage:
+ *	./list_benchmark [--threads=N] [--ops=M]
+ *
+ * Name: Fitz Laddaran
+ * Date: March 19, 2022
+ */
+
+#include "list.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// items each thread keeps in its list while it runs
+#define QUEUE_DEPTH 16
+
+struct worker_args {
+	List *list;			// list the thread works on
+	long ops;			// append/remove pairs to do
+	pthread_barrier_t *start;	// released once every thread is ready
+};
+
+static double now(void) {
+
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+
+}
+
+// appends an item and removes the oldest one, ops times
+static void *worker(void *ptr) {
+
+	struct worker_args *args = (struct worker_args*) ptr;
+
+	pthread_barrier_wait(args->start);
+
+	for (long i = 0; i < args->ops; i++) {
+
+		// if the pool could not grow
+		if (List_append(args->list, (void*) (i + 1)) == LIST_FAIL) {
+			printf("List_append() failed\n");
+			exit(EXIT_FAILURE);
+		}
+
+		List_first(args->list);
+		List_remove(args->list);
+
+	}
+
+	return NULL;
+
+}
+
+// runs threads workers, on one list each if shared is 0 or all on one list, and
+// prints the time per append/remove pair
+static void run(int threads, long ops, int shared) {
+
+	pthread_t *ids = malloc(sizeof(pthread_t) * threads);
+	struct worker_args *args = malloc(sizeof(struct worker_args) * threads);
+	List **lists = malloc(sizeof(List*) * threads);
+	pthread_barrier_t start;
+
+	pthread_barrier_init(&start, NULL, threads + 1);
+
+	for (int i = 0; i < threads; i++) {
+
+		lists[i] = (shared && i > 0) ? lists[0] : List_create();
+
+		// if there is no head for the list
+		if (lists[i] == NULL) {
+			printf("List_create() failed\n");
+			exit(EXIT_FAILURE);
+		}
+
+		// fill the list so the removes never empty it
+		if (!shared || i == 0) {
+			for (int j = 0; j < QUEUE_DEPTH; j++) {
+				List_append(lists[i], (void*) (long) (j + 1));
+			}
+		}
+
+		args[i].list = lists[i];
+		args[i].ops = ops;
+		args[i].start = &start;
+		pthread_create(&ids[i], NULL, worker, &args[i]);
+
+	}
+
+	double begin = now();
+	pthread_barrier_wait(&start);
+
+	for (int i = 0; i < threads; i++) {
+		pthread_join(ids[i], NULL);
+	}
+
+	double seconds = now() - begin;
+	double pairs = (double) ops * threads;
+
+	printf("{\"name\": \"append_remove\", \"lists\": \"%s\", \"threads\": %d, \"ops_per_thread\": %ld, \"ns_per_op\": %g, \"mops_per_s\": %g},\n",
+		shared ? "shared" : "separate", threads, ops, seconds * 1e9 / pairs, pairs / seconds / 1e6);
+
+	for (int i = 0; i < threads; i++) {
+		if (!shared || i == 0) {
+			List_free(lists[i], NULL);
+		}
+	}
+
+	pthread_barrier_destroy(&start);
+	free(lists);
+	free(args);
+	free(ids);
+
+}
+
+int main(int argc, char *argv[]) {
+
+	int maxThreads = 4;
+	long ops = 1000000;
+
+	for (int i = 1; i < argc; i++) {
+
+		if (strncmp(argv[i], "--threads=", 10) == 0) {
+			maxThreads = atoi(argv[i] + 10);
+		}
+
+		else if (strncmp(argv[i], "--ops=", 6) == 0) {
+			ops = atol(argv[i] + 6);
+		}
+
+		else {
+			printf("Usage:\n\t./list_benchmark [--threads=N] [--ops=M]\n");
+			return 1;
+		}
+
+	}
+
+	maxThreads = maxThreads > 0 ? maxThreads : 1;
+
+	printf("{\"benchmark\": \"list\", \"results\": [\n");
+
+	// thread counts double up to the limit and end on it
+	for (int threads = 1; ; threads = threads * 2 < maxThreads ? threads * 2 : maxThreads) {
+
+		run(threads, ops, 0);
+		run(threads, ops, 1);
+
+		if (threads == maxThreads) {
+			break;
+		}
+
+	}
+
+	ListPoolStats stats;
+	List_getPoolStats(&stats);
+	printf("{\"name\": \"pool\", \"nodes_high_water\": %d, \"nodes_allocated\": %d, \"heads_high_water\": %d, \"heads_allocated\": %d}\n",
+		stats.nodesHighWater, stats.nodesAllocated, stats.headsHighWater, stats.headsAllocated);
+	printf("]}\n");
+
+	return 0;
+
+}
@@ -1,7 +1,7 @@
 /*
 statistics.cpp
 
-The program stores doubles and calculates some basic statistics
+The program stores numbers and calculates some basic statistics
 
 Authour: Fitz Laddaran
 Contact: fitzladdaran@gmail.com
@@ -11,29 +11,581 @@ Last Updated: 27/08/2020
 #include "statistics.h"
 #include <algorithm>
 #include <cmath>
-#include <iostream>;
+#include <iostream>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <charconv>
+#include <climits>
+#include <functional>
+#include <future>
+#include <limits>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 using std::sort;
-using std::pow;
+using std::pair;
+using std::unique;
+using std::nth_element;
+using std::lower_bound;
+using std::upper_bound;
+using std::partition;
+using std::min_element;
+using std::future;
+using std::async;
+using std::numeric_limits;
+using std::from_chars;
+using std::from_chars_result;
+using std::copy;
+using std::ref;
 using std::sqrt;
+using std::exp2;
 using std::cout;
 using std::endl;
 
+// the AVX2 kernels are compiled with a per-function target attribute and chosen at
+// run time, so the file still builds and runs on x86 machines without AVX2
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define STATISTICS_AVX2_KERNELS 1
+#include <immintrin.h>
+#endif
+
+// HELPER FUNCTION: returns the sum of values[0, n); four independent accumulators
+// break the dependency chain of a single running total and add pairs of partial sums,
+// which also keeps rounding error lower than one long chain
+// USED BY: sumKernel()
+template <class T>
+static typename SequenceTraits<T>::Sum sumScalar(const T* values, int n) {
+
+	typename SequenceTraits<T>::Sum acc0 = 0, acc1 = 0, acc2 = 0, acc3 = 0; // wider than T for float and int
+	int i = 0;
+
+	for (; i + 4 <= n; i += 4) {
+		acc0 += values[i];
+		acc1 += values[i + 1];
+		acc2 += values[i + 2];
+		acc3 += values[i + 3];
+	}
+
+	for (; i < n; ++i) {
+		acc0 += values[i];
+	}
+
+	return (acc0 + acc1) + (acc2 + acc3);
+
+}
+
+// HELPER FUNCTION: returns the sum of (values[i] - center)^2 over values[0, n)
+// USED BY: squaredDeviationsKernel()
+template <class T>
+static double squaredDeviationsScalar(const T* values, int n, double center) {
+
+	double acc0 = 0, acc1 = 0, acc2 = 0, acc3 = 0;
+	int i = 0;
+
+	for (; i + 4 <= n; i += 4) {
+		double d0 = values[i] - center;
+		double d1 = values[i + 1] - center;
+		double d2 = values[i + 2] - center;
+		double d3 = values[i + 3] - center;
+		acc0 += d0 * d0;
+		acc1 += d1 * d1;
+		acc2 += d2 * d2;
+		acc3 += d3 * d3;
+	}
+
+	for (; i < n; ++i) {
+		double d = values[i] - center;
+		acc0 += d * d;
+	}
+
+	return (acc0 + acc1) + (acc2 + acc3);
+
+}
+
+// HELPER FUNCTION: returns how many of values[0, n) compare equal to value
+// USED BY: countEqualKernel()
+template <class T>
+static int countEqualScalar(const T* values, int n, T value) {
+
+	int count0 = 0, count1 = 0, count2 = 0, count3 = 0;
+	int i = 0;
+
+	for (; i + 4 <= n; i += 4) {
+		count0 += values[i] == value;
+		count1 += values[i + 1] == value;
+		count2 += values[i + 2] == value;
+		count3 += values[i + 3] == value;
+	}
+
+	for (; i < n; ++i) {
+		count0 += values[i] == value;
+	}
+
+	return count0 + count1 + count2 + count3;
+
+}
+
+#ifdef STATISTICS_AVX2_KERNELS
+
+// HELPER FUNCTION: AVX2 version of sumScalar(); four 4-lane accumulators keep
+// sixteen partial sums in flight
+// USED BY: sumKernel()
+__attribute__((target("avx2"))) static double sumAvx2(const double* values, int n) {
+
+	__m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+	__m256d acc2 = _mm256_setzero_pd(), acc3 = _mm256_setzero_pd();
+	int i = 0;
+
+	for (; i + 16 <= n; i += 16) {
+		acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(values + i));
+		acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(values + i + 4));
+		acc2 = _mm256_add_pd(acc2, _mm256_loadu_pd(values + i + 8));
+		acc3 = _mm256_add_pd(acc3, _mm256_loadu_pd(values + i + 12));
+	}
+
+	__m256d acc = _mm256_add_pd(_mm256_add_pd(acc0, acc1), _mm256_add_pd(acc2, acc3));
+	double lanes[4];
+	_mm256_storeu_pd(lanes, acc);
+
+	return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + sumScalar(values + i, n - i);
+
+}
+
+// HELPER FUNCTION: AVX2 version of squaredDeviationsScalar()
+// USED BY: squaredDeviationsKernel()
+__attribute__((target("avx2"))) static double squaredDeviationsAvx2(const double* values, int n, double center) {
+
+	const __m256d c = _mm256_set1_pd(center);
+	__m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+	__m256d acc2 = _mm256_setzero_pd(), acc3 = _mm256_setzero_pd();
+	int i = 0;
+
+	for (; i + 16 <= n; i += 16) {
+		__m256d d0 = _mm256_sub_pd(_mm256_loadu_pd(values + i), c);
+		__m256d d1 = _mm256_sub_pd(_mm256_loadu_pd(values + i + 4), c);
+		__m256d d2 = _mm256_sub_pd(_mm256_loadu_pd(values + i + 8), c);
+		__m256d d3 = _mm256_sub_pd(_mm256_loadu_pd(values + i + 12), c);
+		acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(d0, d0));
+		acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(d1, d1));
+		acc2 = _mm256_add_pd(acc2, _mm256_mul_pd(d2, d2));
+		acc3 = _mm256_add_pd(acc3, _mm256_mul_pd(d3, d3));
+	}
+
+	__m256d acc = _mm256_add_pd(_mm256_add_pd(acc0, acc1), _mm256_add_pd(acc2, acc3));
+	double lanes[4];
+	_mm256_storeu_pd(lanes, acc);
+
+	return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + squaredDeviationsScalar(values + i, n - i, center);
+
+}
+
+// HELPER FUNCTION: AVX2 version of countEqualScalar(); each compare yields a 4-bit
+// mask whose set bits are counted
+// USED BY: countEqualKernel()
+__attribute__((target("avx2,popcnt"))) static int countEqualAvx2(const double* values, int n, double value) {
+
+	const __m256d target = _mm256_set1_pd(value);
+	int count = 0;
+	int i = 0;
+
+	for (; i + 8 <= n; i += 8) {
+		int mask0 = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(values + i), target, _CMP_EQ_OQ));
+		int mask1 = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(values + i + 4), target, _CMP_EQ_OQ));
+		count += __builtin_popcount((unsigned)(mask0 | (mask1 << 4)));
+	}
+
+	return count + countEqualScalar(values + i, n - i, value);
+
+}
+
+// HELPER FUNCTION: returns true if the running CPU supports the AVX2 kernels;
+// checked once
+// USED BY: sumKernel(), squaredDeviationsKernel(), countEqualKernel()
+static bool hasAvx2() {
+
+	static const bool supported = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+	return supported;
+
+}
+
+#endif
+
+// HELPER FUNCTION: sum of values[0, n); only double has vector kernels, other types
+// use the scalar ones, which the compiler may still vectorize
+// USED BY: insert(T someArr[], int someArrSize), computeMoments()
+template <class T>
+static typename SequenceTraits<T>::Sum sumKernel(const T* values, int n) {
+
+	return sumScalar(values, n);
+
+}
+
+// HELPER FUNCTION: sum of values[0, n) using the widest kernel the CPU supports
+// USED BY: insert(T someArr[], int someArrSize), computeMoments()
+static double sumKernel(const double* values, int n) {
+
+#ifdef STATISTICS_AVX2_KERNELS
+	if (hasAvx2()) {
+		return sumAvx2(values, n);
+	}
+#endif
+	return sumScalar(values, n);
+
+}
+
+// HELPER FUNCTION: sum of squared deviations from center
+// USED BY: insert(T someArr[], int someArrSize), computeMoments()
+template <class T>
+static double squaredDeviationsKernel(const T* values, int n, double center) {
+
+	return squaredDeviationsScalar(values, n, center);
+
+}
+
+// HELPER FUNCTION: sum of squared deviations from center using the widest kernel
+// the CPU supports
+// USED BY: insert(T someArr[], int someArrSize), computeMoments()
+static double squaredDeviationsKernel(const double* values, int n, double center) {
+
+#ifdef STATISTICS_AVX2_KERNELS
+	if (hasAvx2()) {
+		return squaredDeviationsAvx2(values, n, center);
+	}
+#endif
+	return squaredDeviationsScalar(values, n, center);
+
+}
+
+// HELPER FUNCTION: count of values[0, n) equal to value
+// USED BY: find()
+template <class T>
+static int countEqualKernel(const T* values, int n, T value) {
+
+	return countEqualScalar(values, n, value);
+
+}
+
+// HELPER FUNCTION: count of values[0, n) equal to value using the widest kernel the
+// CPU supports
+// USED BY: find()
+static int countEqualKernel(const double* values, int n, double value) {
+
+#ifdef STATISTICS_AVX2_KERNELS
+	if (hasAvx2()) {
+		return countEqualAvx2(values, n, value);
+	}
+#endif
+	return countEqualScalar(values, n, value);
+
+}
+
+// bytes in a cache line, chunk boundaries fall on multiples of it
+static const int CACHE_LINE = 64;
+
+// HELPER FUNCTION: returns where chunk index of chunks equal parts of values[0, n)
+// starts; inner boundaries are moved back onto a cache-line boundary of values so
+// two threads never write to the same line
+// USED BY: runChunks()
+template <class T>
+static int chunkBoundary(const T* values, int n, int chunks, int index) {
+
+	// if this is the start of the first chunk or the end of the last one
+	if (index <= 0 || index >= chunks) {
+		return index <= 0 ? 0 : n;
+	}
+
+	int boundary = (int)((long long)n * index / chunks);
+	int misalignment = (int)((uintptr_t)(values + boundary) % CACHE_LINE / sizeof(T));
+
+	return boundary >= misalignment ? boundary - misalignment : 0;
+
+}
+
+// HELPER FUNCTION: calls task(index, begin, end) for each of the chunks parts of
+// values[0, n); every part but the last runs on its own thread and the last runs on
+// the calling thread, which then waits for the others
+// USED BY: insert(T someArr[], int someArrSize), find(), computeMoments(), selectParallel()
+template <class T, class Task>
+static void runChunks(const T* values, int n, int chunks, Task task) {
+
+	vector<future<void>> pending;
+	pending.reserve(chunks - 1);
+
+	for (int i = 0; i < chunks - 1; ++i) {
+		pending.push_back(async(std::launch::async, task, i, chunkBoundary(values, n, chunks, i), chunkBoundary(values, n, chunks, i + 1)));
+	}
+
+	task(chunks - 1, chunkBoundary(values, n, chunks, chunks - 1), n);
+
+	for (size_t i = 0; i < pending.size(); ++i) {
+		pending[i].get();
+	}
+
+}
+
+// bytes of text read at a time by insertText(), and the least each thread parses
+static const int TEXT_CHUNK_SIZE = 1 << 20;
+
+// HELPER FUNCTION: checks if c separates two numbers in a text file
+// USED BY: parseNumbers(), insertText()
+static bool isSeparator(char c) {
+
+	return c == ',' || c == ';' || c == ' ' || c == '\t' || c == '\r' || c == '\n';
+
+}
+
+// HELPER FUNCTION: appends the numbers in [first, last) to out, skipping empty fields;
+// returns false at the first field that is not a whole number
+// USED BY: insertText()
+template <class T>
+static bool parseNumbers(const char* first, const char* last, vector<T>& out) {
+
+	while (first < last) {
+
+		// if this is a separator or a leading plus sign, which from_chars does not take
+		if (isSeparator(*first) || (*first == '+' && first + 1 < last && first[1] != '-')) {
+			++first;
+			continue;
+		}
+
+		T value;
+		from_chars_result result = from_chars(first, last, value);
+
+		// if the field is not a number or does not end at a separator
+		if (result.ec != std::errc() || (result.ptr < last && !isSeparator(*result.ptr))) {
+			return false;
+		}
+
+		out.push_back(value);
+		first = result.ptr;
+
+	}
+
+	return true;
+
+}
+
+// slots in the first frequency index table
+static const int INDEX_MIN_SIZE = 16;
+
+// HELPER FUNCTION: returns a value no smaller than any T, or no larger, so a
+// selection bound can stand for "no bound"
+// USED BY: selectParallel()
+template <class T>
+static T lowestValue() {
+
+	return numeric_limits<T>::has_infinity ? -numeric_limits<T>::infinity() : numeric_limits<T>::lowest();
+
+}
+
+template <class T>
+static T highestValue() {
+
+	return numeric_limits<T>::has_infinity ? numeric_limits<T>::infinity() : numeric_limits<T>::max();
+
+}
+
+// HELPER FUNCTION: hashes value for the frequency index; 0.0 and -0.0 compare
+// equal so both hash as 0
+// USED BY: indexAdd(), indexCount()
+template <class T>
+static size_t hashValue(T value) {
+
+	T key = value == 0 ? T(0) : value;
+	unsigned long long bits = 0;
+	memcpy(&bits, &key, sizeof(key));
+	bits *= 0x9E3779B97F4A7C15ULL; // Fibonacci hashing spreads nearby values apart
+	return (size_t)(bits ^ (bits >> 32)); // fold the well mixed high bits into the masked low ones
+
+}
+
+// HELPER FUNCTION: appends the encoding of values[0, n) to out; integers are stored
+// as zigzag variable-length deltas from the previous value, so slowly changing
+// counters take a byte or two; floating values are XORed with the previous value's
+// bits and stored as a byte holding the number of zero bytes at each end of the
+// XOR followed by the bytes between them, so a repeated value takes one byte
+// USED BY: compact()
+template <class T>
+static void encodeValues(const T* values, int n, vector<unsigned char>& out) {
+
+	unsigned long long previous = 0; // the previous value, or its bits
+
+	for (int i = 0; i < n; ++i) {
+
+		if constexpr (std::is_integral<T>::value) {
+
+			unsigned long long current = (unsigned long long)(long long)values[i];
+			unsigned long long delta = current - previous;
+			unsigned long long zigzag = (delta << 1) ^ (0 - (delta >> 63)); // small negative deltas become small too
+			previous = current;
+
+			// seven bits per byte, the high bit marks that more follow
+			while (zigzag >= 0x80) {
+				out.push_back((unsigned char)(zigzag | 0x80));
+				zigzag >>= 7;
+			}
+
+			out.push_back((unsigned char)zigzag);
+
+		}
+
+		else {
+
+			unsigned long long current = 0;
+			memcpy(&current, &values[i], sizeof(T));
+			unsigned long long diff = current ^ previous;
+			previous = current;
+
+			// if the value repeats the previous one
+			if (diff == 0) {
+				out.push_back(0xFF);
+				continue;
+			}
+
+			int lead = 0; // zero bytes at the top of diff
+			int trail = 0; // zero bytes at the bottom of diff
+
+			while (((diff >> (8 * (sizeof(T) - 1 - lead))) & 0xFF) == 0) {
+				lead++;
+			}
+
+			while (((diff >> (8 * trail)) & 0xFF) == 0) {
+				trail++;
+			}
+
+			out.push_back((unsigned char)(lead << 4 | trail));
+
+			for (int b = trail; b < (int)sizeof(T) - lead; ++b) {
+				out.push_back((unsigned char)(diff >> (8 * b)));
+			}
+
+		}
+
+	}
+
+}
+
+// HELPER FUNCTION: decodes n values written by encodeValues() into out
+// USED BY: decodeInto()
+template <class T>
+static void decodeValues(const unsigned char* in, int n, T* out) {
+
+	unsigned long long previous = 0;
+
+	for (int i = 0; i < n; ++i) {
+
+		if constexpr (std::is_integral<T>::value) {
+
+			unsigned long long zigzag = 0;
+
+			for (int shift = 0; ; shift += 7) {
+
+				unsigned char byte = *in++;
+				zigzag |= (unsigned long long)(byte & 0x7F) << shift;
+
+				if (byte < 0x80) {
+					break;
+				}
+
+			}
+
+			previous += (zigzag >> 1) ^ (0 - (zigzag & 1));
+			out[i] = (T)(long long)previous;
+
+		}
+
+		else {
+
+			unsigned char header = *in++;
+
+			// if the value differs from the previous one
+			if (header != 0xFF) {
+
+				int lead = header >> 4;
+				int trail = header & 0x0F;
+				unsigned long long diff = 0;
+
+				for (int b = trail; b < (int)sizeof(T) - lead; ++b) {
+					diff |= (unsigned long long)(*in++) << (8 * b);
+				}
+
+				previous ^= diff;
+
+			}
+
+			memcpy(&out[i], &previous, sizeof(T));
+
+		}
+
+	}
+
+}
+
 // default constructor: creates array of size 2 in dynamic memory
-Sequence::Sequence() {
+template <class T>
+BasicSequence<T>::BasicSequence() {
 
 	maxSize = 2; // setting maximum size to 2
 	currSize = 0; // setting current size to 0
-	arr = new double[maxSize]; // creating array of size 2 in dynamic memory
+	arr = new T[maxSize]; // creating array of size 2 in dynamic memory
+	runSum = 0; // no values yet
+	runMean = 0;
+	runM2 = 0;
+	threadCount = 1; // serial until setThreads()
+	mapping = nullptr; // arr is owned
+	mappingSize = 0;
+	indexEnabled = false; // find() scans until setFindIndex()
+	resetIndex();
+	invalidateOrder();
 
 }
 
 // copy constructor
-Sequence::Sequence(const Sequence& mySeq) {
+template <class T>
+BasicSequence<T>::BasicSequence(const BasicSequence& mySeq) : BasicSequence(mySeq, mySeq.maxSize) {
+
+}
+
+// copies mySeq into an array of at least capacity values
+template <class T>
+BasicSequence<T>::BasicSequence(const BasicSequence& mySeq, int capacity) {
 	
 	// copying sizes of mySeq
-	maxSize = mySeq.maxSize; // copying maximum size of input parameter
+	maxSize = capacity > mySeq.currSize ? capacity : mySeq.currSize; // enough room for the values of input parameter
+	maxSize = maxSize > 0 ? maxSize : 2; // never an empty array, as in the default constructor
 	currSize = mySeq.currSize; // copying current size of input parameter
-	arr = new double[maxSize]; // initializing array to be size maxSize
+	bool stayCompact = mySeq.isCompact() && maxSize == currSize; // a plain copy of a compact sequence copies the encoding
+	arr = stayCompact ? nullptr : new T[maxSize]; // initializing array to be size maxSize
+	runSum = mySeq.runSum; // copying running statistics of input parameter
+	runMean = mySeq.runMean;
+	runM2 = mySeq.runM2;
+	threadCount = mySeq.threadCount;
+	mapping = nullptr; // the copy owns its array even if mySeq is mapped
+	mappingSize = 0;
+	indexEnabled = mySeq.indexEnabled; // the index itself is rebuilt on the first find()
+	resetIndex();
+	invalidateOrder();
+
+	// if mySeq is compact, copy or decode its encoding
+	if (mySeq.isCompact()) {
+
+		if (stayCompact) {
+			packed = mySeq.packed;
+		}
+
+		else {
+			mySeq.decodeInto(arr);
+		}
+
+		return;
+
+	}
 
 	// copying elements of mySeq
 	for (int i = 0; i < currSize; ++i) {
@@ -42,218 +594,2276 @@ Sequence::Sequence(const Sequence& mySeq) {
 	
 }
 
+// move constructor: takes over mySeq's array
+template <class T>
+BasicSequence<T>::BasicSequence(BasicSequence&& mySeq) noexcept {
+
+	arr = mySeq.arr; // taking the array of input parameter
+	currSize = mySeq.currSize;
+	maxSize = mySeq.maxSize;
+	runSum = mySeq.runSum;
+	runMean = mySeq.runMean;
+	runM2 = mySeq.runM2;
+	threadCount = mySeq.threadCount;
+	mapping = mySeq.mapping; // taking the mapping, if any, with the array
+	mappingSize = mySeq.mappingSize;
+	packed.swap(mySeq.packed);
+	scratch.swap(mySeq.scratch);
+	scratchValid = mySeq.scratchValid;
+	scratchSorted = mySeq.scratchSorted;
+	sortedSize = mySeq.sortedSize;
+	cachedMedian = mySeq.cachedMedian;
+	medianValid = mySeq.medianValid;
+	indexEnabled = mySeq.indexEnabled;
+	indexKeys.swap(mySeq.indexKeys);
+	indexCounts.swap(mySeq.indexCounts);
+	indexUsed = mySeq.indexUsed;
+	indexedSize = mySeq.indexedSize;
+
+	// leaving input parameter empty, its next insert allocates a new array
+	mySeq.arr = nullptr;
+	mySeq.mapping = nullptr;
+	mySeq.mappingSize = 0;
+	mySeq.currSize = 0;
+	mySeq.maxSize = 0;
+	mySeq.runSum = 0;
+	mySeq.runMean = 0;
+	mySeq.runM2 = 0;
+	vector<unsigned char>().swap(mySeq.packed);
+	mySeq.resetIndex();
+	mySeq.invalidateOrder();
+
+}
+
 // destructor
-Sequence::~Sequence() {
+template <class T>
+BasicSequence<T>::~BasicSequence() {
 
-	delete[] arr; // deallocate memory
-	arr = nullptr; // pointing arr to NULL
+	releaseArray(); // deallocate memory or unmap the file
 
 }
 
 // overloaded assignment operator
-Sequence& Sequence::operator=(const Sequence& mySeq) {
+template <class T>
+BasicSequence<T>& BasicSequence<T>::operator=(const BasicSequence& mySeq) {
 
-	Sequence tempSeq(mySeq); // copy constructor used to create a copy called tempSeq
-	delete[] this->arr; // deallocating memory allocated for arr of calling object (left-side of operator)
+	BasicSequence tempSeq(mySeq); // copy constructor used to create a copy called tempSeq, safe if mySeq is the calling object
+	*this = static_cast<BasicSequence&&>(tempSeq); // taking tempSeq's array instead of copying it a second time
+	
+	return *this; // return a reference to calling object
+
+}
 
-	this->currSize = tempSeq.currSize; // setting calling object's currSize to tempSeq's currSize
-	this->maxSize = tempSeq.maxSize; // setting calling object's maxSize to tempSeq's maxSize
-	this->arr = new double[this->maxSize]; // allocating memory for calling object's arr
+// move assignment operator
+template <class T>
+BasicSequence<T>& BasicSequence<T>::operator=(BasicSequence&& mySeq) noexcept {
 
-	// copying elements of tempSeq
-	for (int i = 0; i < this->currSize; ++i) {
-		this->arr[i] = tempSeq.arr[i];
+	// if mySeq is the calling object
+	if (this == &mySeq) {
+		return *this;
 	}
-	
+
+	this->releaseArray(); // deallocating memory allocated for arr of calling object (left-side of operator)
+
+	this->arr = mySeq.arr; // taking the array of input parameter
+	this->currSize = mySeq.currSize;
+	this->maxSize = mySeq.maxSize;
+	this->runSum = mySeq.runSum;
+	this->runMean = mySeq.runMean;
+	this->runM2 = mySeq.runM2;
+	this->threadCount = mySeq.threadCount;
+	this->mapping = mySeq.mapping;
+	this->mappingSize = mySeq.mappingSize;
+	this->packed.swap(mySeq.packed);
+	this->scratch.swap(mySeq.scratch);
+	this->scratchValid = mySeq.scratchValid;
+	this->scratchSorted = mySeq.scratchSorted;
+	this->sortedSize = mySeq.sortedSize;
+	this->cachedMedian = mySeq.cachedMedian;
+	this->medianValid = mySeq.medianValid;
+	this->indexEnabled = mySeq.indexEnabled;
+	this->indexKeys.swap(mySeq.indexKeys);
+	this->indexCounts.swap(mySeq.indexCounts);
+	this->indexUsed = mySeq.indexUsed;
+	this->indexedSize = mySeq.indexedSize;
+
+	// leaving input parameter empty, its next insert allocates a new array
+	mySeq.arr = nullptr;
+	mySeq.mapping = nullptr;
+	mySeq.mappingSize = 0;
+	mySeq.currSize = 0;
+	mySeq.maxSize = 0;
+	mySeq.runSum = 0;
+	mySeq.runMean = 0;
+	mySeq.runM2 = 0;
+	vector<unsigned char>().swap(mySeq.packed);
+	mySeq.resetIndex();
+	mySeq.invalidateOrder();
+
 	return *this; // return a reference to calling object
 
 }
 
 // inserts value at next available index 
-void Sequence::insert(double value) {
+template <class T>
+void BasicSequence<T>::insert(T value) {
 
 	// if array is full
 	if (currSize == maxSize) {
-
-		maxSize *= 2; // double maximum size
-		double* newArr = new double[maxSize]; // creating an array of new maxSize
-
-		// copying contents of old array to new array
-		for (int i = 0; i < currSize; ++i) {
-			newArr[i] = arr[i]; 
-		}
-
-		delete[] arr; // freeing memory associated with old array
-		arr = newArr; // assigning new array's address to object's array pointer
-
+		reallocate(maxSize > 0 ? maxSize * 2 : 2); // double maximum size, a moved-from sequence starts again at 2
 	}
 
 	arr[currSize++] = value; // inserting parameter
 
+	// Welford update: the deviation from the old and the new mean
+	// accumulates the squared deviations without cancellation
+	double delta = value - runMean;
+	runSum += value;
+	runMean += delta / currSize;
+	runM2 += delta * (value - runMean);
+	invalidateOrder();
+
 }
 
 // inserts value of someArr at the end of calling object's array
-void Sequence::insert(double someArr[], int someArrSize) {
+template <class T>
+void BasicSequence<T>::insert(T someArr[], int someArrSize) {
 
-	// if array is full 
+	// if array is full, grow to at least double so repeated bulk inserts reallocate
+	// O(log n) times rather than every time
 	if ((currSize + someArrSize) > maxSize) {
+		reallocate(currSize + someArrSize > maxSize * 2 ? currSize + someArrSize : maxSize * 2);
+	}
 
-		maxSize = currSize + someArrSize; // maxSize is changed to the equivalent of both arrays' currSize
-		double* newArr = new double[maxSize]; // creating an array of new maxSize
+	int chunks = chunkCount(someArrSize);
+
+	// if the batch is large enough to split, each thread copies its part and computes
+	// that part's moments, which are then merged in order
+	if (chunks > 1) {
+
+		T* dest = arr + currSize;
+		vector<int> counts(chunks);
+		vector<Sum> sums(chunks);
+		vector<double> m2s(chunks);
+
+		runChunks(dest, someArrSize, chunks, [&](int index, int begin, int end) {
+
+			for (int i = begin; i < end; ++i) {
+				dest[i] = someArr[i];
+			}
+
+			counts[index] = end - begin;
+			sums[index] = sumKernel(someArr + begin, end - begin);
+			m2s[index] = counts[index] > 0 ? squaredDeviationsKernel(someArr + begin, end - begin, (double)sums[index] / counts[index]) : 0;
+
+		});
+
+		for (int i = 0; i < chunks; ++i) {
+
+			// if the part is empty
+			if (counts[i] == 0) {
+				continue;
+			}
+
+			mergeMoments(counts[i], sums[i], (double)sums[i] / counts[i], m2s[i]); // while currSize still counts the earlier values
+			currSize += counts[i];
 
-		// copying contents of calling object's array
-		for (int i = 0; i < currSize; ++i) {
-			newArr[i] = arr[i];
 		}
 
-		delete[] arr; // freeing memory associated with calling object's array
-		arr = newArr; // assigning new array's address to object's array pointer
+		invalidateOrder();
+		return;
+
 	}
 
 	// copying contents of parameter array into calling object's array
 	for (int i = 0; i < someArrSize; ++i) {
-		arr[currSize++] = someArr[i];
+		arr[currSize + i] = someArr[i];
+	}
+
+	// if there is nothing to add
+	if (someArrSize <= 0) {
+		return;
 	}
 
+	// statistics of someArr alone: two vectorized passes (sum, then squared deviations
+	// about the batch mean) instead of a division per value
+	Sum batchSum = sumKernel(someArr, someArrSize);
+	double batchMean = (double)batchSum / someArrSize;
+	double batchM2 = squaredDeviationsKernel(someArr, someArrSize, batchMean);
+
+	mergeMoments(someArrSize, batchSum, batchMean, batchM2); // while currSize still counts the old values
+	currSize += someArrSize;
+	invalidateOrder();
+
 }
 
 // returns an integer equal to number of elements whose value is equal to parameter
-int Sequence::find(double value) const {
+template <class T>
+int BasicSequence<T>::find(T value) const {
 	
-	int count = 0; // counter: number of elements in arr equal to value
+	// if the index is on, count the values inserted since the last call and look value up
+	if (indexEnabled) {
 
-	// go through array to count how many elements are equal to value
-	for (int i = 0; i < currSize; ++i) {
-		if (arr[i] == value) {
-			count++; // increment count
+		// an empty index takes the values in any order, so a compact sequence need not be expanded
+		const T* values = indexedSize == 0 ? unorderedValues() : arr;
+
+		for (; indexedSize < currSize; ++indexedSize) {
+			indexAdd(values[indexedSize]);
 		}
+
+		return indexCount(value);
+
+	}
+
+	int chunks = chunkCount(currSize);
+	const T* values = unorderedValues();
+
+	// if the sequence is small or serial
+	if (chunks == 1) {
+		return countEqualKernel(values, currSize, value); // number of elements in arr equal to value
+	}
+
+	vector<int> counts(chunks); // number of matches in each part
+
+	runChunks(values, currSize, chunks, [&](int index, int begin, int end) {
+		counts[index] = countEqualKernel(values + begin, end - begin, value);
+	});
+
+	int count = 0;
+
+	for (int i = 0; i < chunks; ++i) {
+		count += counts[i];
 	}
 
-	return count; 
+	return count;
 
 }
 
 // returns an integer equal to number of values in calling object
-int Sequence::size() const {
+template <class T>
+int BasicSequence<T>::size() const {
 
 	return currSize; // return current size of array
 
 }
 
-// return a double equal to sum of values in calling object
-double Sequence::sum() const {
+// returns sum of values in calling object
+template <class T>
+typename BasicSequence<T>::Sum BasicSequence<T>::sum() const {
 	
-	double sum = 0; // counter: sum of values in array
-
-	// go through array to sum the values of all elements
-	for (int i = 0; i < currSize; ++i) {
-		sum += arr[i];
-	}
-
-	return sum; // return a double
+	return runSum; // kept up to date by insert()
 
 }
 
 // return a double equal to average of values in calling object
-double Sequence::mean() const {
+template <class T>
+double BasicSequence<T>::mean() const {
 
 	// if the sequence is empty, return 0 as instructed
 	if (size() == 0) {
 		return 0;
 	}
 
-	double mean = sum(); // get sum of all elements
-	mean /= size(); // get average by dividing number of elements in arr
-	return mean; // return a double
+	return runMean; // kept up to date by insert()
 
 }
 
 // return a double equal to median of values in calling object
-double Sequence::median() const {
+template <class T>
+double BasicSequence<T>::median() const {
 	
 	// if the sequence is empty, return 0 as instructed
 	if (size() == 0) {
 		return 0;
 	}
 
+	// if median is cached
+	if (medianValid) {
+		return cachedMedian;
+	}
+
 	int n = this->size(); // get number of elements in calling object's array
-	sort(arr, arr + n); // sort elements in calling object's array in ascending order
+	int ranks[2] = { (n - 1) / 2, n / 2 }; // the two most "inner" ranks, equal if n is odd
+	T lowValue = 0;
+	T highValue = 0;
+
+	// if the threads find both ranks, unless a sorted copy already holds them
+	if (chunkCount(n) > 1 && !(scratchValid && scratchSorted) && selectParallel(ranks[0], ranks[1], lowValue, highValue)) {
+		cachedMedian = n % 2 == 1 ? lowValue : ((double)lowValue + highValue) / 2;
+		medianValid = true;
+		return cachedMedian;
+	}
+
+	T* values = selectionBuffer();
+
+	// if the values are already sorted every rank is in place
+	if (!scratchSorted) {
+		selectRanks(values, 0, n, ranks, ranks + (n % 2 == 1 ? 1 : 2));
+	}
 
 	// if there is an odd number of elements in calling object's array
 	if (n % 2 == 1) {
-		return arr[n / 2]; // return middle element's value
+		cachedMedian = values[n / 2]; // middle element's value
 	}
 
 	// if there is an even number of elements in calling object's array
 	else {
-		return ((arr[(n - 1) / 2] + arr[n / 2]) / 2); // return average of the two most "inner" elements in calling object's array
+		cachedMedian = ((double)values[(n - 1) / 2] + values[n / 2]) / 2; // average of the two most "inner" elements
 	}
 
+	medianValid = true;
+	return cachedMedian;
+
 }
 
-// return a double equal to standard deviation of values in calling object
-double Sequence::stddev() const {
+// return a double equal to the p-quantile of values in calling object
+template <class T>
+double BasicSequence<T>::quantile(double p) const {
 
-	double mean = this->mean(); // get mean of elements
-	double standardDev = 0; // counter: standard deviation
-	double summation = 0; // counter: summation in standard deviation calculation
-	int n = this->size(); // number of elements
+	return quantiles(vector<double>(1, p))[0];
 
-	// if the sequence is empty, return 0 as instructed
+}
+
+// returns a vector holding the p-quantile of values in calling object for every p in ps,
+// every rank needed is placed by one multi-rank selection
+template <class T>
+vector<double> BasicSequence<T>::quantiles(const vector<double>& ps) const {
+
+	vector<double> result(ps.size(), 0);
+	int n = this->size(); // get number of elements in calling object's array
+
+	// if the sequence is empty, every quantile is 0 as for median()
 	if (n == 0) {
-		return 0;
+		return result;
 	}
 
-	// calculating summation 
-	for (int i = 0; i < n; ++i) {
-		summation += pow((arr[i] - mean), 2);
-	}
+	vector<double> positions(ps.size()); // fractional rank of each quantile
+	vector<int> ranks; // ranks to select, two per quantile
+	ranks.reserve(2 * ps.size());
 
-	// calculating standard deviation
-	standardDev = sqrt(summation / n);
+	for (size_t i = 0; i < ps.size(); ++i) {
 
-	return standardDev; // return standard deviation value
+		double p = ps[i];
 
-}
+		// clamp p to [0, 1], NaN counts as 0
+		if (!(p > 0)) {
+			p = 0;
+		}
+
+		else if (p > 1) {
+			p = 1;
+		}
+
+		positions[i] = p * (n - 1);
+		int low = (int)positions[i];
+		ranks.push_back(low);
+
+		if (low + 1 < n) {
+			ranks.push_back(low + 1);
+		}
 
-// returns a concatenated Sequence object
-Sequence Sequence::concatenate(const Sequence& mySeq) {
-	
-	Sequence newSeq; // calling constructor to create newSeq
-	int totalCurrSize = this->currSize + mySeq.currSize; // adding the currSize of calling object array and parameter array
-	int result = 2; // initalizing result: result is size of newArr
-	
-	// if calling object's arr and parameter's arr combined size is greater than default 
-	if (totalCurrSize > 2) {
-		result = totalCurrSize; // set result to equal to combined size
 	}
 
-	double* newArr = new double[result]; // creating an array of new max size: result
-	
-	// copy calling object's elements into newArr
-	for (int i = 0; i < this->currSize; ++i) {
-		newArr[i] = this->arr[i];
+	int chunks = chunkCount(n);
+
+	// if there are no more quantiles than threads, find each one with all threads,
+	// a quantile the threads cannot place sends every quantile to the serial path
+	if (chunks > 1 && (int)ps.size() <= chunks && !(scratchValid && scratchSorted)) {
+
+		bool found = true;
+
+		for (size_t i = 0; i < ps.size() && found; ++i) {
+
+			int low = (int)positions[i];
+			double fraction = positions[i] - low;
+			T lowValue = 0;
+			T highValue = 0;
+			found = selectParallel(low, low + 1 < n ? low + 1 : low, lowValue, highValue);
+			result[i] = lowValue;
+
+			if (fraction > 0) {
+				result[i] += fraction * ((double)highValue - lowValue);
+			}
+
+		}
+
+		if (found) {
+			return result;
+		}
+
+	}
+
+	sort(ranks.begin(), ranks.end());
+	ranks.erase(unique(ranks.begin(), ranks.end()), ranks.end());
+
+	T* values = selectionBuffer();
+
+	// if the values are already sorted every rank is in place
+	if (!scratchSorted) {
+		selectRanks(values, 0, n, ranks.data(), ranks.data() + ranks.size());
+	}
+
+	// interpolate between the two closest ranks
+	for (size_t i = 0; i < ps.size(); ++i) {
+
+		int low = (int)positions[i];
+		double fraction = positions[i] - low;
+		result[i] = values[low];
+
+		if (fraction > 0) {
+			result[i] += fraction * ((double)values[low + 1] - values[low]);
+		}
+
 	}
 
-	// copy called object's elements into newArr
-	for (int i = 0; i < mySeq.currSize; ++i) {
-		newArr[i + this->currSize] = mySeq.arr[i];
+	return result;
+
+}
+
+// return a double equal to standard deviation of values in calling object
+template <class T>
+double BasicSequence<T>::stddev() const {
+
+	int n = this->size(); // number of elements
+
+	// if the sequence is empty, return 0 as instructed
+	if (n == 0) {
+		return 0;
 	}
 
-	delete[] newSeq.arr; // freeing memory associated with newSeq's arr
-	newSeq.currSize = totalCurrSize; // set newSeq's currSize to totalCurrSize
-	newSeq.maxSize = result; // set newSeq's maxSize to result
-	newSeq.arr = newArr; // set newSeq's array to newArr
+	// runM2 is the summation of squared deviations from the mean
+	return sqrt(runM2 / n); // return standard deviation value
+
+}
+
+// returns a concatenated Sequence object
+template <class T>
+BasicSequence<T> BasicSequence<T>::concatenate(const BasicSequence& mySeq) const& {
+	
+	BasicSequence newSeq(*this, this->currSize + mySeq.currSize); // copy of calling object with room for both arrays
+	newSeq.append(mySeq); // copy parameter's elements and fold in its statistics
 
 	return newSeq; // return a Sequence object
 
 }
 
+// returns a concatenated Sequence object built in the array of a temporary calling object
+template <class T>
+BasicSequence<T> BasicSequence<T>::concatenate(const BasicSequence& mySeq) && {
+
+	append(mySeq); // extend calling object's array in place
+
+	return static_cast<BasicSequence&&>(*this); // move calling object into the result
+
+}
+
+// makes room for capacity values
+template <class T>
+void BasicSequence<T>::reserve(int capacity) {
+
+	// if the array is already large enough
+	if (capacity <= maxSize) {
+		return;
+	}
+
+	reallocate(capacity);
+
+}
+
+// returns number of values the array can hold
+template <class T>
+int BasicSequence<T>::capacity() const {
+
+	return maxSize;
+
+}
+
+// releases unused capacity
+template <class T>
+void BasicSequence<T>::shrinkToFit() {
+
+	// if the array holds more than the values
+	if (maxSize > currSize && currSize > 0) {
+		reallocate(currSize);
+	}
+
+	vector<T>().swap(scratch); // releasing the order-statistic copy, the next selection copies arr again
+	scratchValid = false;
+	resetIndex(); // the next find() rebuilds the index at its exact size
+
+}
+
+// encodes the values and releases their array
+template <class T>
+void BasicSequence<T>::compact() {
+
+	// if there is nothing to encode
+	if (isCompact() || currSize == 0) {
+		return;
+	}
+
+	encodeValues(arr, currSize, packed);
+	packed.shrink_to_fit();
+	releaseArray(); // freeing the array, or unmapping the file it was read from
+	maxSize = currSize; // full, so the next insert decodes
+	vector<T>().swap(scratch); // releasing the order-statistic copy and the index, which compact data rarely needs
+	scratchValid = false;
+	resetIndex();
+
+}
+
+// checks if the values are encoded
+template <class T>
+bool BasicSequence<T>::isCompact() const {
+
+	return !packed.empty();
+
+}
+
+// returns bytes allocated for the values, their encoding and the caches
+template <class T>
+size_t BasicSequence<T>::memory() const {
+
+	size_t bytes = packed.capacity() + scratch.capacity() * sizeof(T);
+	bytes += indexKeys.capacity() * sizeof(T) + indexCounts.capacity() * sizeof(int);
+
+	// if arr is an allocated array rather than a mapped file
+	if (arr != nullptr && mapping == nullptr) {
+		bytes += (size_t)maxSize * sizeof(T);
+	}
+
+	return bytes;
+
+}
+
+// turns the find() index on or off
+template <class T>
+void BasicSequence<T>::setFindIndex(bool enabled) {
+
+	indexEnabled = enabled;
+
+	// if the index is no longer wanted
+	if (!enabled) {
+		resetIndex();
+	}
+
+}
+
+// returns an integer equal to number of values between low and high inclusive
+template <class T>
+int BasicSequence<T>::countRange(double low, double high) const {
+
+	// if the range is empty
+	if (!(low <= high)) {
+		return 0;
+	}
+
+	const T* values = sortedValues();
+	return (int)(upper_bound(values, values + sortedSize, high) - lower_bound(values, values + sortedSize, low));
+
+}
+
+// returns the counts of bins equal-width bins between the smallest and largest value
+template <class T>
+vector<int> BasicSequence<T>::histogram(int bins) const {
+
+	vector<int> counts(bins > 0 ? bins : 0, 0);
+
+	// if there are no bins
+	if (bins <= 0) {
+		return counts;
+	}
+
+	const T* values = sortedValues();
+
+	// if there are no values other than NaN
+	if (sortedSize == 0) {
+		return counts;
+	}
+
+	const T* end = values + sortedSize;
+	double low = values[0];
+	double width = ((double)values[sortedSize - 1] - low) / bins;
+	const T* binStart = values;
+
+	// each bin ends where the next bin's lower edge begins, the last one at the end
+	for (int i = 0; i < bins; ++i) {
+
+		const T* binEnd = i + 1 < bins ? lower_bound(binStart, end, low + width * (i + 1)) : end;
+		counts[i] = (int)(binEnd - binStart);
+		binStart = binEnd;
+
+	}
+
+	return counts;
+
+}
+
 // prints Sequence
-void Sequence::print() {
+template <class T>
+void BasicSequence<T>::print() {
+
+	const T* values = arr;
+	vector<T> decoded; // insertion order of a compact sequence
+
+	if (isCompact()) {
+		decoded.resize(currSize);
+		decodeInto(decoded.data());
+		values = decoded.data();
+	}
+
+	for (int i = 0; i < currSize; ++i) {
+		cout << values[i] << endl;
+	}
+
+}
+
+// sets number of threads statistics may use
+template <class T>
+void BasicSequence<T>::setThreads(int threadCountP) {
+
+	// if the number of hardware threads was asked for
+	if (threadCountP <= 0) {
+		threadCountP = (int)std::thread::hardware_concurrency();
+	}
+
+	threadCount = threadCountP > 0 ? threadCountP : 1;
+
+}
+
+// returns number of threads statistics may use
+template <class T>
+int BasicSequence<T>::threads() const {
+
+	return threadCount;
+
+}
+
+// HELPER FUNCTION: moves the currSize values into a new array of newMaxSize values;
+// this is where a mapped sequence gets its own copy, and a compact one is decoded,
+// before the first change
+// USED BY: insert(), reserve(), shrinkToFit(), append()
+template <class T>
+void BasicSequence<T>::reallocate(int newMaxSize) {
 
-	for (int i = 0; i < maxSize; ++i) {
-		cout << arr[i] << endl;
+	T* newArr = new T[newMaxSize]; // creating an array of new maxSize
+
+	// if the values are encoded, decode them into the new array
+	if (isCompact()) {
+		decodeInto(newArr);
+		vector<unsigned char>().swap(packed);
+	}
+
+	// copying contents of old array to new array
+	else {
+		for (int i = 0; i < currSize; ++i) {
+			newArr[i] = arr[i];
+		}
+	}
+
+	releaseArray(); // freeing memory associated with old array, or unmapping the file it was read from
+	arr = newArr; // assigning new array's address to object's array pointer
+	maxSize = newMaxSize;
+
+}
+
+// HELPER FUNCTION: frees arr, or unmaps the file it points into if it came from
+// mapFile(); arr is left nullptr
+// USED BY: destructor, move assignment operator, reallocate(), mapFile()
+template <class T>
+void BasicSequence<T>::releaseArray() {
+
+	// if arr points into a mapped file
+	if (mapping != nullptr) {
+		munmap(mapping, mappingSize);
+	}
+
+	else {
+		delete[] arr;
+	}
+
+	arr = nullptr;
+	mapping = nullptr;
+	mappingSize = 0;
+
+}
+
+// HELPER FUNCTION: recalculates the running statistics of the currSize values in arr,
+// splitting them between threads as bulk inserts do
+// USED BY: mapFile()
+template <class T>
+void BasicSequence<T>::computeMoments() {
+
+	int n = currSize;
+	int chunks = chunkCount(n);
+	vector<int> counts(chunks);
+	vector<Sum> sums(chunks);
+	vector<double> m2s(chunks);
+
+	runChunks(arr, n, chunks, [&](int index, int begin, int end) {
+
+		counts[index] = end - begin;
+		sums[index] = sumKernel(arr + begin, end - begin);
+		m2s[index] = counts[index] > 0 ? squaredDeviationsKernel(arr + begin, end - begin, (double)sums[index] / counts[index]) : 0;
+
+	});
+
+	runSum = 0;
+	runMean = 0;
+	runM2 = 0;
+	currSize = 0; // counts the values folded in so far
+
+	for (int i = 0; i < chunks; ++i) {
+
+		// if the part is empty
+		if (counts[i] == 0) {
+			continue;
+		}
+
+		mergeMoments(counts[i], sums[i], (double)sums[i] / counts[i], m2s[i]);
+		currSize += counts[i];
+
+	}
+
+}
+
+// HELPER FUNCTION: adds the values of mySeq after those of the calling object and
+// folds in its running statistics; mySeq may be the calling object
+// USED BY: concatenate()
+template <class T>
+void BasicSequence<T>::append(const BasicSequence& mySeq) {
+
+	int count = mySeq.currSize; // read before the calling object changes, in case it is mySeq
+	Sum sumP = mySeq.runSum;
+	double meanP = mySeq.runMean;
+	double m2P = mySeq.runM2;
+
+	// if the array cannot hold both, grow geometrically as in insert()
+	if (currSize + count > maxSize) {
+		reallocate(currSize + count > maxSize * 2 ? currSize + count : maxSize * 2);
+	}
+
+	// decode parameter's elements after calling object's if it is compact (it cannot be
+	// the calling object, which reallocate() has decoded)
+	if (mySeq.isCompact()) {
+		mySeq.decodeInto(arr + currSize);
+	}
+
+	// copy parameter's elements after calling object's
+	else {
+		for (int i = 0; i < count; ++i) {
+			arr[currSize + i] = mySeq.arr[i];
+		}
+	}
+
+	mergeMoments(count, sumP, meanP, m2P); // while currSize still counts the calling object's values
+	currSize += count;
+	invalidateOrder();
+
+}
+
+// replaces the values with a read-only view of the file at path
+template <class T>
+bool BasicSequence<T>::mapFile(const char* path) {
+
+	int fd = ::open(path, O_RDONLY);
+
+	if (fd == -1) {
+		return false;
+	}
+
+	struct stat info;
+
+	// if the size is unknown, not a whole number of values, or more than an int can count
+	if (fstat(fd, &info) == -1 || info.st_size % sizeof(T) != 0 || info.st_size / sizeof(T) > (size_t)INT_MAX) {
+		::close(fd);
+		return false;
+	}
+
+	// if the file is empty there is nothing to map
+	if (info.st_size == 0) {
+		::close(fd);
+		releaseArray();
+		vector<unsigned char>().swap(packed);
+		arr = new T[2];
+		maxSize = 2;
+		currSize = 0;
+		runSum = 0;
+		runMean = 0;
+		runM2 = 0;
+		resetIndex();
+		invalidateOrder();
+		return true;
+	}
+
+	void* addr = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd); // the mapping stays valid after the descriptor is closed
+
+	if (addr == MAP_FAILED) {
+		return false;
+	}
+
+	releaseArray();
+	vector<unsigned char>().swap(packed);
+	mapping = addr;
+	mappingSize = info.st_size;
+	arr = static_cast<T*>(addr); // never written through while mapped, reallocate() copies first
+	maxSize = (int)(info.st_size / sizeof(T)); // full, so the next insert copies
+	currSize = maxSize;
+	resetIndex();
+	invalidateOrder();
+	computeMoments();
+
+	return true;
+
+}
+
+// writes the values as raw T values into a temporary file renamed over path
+template <class T>
+bool BasicSequence<T>::saveFile(const char* path) const {
+
+	// truncating path itself would pull the pages out from under a mapping of it,
+	// including this sequence's own if it was mapped from path
+	std::string tempPath = std::string(path) + ".tmp";
+	FILE* f = fopen(tempPath.c_str(), "wb");
+
+	if (f == nullptr) {
+		return false;
+	}
+
+	const T* values = arr;
+	vector<T> decoded; // insertion order of a compact sequence
+
+	if (isCompact()) {
+		decoded.resize(currSize);
+		decodeInto(decoded.data());
+		values = decoded.data();
+	}
+
+	bool written = fwrite(values, sizeof(T), currSize, f) == (size_t)currSize;
+	written = fclose(f) == 0 && written;
+
+	// if the file is incomplete or cannot replace path
+	if (!written || rename(tempPath.c_str(), path) != 0) {
+		remove(tempPath.c_str());
+		return false;
 	}
 
+	return true;
+
 }
+
+// inserts the numbers of the text file at path
+template <class T>
+bool BasicSequence<T>::insertText(const char* path) {
+
+	int fd = ::open(path, O_RDONLY);
+
+	if (fd == -1) {
+		return false;
+	}
+
+	struct stat info;
+
+	if (fstat(fd, &info) == -1) {
+		::close(fd);
+		return false;
+	}
+
+	int parts = (int)(info.st_size / TEXT_CHUNK_SIZE); // every thread parses at least TEXT_CHUNK_SIZE bytes
+	parts = parts < threadCount ? parts : threadCount;
+
+	// if the file is large enough to split, map it and parse its parts at once; a part
+	// ends at the first separator after its share of the bytes so no number is cut
+	if (parts > 1) {
+
+		void* addr = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+
+		if (addr == MAP_FAILED) {
+			return false;
+		}
+
+		const char* text = static_cast<const char*>(addr);
+		const char* textEnd = text + info.st_size;
+		vector<const char*> bounds(parts + 1, textEnd);
+		bounds[0] = text;
+
+		for (int i = 1; i < parts; ++i) {
+
+			const char* bound = text + (long long)info.st_size * i / parts;
+			bound = bound > bounds[i - 1] ? bound : bounds[i - 1];
+
+			while (bound < textEnd && !isSeparator(*bound)) {
+				++bound;
+			}
+
+			bounds[i] = bound;
+
+		}
+
+		vector<vector<T>> values(parts);
+		vector<future<bool>> pending;
+
+		for (int i = 0; i < parts - 1; ++i) {
+			pending.push_back(async(std::launch::async, parseNumbers<T>, bounds[i], bounds[i + 1], ref(values[i])));
+		}
+
+		bool parsed = parseNumbers(bounds[parts - 1], bounds[parts], values[parts - 1]);
+
+		for (size_t i = 0; i < pending.size(); ++i) {
+			parsed = pending[i].get() && parsed;
+		}
+
+		munmap(addr, info.st_size);
+
+		// if any part held something other than numbers, insert nothing
+		if (!parsed) {
+			return false;
+		}
+
+		for (int i = 0; i < parts; ++i) {
+			insert(values[i].data(), (int)values[i].size());
+		}
+
+		return true;
+
+	}
+
+	FILE* f = fdopen(fd, "rb");
+
+	if (f == nullptr) {
+		::close(fd);
+		return false;
+	}
+
+	vector<char> buffer(TEXT_CHUNK_SIZE);
+	vector<T> batch; // numbers of one buffer, inserted together
+	size_t filled = 0; // bytes in buffer
+	bool parsed = true;
+
+	while (parsed) {
+
+		size_t got = fread(buffer.data() + filled, 1, buffer.size() - filled, f);
+		filled += got;
+
+		// if the file is used up, the rest of the buffer is the last field
+		size_t end = filled;
+
+		if (got > 0) {
+
+			// parse up to the last separator and keep the unfinished field for the next read
+			while (end > 0 && !isSeparator(buffer[end - 1])) {
+				--end;
+			}
+
+			// if a whole buffer holds no separator the field is too long to be a number
+			if (end == 0) {
+
+				if (filled == buffer.size()) {
+					parsed = false;
+				}
+
+				continue;
+
+			}
+
+		}
+
+		batch.clear();
+		parsed = parseNumbers(buffer.data(), buffer.data() + end, batch);
+
+		if (parsed) {
+			insert(batch.data(), (int)batch.size());
+		}
+
+		// if this was the last field
+		if (got == 0) {
+			break;
+		}
+
+		copy(buffer.begin() + end, buffer.begin() + filled, buffer.begin());
+		filled -= end;
+
+	}
+
+	bool readError = ferror(f) != 0;
+	fclose(f);
+
+	return parsed && !readError;
+
+}
+
+// checks if the values are a view of a mapped file
+template <class T>
+bool BasicSequence<T>::isMapped() const {
+
+	return mapping != nullptr;
+
+}
+
+// HELPER FUNCTION: writes the currSize values encoded by compact() to out, in
+// insertion order
+// USED BY: copy constructor, print(), saveFile(), reallocate(), append(), selectionBuffer()
+template <class T>
+void BasicSequence<T>::decodeInto(T* out) const {
+
+	decodeValues(packed.data(), currSize, out);
+
+}
+
+// HELPER FUNCTION: returns the values for queries that do not depend on their order:
+// arr, or the scratch copy if the values are encoded, so a compact sequence answers
+// them without expanding
+// USED BY: find(), selectParallel()
+template <class T>
+const T* BasicSequence<T>::unorderedValues() const {
+
+	return isCompact() ? selectionBuffer() : arr;
+
+}
+
+// HELPER FUNCTION: returns the values in insertion order: arr, or buffer filled with
+// the decoded values if the sequence is compact
+// USED BY: ColumnStatistics::compute()
+template <class T>
+const T* BasicSequence<T>::orderedValues(vector<T>& buffer) const {
+
+	// if the values are held encoded
+	if (isCompact()) {
+		buffer.resize(currSize);
+		decodeInto(buffer.data());
+		return buffer.data();
+	}
+
+	return arr;
+
+}
+
+// HELPER FUNCTION: combines the running statistics of the currSize values stored
+// with those of another group of countP values (Chan et al.), which stays accurate
+// when the two means are far apart; currSize is not changed
+// USED BY: insert(T someArr[], int someArrSize), append(), computeMoments()
+template <class T>
+void BasicSequence<T>::mergeMoments(int countP, Sum sumP, double meanP, double m2P) {
+
+	// if the other group is empty
+	if (countP == 0) {
+		return;
+	}
+
+	double total = (double)currSize + countP; // number of values in both groups
+	double delta = meanP - runMean; // distance between the two means
+
+	runSum += sumP;
+	runMean += delta * countP / total;
+	runM2 += m2P + delta * delta * ((double)currSize * countP / total);
+
+}
+
+// HELPER FUNCTION: returns number of threads to split n values between, 1 below
+// PARALLEL_MIN_SIZE so small sequences do not pay for starting threads
+// USED BY: insert(T someArr[], int someArrSize), find(), median(), quantiles()
+template <class T>
+int BasicSequence<T>::chunkCount(int n) const {
+
+	// if the work is too small to split
+	if (threadCount <= 1 || n < PARALLEL_MIN_SIZE) {
+		return 1;
+	}
+
+	int chunks = n / (PARALLEL_MIN_SIZE / 2); // every part keeps at least half of PARALLEL_MIN_SIZE values
+	return chunks < threadCount ? chunks : threadCount;
+
+}
+
+// HELPER FUNCTION: finds the values of ranks lowRank and highRank (equal or adjacent)
+// without reordering arr or copying all of it; a sorted sample of arr gives two
+// bounds expected to enclose both ranks, the threads count the values below the
+// bounds and gather those between them, and only the gathered values are selected
+// from; returns false if the bounds missed the ranks so the caller can select serially
+// USED BY: median(), quantiles()
+template <class T>
+bool BasicSequence<T>::selectParallel(int lowRank, int highRank, T& lowValue, T& highValue) const {
+
+	int n = currSize;
+	int chunks = chunkCount(n);
+	const T* values = unorderedValues();
+	int sampleSize = n < (1 << 14) ? n : (1 << 14);
+	vector<T> sample(sampleSize);
+
+	// an evenly spaced sample of the values
+	for (int i = 0; i < sampleSize; ++i) {
+		sample[i] = values[(long long)n * i / sampleSize];
+	}
+
+	sort(sample.begin(), sample.end());
+
+	// the bounds sit a few standard errors of the sample rank either side of the ranks
+	int margin = 4 * (int)sqrt((double)sampleSize) + 1;
+	int lowIndex = (int)((long long)lowRank * sampleSize / n) - margin;
+	int highIndex = (int)((long long)highRank * sampleSize / n) + margin;
+	T lowBound = lowIndex > 0 ? sample[lowIndex] : lowestValue<T>();
+	T highBound = highIndex < sampleSize ? sample[highIndex] : highestValue<T>();
+
+	vector<int> below(chunks); // number of values under lowBound in each part
+	vector<vector<T>> band(chunks); // values between the bounds in each part
+
+	runChunks(values, n, chunks, [&](int index, int begin, int end) {
+
+		for (int i = begin; i < end; ++i) {
+
+			if (values[i] < lowBound) {
+				below[index]++;
+			}
+
+			else if (values[i] <= highBound) {
+				band[index].push_back(values[i]);
+			}
+
+		}
+
+	});
+
+	int belowTotal = 0;
+	size_t bandTotal = 0;
+
+	for (int i = 0; i < chunks; ++i) {
+		belowTotal += below[i];
+		bandTotal += band[i].size();
+	}
+
+	// if the bounds do not enclose both ranks
+	if (belowTotal > lowRank || (long long)belowTotal + (long long)bandTotal <= highRank) {
+		return false;
+	}
+
+	vector<T> gathered;
+	gathered.reserve(bandTotal);
+
+	for (int i = 0; i < chunks; ++i) {
+		gathered.insert(gathered.end(), band[i].begin(), band[i].end());
+	}
+
+	int low = lowRank - belowTotal;
+	nth_element(gathered.begin(), gathered.begin() + low, gathered.end());
+	lowValue = gathered[low];
+	highValue = highRank == lowRank ? lowValue : *min_element(gathered.begin() + low + 1, gathered.end()); // the next rank is the smallest value after low
+
+	return true;
+
+}
+
+// HELPER FUNCTION: marks the order-statistic cache as stale
+// USED BY: constructors, overloaded assignment operator, insert()
+template <class T>
+void BasicSequence<T>::invalidateOrder() {
+
+	scratchValid = false;
+	scratchSorted = false;
+	sortedSize = 0;
+	medianValid = false;
+
+}
+
+// HELPER FUNCTION: returns the scratch copy of the values, copying arr again only
+// after an insert; selections keep reordering the same copy, so later ones start
+// from partly ordered data
+// USED BY: median(), quantiles()
+template <class T>
+T* BasicSequence<T>::selectionBuffer() const {
+
+	if (!scratchValid) {
+
+		// if the values are encoded, decode them straight into scratch
+		if (isCompact()) {
+			scratch.resize(currSize);
+			decodeInto(scratch.data());
+		}
+
+		else {
+			scratch.assign(arr, arr + currSize);
+		}
+
+		scratchValid = true;
+		scratchSorted = false;
+
+	}
+
+	return scratch.data();
+
+}
+
+// HELPER FUNCTION: returns the scratch copy of the values fully sorted, with any
+// NaN moved after the sortedSize others since it does not compare; it stays sorted
+// until the next insert, so range queries after the first are binary searches and
+// selections find their ranks already in place
+// USED BY: countRange(), histogram()
+template <class T>
+const T* BasicSequence<T>::sortedValues() const {
+
+	T* values = selectionBuffer();
+
+	if (!scratchSorted) {
+		T* numbers = partition(values, values + currSize, [](T value) { return value == value; });
+		sort(values, numbers);
+		sortedSize = (int)(numbers - values);
+		scratchSorted = true;
+	}
+
+	return values;
+
+}
+
+// HELPER FUNCTION: empties the frequency index and frees its table
+// USED BY: constructors, move constructor, move assignment operator, shrinkToFit(),
+// setFindIndex(), mapFile()
+template <class T>
+void BasicSequence<T>::resetIndex() {
+
+	vector<T>().swap(indexKeys);
+	vector<int>().swap(indexCounts);
+	indexUsed = 0;
+	indexedSize = 0;
+
+}
+
+// HELPER FUNCTION: counts one more occurrence of value in the frequency index,
+// doubling the table when it becomes half full; NaN equals nothing, not even
+// itself, so it is left out as find() would never count it
+// USED BY: find()
+template <class T>
+void BasicSequence<T>::indexAdd(T value) const {
+
+	// if value is NaN
+	if (value != value) {
+		return;
+	}
+
+	// if one more value would fill more than half the table, rehash into one twice as large
+	if (2 * (indexUsed + 1) > (int)indexKeys.size()) {
+
+		vector<T> oldKeys;
+		vector<int> oldCounts;
+		oldKeys.swap(indexKeys);
+		oldCounts.swap(indexCounts);
+
+		size_t tableSize = oldKeys.empty() ? INDEX_MIN_SIZE : oldKeys.size() * 2;
+		indexKeys.assign(tableSize, 0);
+		indexCounts.assign(tableSize, 0);
+
+		for (size_t i = 0; i < oldKeys.size(); ++i) {
+
+			// if the slot is empty
+			if (oldCounts[i] == 0) {
+				continue;
+			}
+
+			size_t slot = hashValue(oldKeys[i]) & (tableSize - 1);
+
+			while (indexCounts[slot] != 0) {
+				slot = (slot + 1) & (tableSize - 1);
+			}
+
+			indexKeys[slot] = oldKeys[i];
+			indexCounts[slot] = oldCounts[i];
+
+		}
+
+	}
+
+	size_t mask = indexKeys.size() - 1;
+	size_t slot = hashValue(value) & mask;
+
+	// probe until value or an empty slot
+	while (indexCounts[slot] != 0 && indexKeys[slot] != value) {
+		slot = (slot + 1) & mask;
+	}
+
+	// if value is new
+	if (indexCounts[slot] == 0) {
+		indexKeys[slot] = value;
+		indexUsed++;
+	}
+
+	indexCounts[slot]++;
+
+}
+
+// HELPER FUNCTION: returns the occurrences of value recorded in the frequency index
+// USED BY: find()
+template <class T>
+int BasicSequence<T>::indexCount(T value) const {
+
+	// if the table is empty or value is NaN
+	if (indexKeys.empty() || value != value) {
+		return 0;
+	}
+
+	size_t mask = indexKeys.size() - 1;
+	size_t slot = hashValue(value) & mask;
+
+	// probe until value or an empty slot, the table is never full
+	while (indexCounts[slot] != 0) {
+
+		if (indexKeys[slot] == value) {
+			return indexCounts[slot];
+		}
+
+		slot = (slot + 1) & mask;
+
+	}
+
+	return 0;
+
+}
+
+// HELPER FUNCTION: reorders values[low, high) so each of the sorted, distinct ranks
+// [firstRank, lastRank) holds the value it would hold if sorted; selecting the middle
+// rank first splits the remaining ranks between two disjoint halves, which takes
+// O(n log k) for k ranks instead of O(n k)
+// USED BY: median(), quantiles()
+template <class T>
+void BasicSequence<T>::selectRanks(T* values, int low, int high, const int* firstRank, const int* lastRank) {
+
+	// if there are no ranks or no values left
+	if (firstRank == lastRank || low >= high) {
+		return;
+	}
+
+	const int* midRank = firstRank + (lastRank - firstRank) / 2;
+	nth_element(values + low, values + *midRank, values + high);
+
+	selectRanks(values, low, *midRank, firstRank, midRank);
+	selectRanks(values, *midRank + 1, high, midRank + 1, lastRank);
+
+}
+
+// the element types statistics.h declares
+template class BasicSequence<double>;
+template class BasicSequence<float>;
+template class BasicSequence<int>;
+template class BasicSequence<long long>;
+
+// constructor: empty sketch keeping k values in its top level
+QuantileSketch::QuantileSketch(int kP, unsigned long long seed) {
+
+	k = (kP < 8) ? 8 : kP; // tiny capacities make the estimates useless
+	n = 0;
+	minValue = 0;
+	maxValue = 0;
+	rngState = (seed == 0) ? 1 : seed; // xorshift never leaves 0
+	levels.push_back(vector<double>());
+
+}
+
+// adds value to level 0, compacting once it is full
+void QuantileSketch::insert(double value) {
+
+	if (n == 0 || value < minValue) {
+		minValue = value;
+	}
+
+	if (n == 0 || value > maxValue) {
+		maxValue = value;
+	}
+
+	n++;
+	levels[0].push_back(value);
+
+	if ((int)levels[0].size() >= levelCapacity(0)) {
+		compress();
+	}
+
+}
+
+// appends every level of sketch to the matching level, then compacts until
+// every level fits again; the result is as accurate as either input
+void QuantileSketch::merge(const QuantileSketch& sketch) {
+
+	// if sketch is empty
+	if (sketch.n == 0) {
+		return;
+	}
+
+	if (n == 0 || sketch.minValue < minValue) {
+		minValue = sketch.minValue;
+	}
+
+	if (n == 0 || sketch.maxValue > maxValue) {
+		maxValue = sketch.maxValue;
+	}
+
+	n += sketch.n;
+
+	// copy first, sketch may be this sketch
+	vector<vector<double>> incoming(sketch.levels);
+
+	for (size_t h = 0; h < incoming.size(); ++h) {
+
+		if (h == levels.size()) {
+			levels.push_back(vector<double>());
+		}
+
+		levels[h].insert(levels[h].end(), incoming[h].begin(), incoming[h].end());
+
+	}
+
+	while (compress()) {
+	}
+
+}
+
+// returns the estimate of the p-quantile
+double QuantileSketch::quantile(double p) const {
+
+	return quantiles(vector<double>(1, p))[0];
+
+}
+
+// sorts the retained values with their weights once, then answers each p by
+// finding the first value whose cumulative weight reaches p of the count
+vector<double> QuantileSketch::quantiles(const vector<double>& ps) const {
+
+	vector<double> result(ps.size(), 0);
+
+	// if no values were seen
+	if (n == 0) {
+		return result;
+	}
+
+	vector<pair<double, long long>> weighted; // retained values and their weights
+	weighted.reserve(retained());
+
+	for (size_t h = 0; h < levels.size(); ++h) {
+		for (size_t i = 0; i < levels[h].size(); ++i) {
+			weighted.push_back(pair<double, long long>(levels[h][i], 1LL << h));
+		}
+	}
+
+	sort(weighted.begin(), weighted.end());
+
+	// cumulative weights, each value's rank estimate
+	for (size_t i = 1; i < weighted.size(); ++i) {
+		weighted[i].second += weighted[i - 1].second;
+	}
+
+	long long total = weighted.back().second;
+
+	for (size_t i = 0; i < ps.size(); ++i) {
+
+		double p = ps[i];
+
+		// the extremes are known exactly, NaN counts as 0
+		if (!(p > 0)) {
+			result[i] = minValue;
+			continue;
+		}
+
+		if (p >= 1) {
+			result[i] = maxValue;
+			continue;
+		}
+
+		// binary search for the first cumulative weight >= p * total
+		double target = p * total;
+		size_t low = 0;
+		size_t high = weighted.size() - 1;
+
+		while (low < high) {
+
+			size_t mid = (low + high) / 2;
+
+			if (weighted[mid].second < target) {
+				low = mid + 1;
+			}
+
+			else {
+				high = mid;
+			}
+
+		}
+
+		result[i] = weighted[low].first;
+
+	}
+
+	return result;
+
+}
+
+// returns number of values seen
+long long QuantileSketch::count() const {
+
+	return n;
+
+}
+
+// returns number of values retained across all levels
+int QuantileSketch::retained() const {
+
+	int total = 0;
+
+	for (size_t h = 0; h < levels.size(); ++h) {
+		total += (int)levels[h].size();
+	}
+
+	return total;
+
+}
+
+// returns bytes held by the level buffers
+size_t QuantileSketch::memory() const {
+
+	size_t bytes = levels.capacity() * sizeof(vector<double>);
+
+	for (size_t h = 0; h < levels.size(); ++h) {
+		bytes += levels[h].capacity() * sizeof(double);
+	}
+
+	return bytes;
+
+}
+
+// HELPER FUNCTION: capacity of level h, k for the top level and 2/3 of the level
+// above for each level below it, never less than MIN_LEVEL_CAPACITY
+// USED BY: insert(), compress()
+int QuantileSketch::levelCapacity(size_t h) const {
+
+	double capacity = k;
+
+	for (size_t depth = h + 1; depth < levels.size(); ++depth) {
+		capacity *= 2.0 / 3.0;
+	}
+
+	return (capacity < MIN_LEVEL_CAPACITY) ? MIN_LEVEL_CAPACITY : (int)capacity;
+
+}
+
+// HELPER FUNCTION: compacts every level at or over capacity, bottom-up: sorts it and
+// moves every other value up a level, an odd value out stays behind
+// returns false if every level already fit
+// USED BY: insert(), merge()
+bool QuantileSketch::compress() {
+
+	bool compacted = false;
+
+	for (size_t h = 0; h < levels.size(); ++h) {
+
+		if ((int)levels[h].size() < levelCapacity(h)) {
+			continue;
+		}
+
+		// the top level gets a level above it
+		if (h + 1 == levels.size()) {
+			levels.push_back(vector<double>());
+		}
+
+		vector<double>& level = levels[h];
+		vector<double>& above = levels[h + 1];
+		sort(level.begin(), level.end());
+
+		bool odd = level.size() % 2 == 1;
+		double leftover = odd ? level.back() : 0;
+
+		if (odd) {
+			level.pop_back();
+		}
+
+		// keep the odd or the even positions with equal chance, so ranks stay unbiased
+		for (size_t i = nextRandom() & 1; i < level.size(); i += 2) {
+			above.push_back(level[i]);
+		}
+
+		level.clear();
+
+		if (odd) {
+			level.push_back(leftover);
+		}
+
+		compacted = true;
+
+	}
+
+	return compacted;
+
+}
+
+// HELPER FUNCTION: advances the xorshift64 generator
+// USED BY: compress()
+unsigned long long QuantileSketch::nextRandom() {
+
+	rngState ^= rngState << 13;
+	rngState ^= rngState >> 7;
+	rngState ^= rngState << 17;
+	return rngState;
+
+}
+
+// constructor: empty window of windowSizeP values, also limited to windowTimeP if positive
+WindowedSequence::WindowedSequence(int windowSizeP, double windowTimeP) {
+
+	windowSize = windowSizeP > 0 ? windowSizeP : 1; // an empty window could hold nothing
+	windowTime = windowTimeP > 0 ? windowTimeP : 0;
+	halfLife = 0; // decayed statistics are plain running ones until setHalfLife()
+	clear();
+
+}
+
+// inserts value one time unit after the previous one
+void WindowedSequence::insert(double value) {
+
+	// if value is NaN
+	if (value != value) {
+		return;
+	}
+
+	// if the window is full, the oldest value leaves
+	if (count == windowSize) {
+		evictOldest();
+	}
+
+	addDecayed(value, 1);
+	add(value, lastTime + 1);
+
+}
+
+// inserts value observed at time
+void WindowedSequence::insert(double value, double time) {
+
+	// if value is NaN
+	if (value != value) {
+		return;
+	}
+
+	expire(time);
+
+	// if the window is full, the oldest value leaves
+	if (count == windowSize) {
+		evictOldest();
+	}
+
+	addDecayed(value, count > 0 || decayWeight > 0 ? time - lastTime : 0);
+	add(value, time);
+
+}
+
+// evicts values more than windowTime before time
+void WindowedSequence::expire(double time) {
+
+	// if there is no time limit
+	if (windowTime == 0) {
+		return;
+	}
+
+	while (count > 0 && times[head] <= time - windowTime) {
+		evictOldest();
+	}
+
+}
+
+// empties the window
+void WindowedSequence::clear() {
+
+	values.clear();
+	times.clear();
+	head = 0;
+	count = 0;
+	runSum = 0;
+	runMean = 0;
+	runM2 = 0;
+	evictions = 0;
+	lower.clear();
+	upper.clear();
+	decayWeight = 0;
+	decayMean = 0;
+	decayM2 = 0;
+	lastTime = 0;
+
+}
+
+// returns an integer equal to number of values in the window
+int WindowedSequence::size() const {
+
+	return count;
+
+}
+
+// return a double equal to sum of values in the window
+double WindowedSequence::sum() const {
+
+	return runSum;
+
+}
+
+// return a double equal to average of values in the window
+double WindowedSequence::mean() const {
+
+	return count == 0 ? 0 : runMean;
+
+}
+
+// return a double equal to standard deviation of values in the window
+double WindowedSequence::stddev() const {
+
+	// if the window is empty, return 0 as Sequence does
+	if (count == 0) {
+		return 0;
+	}
+
+	return sqrt(runM2 / count);
+
+}
+
+// return a double equal to median of values in the window
+double WindowedSequence::median() const {
+
+	// if the window is empty, return 0 as Sequence does
+	if (count == 0) {
+		return 0;
+	}
+
+	// if there is an odd number of values, lower holds the middle one
+	if (count % 2 == 1) {
+		return *lower.rbegin();
+	}
+
+	return (*lower.rbegin() + *upper.begin()) / 2;
+
+}
+
+// sets the half-life of the decayed statistics
+void WindowedSequence::setHalfLife(double halfLifeP) {
+
+	halfLife = halfLifeP > 0 ? halfLifeP : 0;
+	decayWeight = 0;
+	decayMean = 0;
+	decayM2 = 0;
+
+}
+
+// return a double equal to decayed average of all values inserted
+double WindowedSequence::decayedMean() const {
+
+	return decayMean;
+
+}
+
+// return a double equal to decayed standard deviation of all values inserted
+double WindowedSequence::decayedStddev() const {
+
+	// if nothing was inserted
+	if (decayWeight == 0) {
+		return 0;
+	}
+
+	return sqrt(decayM2 / decayWeight);
+
+}
+
+// HELPER FUNCTION: appends value to the ring buffer, doubling the buffer up to
+// windowSize when it is full, and adds it to the moments and the median halves
+// USED BY: insert()
+void WindowedSequence::add(double value, double time) {
+
+	// if the buffer is full but the window is not, unroll it into a larger one
+	if (count == (int)values.size()) {
+
+		int newSize = count > 0 ? count * 2 : 16;
+		newSize = newSize < windowSize ? newSize : windowSize;
+		vector<double> newValues(newSize);
+		vector<double> newTimes(newSize);
+
+		for (int i = 0; i < count; ++i) {
+			newValues[i] = values[(head + i) % values.size()];
+			newTimes[i] = times[(head + i) % values.size()];
+		}
+
+		values.swap(newValues);
+		times.swap(newTimes);
+		head = 0;
+
+	}
+
+	int slot = (head + count) % values.size();
+	values[slot] = value;
+	times[slot] = time;
+	lastTime = time;
+	count++;
+
+	// Welford update, as in Sequence::insert(double value)
+	double delta = value - runMean;
+	runSum += value;
+	runMean += delta / count;
+	runM2 += delta * (value - runMean);
+
+	// values up to the median go to lower
+	if (lower.empty() || value <= *lower.rbegin()) {
+		lower.insert(value);
+	}
+
+	else {
+		upper.insert(value);
+	}
+
+	rebalance();
+
+}
+
+// HELPER FUNCTION: removes the oldest value; the moments are updated by reversing
+// the Welford step, and recalculated from the buffer once as many values have been
+// removed as the window now holds, so the rounding error of the reversals cannot
+// build up (amortized O(1), also when a time window holds far fewer than windowSize
+// values), and at once if the removed value made up nearly all of runM2 (over 1024
+// times what is left, about 10 bits of it), whose remainder would then be mostly
+// rounding error
+// USED BY: insert(), expire()
+void WindowedSequence::evictOldest() {
+
+	double value = values[head];
+	head = (head + 1) % values.size();
+	count--;
+
+	// if the window is now empty
+	if (count == 0) {
+		runSum = 0;
+		runMean = 0;
+		runM2 = 0;
+	}
+
+	else {
+		double delta = value - runMean;
+		runSum -= value;
+		runMean -= delta / count;
+		double removed = delta * (value - runMean); // contribution of value to runM2
+		runM2 -= removed;
+		runM2 = runM2 > 0 ? runM2 : 0;
+
+		// if value dominated the squared deviations
+		if (removed > 1024 * runM2) {
+			evictions = count;
+		}
+	}
+
+	if (++evictions >= count) {
+		recomputeMoments();
+	}
+
+	// a value equal to the largest in lower may also have copies in upper, either copy will do
+	if (value <= *lower.rbegin()) {
+		lower.erase(lower.find(value));
+	}
+
+	else {
+		upper.erase(upper.find(value));
+	}
+
+	rebalance();
+
+}
+
+// HELPER FUNCTION: moves one value between the halves until lower holds as many
+// values as upper, or one more
+// USED BY: add(), evictOldest()
+void WindowedSequence::rebalance() {
+
+	if (lower.size() > upper.size() + 1) {
+		multiset<double>::iterator largest = --lower.end();
+		upper.insert(*largest);
+		lower.erase(largest);
+	}
+
+	else if (upper.size() > lower.size()) {
+		multiset<double>::iterator smallest = upper.begin();
+		lower.insert(*smallest);
+		upper.erase(smallest);
+	}
+
+}
+
+// HELPER FUNCTION: recalculates the running statistics from the values in the
+// ring buffer with two passes
+// USED BY: evictOldest()
+void WindowedSequence::recomputeMoments() {
+
+	evictions = 0;
+	runSum = 0;
+	runM2 = 0;
+
+	for (int i = 0; i < count; ++i) {
+		runSum += values[(head + i) % values.size()];
+	}
+
+	runMean = count > 0 ? runSum / count : 0;
+
+	for (int i = 0; i < count; ++i) {
+		double delta = values[(head + i) % values.size()] - runMean;
+		runM2 += delta * delta;
+	}
+
+}
+
+// HELPER FUNCTION: scales the decayed weight and squared deviations by 2^(-elapsed / halfLife),
+// which leaves the mean unchanged, then adds value with weight 1 (West's weighted update)
+// USED BY: insert()
+void WindowedSequence::addDecayed(double value, double elapsed) {
+
+	// if decay is on and time has passed
+	if (halfLife > 0 && elapsed > 0) {
+		double factor = exp2(-elapsed / halfLife);
+		decayWeight *= factor;
+		decayM2 *= factor;
+	}
+
+	decayWeight += 1;
+	double delta = value - decayMean;
+	decayMean += delta / decayWeight;
+	decayM2 += delta * (value - decayMean);
+
+}
+
+// constructor: no columns, statistics on the calling thread
+ColumnStatistics::ColumnStatistics() {
+
+	columnCount = 0;
+	rowCount = 0;
+	threadCount = 1;
+
+}
+
+// calculates means and covariances of columns in one pass over their values
+template <class T>
+bool ColumnStatistics::compute(const vector<const BasicSequence<T>*>& columnsP) {
+
+	int m = (int)columnsP.size(); // number of columns
+	int n = m > 0 ? columnsP[0]->size() : 0; // number of rows
+
+	columnCount = 0;
+	rowCount = 0;
+	means.clear();
+	covariances.clear();
+
+	for (int c = 0; c < m; ++c) {
+
+		// if the columns do not line up
+		if (columnsP[c]->size() != n) {
+			return false;
+		}
+
+	}
+
+	vector<vector<T>> decoded(m); // copies of the compact columns
+	vector<const T*> values(m); // values of each column in order
+	vector<double> centers(m); // running mean of each column, subtracted before multiplying
+
+	for (int c = 0; c < m; ++c) {
+		values[c] = columnsP[c]->orderedValues(decoded[c]);
+		centers[c] = columnsP[c]->mean();
+	}
+
+	rowCount = n;
+
+	// if there is nothing to multiply
+	if (m == 0 || n == 0) {
+		finish(centers, vector<double>(m, 0), vector<double>((size_t)m * m, 0));
+		return true;
+	}
+
+	int chunks = 1; // number of row ranges summed at once
+
+	if (threadCount > 1 && (long long)n * m >= PARALLEL_MIN_SIZE) {
+		chunks = n / BLOCK_ROWS < threadCount ? n / BLOCK_ROWS : threadCount;
+		chunks = chunks > 1 ? chunks : 1;
+	}
+
+	// partial sums of each row range: centred values per column and cross products per pair
+	vector<vector<double>> sums(chunks, vector<double>(m, 0));
+	vector<vector<double>> products(chunks, vector<double>((size_t)m * m, 0));
+
+	runChunks(values[0], n, chunks, [&](int index, int begin, int end) {
+
+		vector<double> block((size_t)m * BLOCK_ROWS); // centred rows, column by column
+
+		for (int first = begin; first < end; first += BLOCK_ROWS) {
+
+			int rows = end - first < BLOCK_ROWS ? end - first : BLOCK_ROWS; // rows in this block
+
+			for (int c = 0; c < m; ++c) {
+
+				const T* column = values[c] + first;
+				double* centred = block.data() + (size_t)c * rows;
+				double sum = 0;
+
+				for (int r = 0; r < rows; ++r) {
+					centred[r] = (double)column[r] - centers[c];
+					sum += centred[r];
+				}
+
+				sums[index][c] += sum;
+
+			}
+
+			accumulateBlock(block.data(), rows, m, products[index].data());
+
+		}
+
+	});
+
+	// add the other ranges into the first, in a fixed order so results do not depend on timing
+	for (int i = 1; i < chunks; ++i) {
+
+		for (int c = 0; c < m; ++c) {
+			sums[0][c] += sums[i][c];
+		}
+
+		for (size_t k = 0; k < products[0].size(); ++k) {
+			products[0][k] += products[i][k];
+		}
+
+	}
+
+	finish(centers, sums[0], products[0]);
+	return true;
+
+}
+
+// returns number of columns
+int ColumnStatistics::columns() const {
+
+	return columnCount;
+
+}
+
+// returns number of rows
+int ColumnStatistics::rows() const {
+
+	return rowCount;
+
+}
+
+// returns mean of column i
+double ColumnStatistics::mean(int i) const {
+
+	// if there is no such column
+	if (i < 0 || i >= columnCount) {
+		return 0;
+	}
+
+	return means[i];
+
+}
+
+// returns standard deviation of column i
+double ColumnStatistics::stddev(int i) const {
+
+	return sqrt(covariance(i, i));
+
+}
+
+// returns covariance of columns i and j
+double ColumnStatistics::covariance(int i, int j) const {
+
+	// if either column does not exist
+	if (i < 0 || i >= columnCount || j < 0 || j >= columnCount) {
+		return 0;
+	}
+
+	return covariances[(size_t)i * columnCount + j];
+
+}
+
+// returns correlation of columns i and j
+double ColumnStatistics::correlation(int i, int j) const {
+
+	double scale = sqrt(covariance(i, i) * covariance(j, j));
+
+	// if either column is constant or does not exist
+	if (!(scale > 0)) {
+		return 0;
+	}
+
+	double r = covariance(i, j) / scale;
+
+	return r > 1 ? 1 : (r < -1 ? -1 : r); // rounding can step just outside [-1, 1]
+
+}
+
+// returns the covariance matrix
+vector<double> ColumnStatistics::covarianceMatrix() const {
+
+	return covariances;
+
+}
+
+// returns the correlation matrix
+vector<double> ColumnStatistics::correlationMatrix() const {
+
+	vector<double> result((size_t)columnCount * columnCount);
+
+	for (int i = 0; i < columnCount; ++i) {
+
+		for (int j = 0; j < columnCount; ++j) {
+			result[(size_t)i * columnCount + j] = correlation(i, j);
+		}
+
+	}
+
+	return result;
+
+}
+
+// sets the number of threads compute() may use
+void ColumnStatistics::setThreads(int threadCountP) {
+
+	// if the number of hardware threads was asked for
+	if (threadCountP <= 0) {
+		threadCountP = (int)std::thread::hardware_concurrency();
+	}
+
+	threadCount = threadCountP > 0 ? threadCountP : 1;
+
+}
+
+// returns number of threads compute() may use
+int ColumnStatistics::threads() const {
+
+	return threadCount;
+
+}
+
+// HELPER FUNCTION: adds the cross products of every pair of columns i <= j of block
+// (rows centred values per column, one column after another) to products[i * columnCountP + j];
+// the pairs go tile by tile so both tiles stay in L1, and each value of column i is
+// loaded once for four columns j
+// USED BY: compute()
+void ColumnStatistics::accumulateBlock(const double* block, int rows, int columnCountP, double* products) {
+
+	for (int tileI = 0; tileI < columnCountP; tileI += TILE_COLUMNS) {
+
+		int endI = tileI + TILE_COLUMNS < columnCountP ? tileI + TILE_COLUMNS : columnCountP;
+
+		for (int tileJ = tileI; tileJ < columnCountP; tileJ += TILE_COLUMNS) {
+
+			int endJ = tileJ + TILE_COLUMNS < columnCountP ? tileJ + TILE_COLUMNS : columnCountP;
+
+			for (int i = tileI; i < endI; ++i) {
+
+				const double* x = block + (size_t)i * rows;
+				double* out = products + (size_t)i * columnCountP;
+				int j = tileJ > i ? tileJ : i;
+
+				for (; j + 4 <= endJ; j += 4) {
+
+					const double* y0 = block + (size_t)j * rows;
+					const double* y1 = y0 + rows;
+					const double* y2 = y1 + rows;
+					const double* y3 = y2 + rows;
+					double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+
+					for (int r = 0; r < rows; ++r) {
+						double v = x[r];
+						s0 += v * y0[r];
+						s1 += v * y1[r];
+						s2 += v * y2[r];
+						s3 += v * y3[r];
+					}
+
+					out[j] += s0;
+					out[j + 1] += s1;
+					out[j + 2] += s2;
+					out[j + 3] += s3;
+
+				}
+
+				for (; j < endJ; ++j) {
+
+					const double* y = block + (size_t)j * rows;
+					double s = 0;
+
+					for (int r = 0; r < rows; ++r) {
+						s += x[r] * y[r];
+					}
+
+					out[j] += s;
+
+				}
+
+			}
+
+		}
+
+	}
+
+}
+
+// HELPER FUNCTION: sets the means and the symmetric covariance matrix from the centre
+// of each column, the sum of its centred values and the upper triangle of the summed
+// cross products; the centres are running means, so the sums are small corrections
+// USED BY: compute()
+void ColumnStatistics::finish(const vector<double>& centers, const vector<double>& sums, const vector<double>& products) {
+
+	int m = (int)centers.size();
+	double n = rowCount;
+
+	columnCount = m;
+	means.assign(m, 0);
+	covariances.assign((size_t)m * m, 0);
+
+	// if there are no rows
+	if (rowCount == 0) {
+		return;
+	}
+
+	for (int i = 0; i < m; ++i) {
+
+		means[i] = centers[i] + sums[i] / n;
+
+		for (int j = i; j < m; ++j) {
+			double value = (products[(size_t)i * m + j] - sums[i] * sums[j] / n) / n;
+			covariances[(size_t)i * m + j] = value;
+			covariances[(size_t)j * m + i] = value;
+		}
+
+	}
+
+}
+
+// fits a least-squares line through the pairs of x and y
+template <class T>
+bool linearRegression(const BasicSequence<T>& x, const BasicSequence<T>& y, LinearFit& fit) {
+
+	ColumnStatistics stats;
+	vector<const BasicSequence<T>*> columns = { &x, &y };
+
+	stats.setThreads(x.threads());
+
+	// if there is no line to fit
+	if (!stats.compute(columns) || stats.rows() == 0 || !(stats.covariance(0, 0) > 0)) {
+		return false;
+	}
+
+	double varianceX = stats.covariance(0, 0);
+	double varianceY = stats.covariance(1, 1);
+	double covarianceXY = stats.covariance(0, 1);
+
+	fit.slope = covarianceXY / varianceX;
+	fit.intercept = stats.mean(1) - fit.slope * stats.mean(0);
+	fit.correlation = stats.correlation(0, 1);
+	fit.rSquared = varianceY > 0 ? fit.correlation * fit.correlation : 1; // a constant y lies on the line
+
+	double residual = varianceY - covarianceXY * fit.slope; // variance of y left around the line
+	fit.residualStddev = residual > 0 ? sqrt(residual) : 0;
+
+	return true;
+
+}
+
+// the element types statistics.h declares
+template bool ColumnStatistics::compute(const vector<const BasicSequence<double>*>& columns);
+template bool ColumnStatistics::compute(const vector<const BasicSequence<float>*>& columns);
+template bool ColumnStatistics::compute(const vector<const BasicSequence<int>*>& columns);
+template bool ColumnStatistics::compute(const vector<const BasicSequence<long long>*>& columns);
+template bool linearRegression(const BasicSequence<double>& x, const BasicSequence<double>& y, LinearFit& fit);
+template bool linearRegression(const BasicSequence<float>& x, const BasicSequence<float>& y, LinearFit& fit);
+template bool linearRegression(const BasicSequence<int>& x, const BasicSequence<int>& y, LinearFit& fit);
+template bool linearRegression(const BasicSequence<long long>& x, const BasicSequence<long long>& y, LinearFit& fit);
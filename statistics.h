@@ -0,0 +1,462 @@
+/*
+statistics.h
+
+BasicSequence class template that stores numbers and calculates some basic
+statistics (Sequence stores doubles), QuantileSketch, which estimates quantiles
+of a stream in bounded memory, WindowedSequence, which keeps statistics of
+only the most recent values, and ColumnStatistics, which calculates means,
+covariances and correlations of several sequences at once
+
+Authour: Fitz Laddaran
+Contact: fitzladdaran@gmail.com
+Last Updated: 27/08/2020
+*/
+
+#pragma once
+#include <vector>
+#include <set>
+#include <cstddef>
+#include <type_traits>
+
+using std::vector;
+using std::multiset;
+
+class ColumnStatistics;
+
+// accumulator of BasicSequence<T>::sum(): integers add up exactly in a long long,
+// float and double in a double
+template <class T>
+struct SequenceTraits {
+	typedef typename std::conditional<std::is_integral<T>::value, long long, double>::type Sum;
+};
+
+// Stores values of type T and calculates statistics of them. The members are defined
+// in statistics.cpp for T = double, float, int and long long; means, deviations and
+// order statistics are doubles for every T.
+template <class T>
+class BasicSequence {
+
+public:
+
+	typedef typename SequenceTraits<T>::Sum Sum; // type of sum()
+
+	BasicSequence(); // default constructor
+	BasicSequence(const BasicSequence& mySeq); // copy constructor
+	BasicSequence(BasicSequence&& mySeq) noexcept; // move constructor, leaves mySeq empty
+	~BasicSequence(); // destructor
+	BasicSequence& operator=(const BasicSequence& mySeq); // overloaded assignment operator
+	BasicSequence& operator=(BasicSequence&& mySeq) noexcept; // move assignment operator, leaves mySeq empty
+
+	// inserts value at the end of the sequence
+	void insert(T value);
+
+	// inserts the someArrSize values of someArr at the end of the sequence
+	void insert(T someArr[], int someArrSize);
+
+	// returns number of elements equal to value; with the find index on, the first
+	// call counts every value into a hash table and later calls take O(1), counting
+	// only the values inserted since the previous call
+	int find(T value) const;
+
+	// turns the frequency index used by find() on or off (off by default),
+	// turning it off releases the table
+	void setFindIndex(bool enabled);
+
+	// returns number of values between low and high inclusive, by binary search in a
+	// sorted copy of the values kept until the next insert; NaN is in no range
+	int countRange(double low, double high) const;
+
+	// returns the number of values in each of bins equal-width bins spanning the
+	// smallest to the largest value, the last bin includes the largest value;
+	// served from the same sorted copy as countRange(), NaN is in no bin
+	vector<int> histogram(int bins) const;
+
+	// returns number of values in the sequence
+	int size() const;
+
+	// returns sum of the values, in O(1)
+	Sum sum() const;
+
+	// returns average of the values (0 if empty), in O(1)
+	double mean() const;
+
+	// returns median of the values (0 if empty), in linear time without reordering
+	// the sequence; the result is cached until the next insert
+	double median() const;
+
+	// returns the p-quantile of the values (0 if empty), interpolating between the
+	// two closest ranks (R type 7), p is clamped to [0, 1]
+	double quantile(double p) const;
+
+	// returns the quantile of every p in ps, sharing one selection pass
+	vector<double> quantiles(const vector<double>& ps) const;
+
+	// returns population standard deviation of the values (0 if empty), in O(1)
+	double stddev() const;
+
+	// returns a sequence holding the values of the calling object followed by those of mySeq
+	BasicSequence concatenate(const BasicSequence& mySeq) const&;
+
+	// same as above for a temporary calling object, whose array is extended and
+	// moved into the result instead of copied
+	BasicSequence concatenate(const BasicSequence& mySeq) &&;
+
+	// makes room for capacity values so inserts up to that size do not reallocate
+	void reserve(int capacity);
+
+	// returns number of values the sequence can hold before reallocating
+	int capacity() const;
+
+	// releases unused capacity and the order-statistic copy
+	void shrinkToFit();
+
+	// encodes the values losslessly into a byte stream for data that is kept but rarely
+	// read: integers as variable-length deltas, floating values as the changed bytes
+	// of each value's XOR with the one before; sum, mean, stddev, median and other
+	// cached results stay available, other queries decode into the order-statistic
+	// copy and the next insert decodes back into an array
+	void compact();
+
+	// checks if the values are held encoded by compact()
+	bool isCompact() const;
+
+	// returns bytes allocated for the values, their encoding and the caches; a mapped
+	// file is not counted
+	size_t memory() const;
+
+	// prints the sequence
+	void print();
+
+	// sets how many threads bulk inserts, find(), median() and quantiles() may use on
+	// large sequences: 1 (the default) keeps everything on the calling thread, 0 uses
+	// one per hardware thread
+	void setThreads(int threadCountP);
+
+	// returns number of threads statistics may use
+	int threads() const;
+
+	// replaces the values with a read-only view of a file of raw T values (native byte
+	// order) mapped into memory without copying; the first insert or reserve copies
+	// the values into an owned array; returns false if the file cannot be mapped or its
+	// size is not a whole number of values, leaving the sequence unchanged
+	bool mapFile(const char* path);
+
+	// writes the values as raw T values that mapFile() can read; they go into path
+	// followed by ".tmp", which is then renamed over path, so a sequence mapped from
+	// path (this one included) keeps reading the old contents and path is never left
+	// half written
+	// returns false if the file cannot be written or renamed, leaving path unchanged
+	bool saveFile(const char* path) const;
+
+	// inserts the numbers of a text or CSV file, separated by commas, semicolons or
+	// whitespace, in batches as the file is read; with several threads a large file
+	// is split at separators and its parts parsed at once
+	// returns false if the file cannot be read or holds something other than numbers,
+	// in which case values before the bad field may already be inserted
+	bool insertText(const char* path);
+
+	// checks if the values are still a view of a mapped file
+	bool isMapped() const;
+
+private:
+
+	friend class ColumnStatistics; // reads the values of each column in order
+
+	// attributes
+	T* arr; // values in insertion order, nullptr while compact
+	int currSize; // number of values stored
+	int maxSize; // capacity of arr
+	Sum runSum; // running sum of the values
+	double runMean; // running mean of the values (Welford)
+	double runM2; // running sum of squared deviations from the mean (Welford)
+	int threadCount; // threads statistics may use
+	void* mapping; // file mapped by mapFile() that arr points into, or nullptr if arr is owned
+	size_t mappingSize; // length of the mapped file
+	vector<unsigned char> packed; // values encoded by compact(), empty otherwise
+
+	// a sequence is only split between threads from this many values on
+	static const int PARALLEL_MIN_SIZE = 1 << 16;
+
+	// order-statistic cache, filled by const queries, so not safe to query from several threads at once
+	mutable vector<T> scratch; // copy of arr reordered by selection, arr keeps insertion order
+	mutable bool scratchValid; // checks if scratch holds the current values
+	mutable bool scratchSorted; // checks if scratch is fully sorted
+	mutable int sortedSize; // number of values in sorted scratch that are not NaN, the NaNs follow them
+	mutable double cachedMedian; // result of the last median()
+	mutable bool medianValid; // checks if cachedMedian is up to date
+
+	// frequency index for find(), open addressing with linear probing; a slot is
+	// empty while its count is 0
+	bool indexEnabled; // checks if find() uses the index
+	mutable vector<T> indexKeys; // distinct values, table size is a power of 2
+	mutable vector<int> indexCounts; // occurrences of each value in indexKeys
+	mutable int indexUsed; // number of distinct values in the table
+	mutable int indexedSize; // arr[0, indexedSize) has been counted
+
+	// copies mySeq into an array of at least capacity values
+	BasicSequence(const BasicSequence& mySeq, int capacity);
+
+	// helper functions
+	void reallocate(int newMaxSize); // moves the values into an array of newMaxSize
+	void releaseArray(); // frees arr or unmaps the file it points into
+	void computeMoments(); // recalculates the running statistics from arr
+	void append(const BasicSequence& mySeq); // adds the values and statistics of mySeq at the end
+	void decodeInto(T* out) const; // writes the values encoded by compact() to out in order
+	const T* unorderedValues() const; // returns the values in any order, decoded into scratch if compact
+	const T* orderedValues(vector<T>& buffer) const; // returns the values in insertion order, decoded into buffer if compact
+	void mergeMoments(int countP, Sum sumP, double meanP, double m2P); // folds another group's moments into the running ones
+	void invalidateOrder(); // drops the order-statistic cache after the values change
+	T* selectionBuffer() const; // returns scratch, refreshed from arr if needed
+	const T* sortedValues() const; // returns scratch, fully sorted
+	void resetIndex(); // empties the frequency index and releases its table
+	void indexAdd(T value) const; // counts one more occurrence of value
+	int indexCount(T value) const; // looks up the occurrences of value
+	static void selectRanks(T* values, int low, int high, const int* firstRank, const int* lastRank); // places several order statistics
+	int chunkCount(int n) const; // number of threads to split n values between
+	bool selectParallel(int lowRank, int highRank, T& lowValue, T& highValue) const; // finds two close order statistics with all threads
+
+};
+
+// the original Sequence of doubles
+typedef BasicSequence<double> Sequence;
+
+// defined in statistics.cpp
+extern template class BasicSequence<double>;
+extern template class BasicSequence<float>;
+extern template class BasicSequence<int>;
+extern template class BasicSequence<long long>;
+
+// KLL sketch: estimates quantiles of any number of doubles while keeping only
+// about 3k of them. Values live in levels; a full level is sorted and every other
+// value (odd or even positions, chosen at random) moves up a level with twice the
+// weight. The rank error is around 1.7% for k = 200 and shrinks in proportion to 1/k.
+class QuantileSketch {
+
+public:
+
+	explicit QuantileSketch(int kP = 200, unsigned long long seed = 0x9E3779B97F4A7C15ULL); // constructor, larger k is more accurate
+
+	// adds value to the stream
+	void insert(double value);
+
+	// folds in every value seen by another sketch (e.g. one per thread or shard)
+	void merge(const QuantileSketch& sketch);
+
+	// returns an estimate of the p-quantile of the values seen (0 if none),
+	// p is clamped to [0, 1] and the minimum and maximum are exact
+	double quantile(double p) const;
+
+	// returns the estimate for every p in ps, sharing one sort of the retained values
+	vector<double> quantiles(const vector<double>& ps) const;
+
+	// returns number of values seen
+	long long count() const;
+
+	// returns number of values retained
+	int retained() const;
+
+	// returns bytes held by the retained values
+	size_t memory() const;
+
+private:
+
+	// smallest capacity of any level
+	static const int MIN_LEVEL_CAPACITY = 2;
+
+	// attributes
+	vector<vector<double>> levels; // levels[h] holds values of weight 2^h
+	int k; // capacity of the top level, sets the accuracy
+	long long n; // number of values seen
+	double minValue; // smallest value seen
+	double maxValue; // largest value seen
+	unsigned long long rngState; // xorshift state for picking which half moves up
+
+	// helper functions
+	int levelCapacity(size_t h) const; // capacity of level h, shrinking by 2/3 per level below the top
+	bool compress(); // compacts every full level once
+	unsigned long long nextRandom(); // xorshift64 step
+
+};
+
+// Statistics over a sliding window: the last windowSize values, optionally also only
+// those inserted less than windowTime ago. Values sit in a ring buffer with running
+// moments, so mean and stddev take O(1), and in two multisets split at the median,
+// so median takes O(1) and each insert or eviction O(log N). Exponentially decayed
+// mean and stddev cover every value ever inserted, halving a value's weight every
+// half-life. NaN values are ignored.
+class WindowedSequence {
+
+public:
+
+	// constructor: windowSizeP values at most, and if windowTimeP > 0 only those with
+	// a time within windowTimeP of the latest; the buffer grows up to windowSizeP as needed
+	explicit WindowedSequence(int windowSizeP, double windowTimeP = 0);
+
+	// inserts value, evicting the oldest value if the window is full;
+	// for the decayed statistics every insert is one time unit after the last
+	void insert(double value);
+
+	// inserts value observed at time (non-decreasing), evicting values that are
+	// outside the window at that time
+	void insert(double value, double time);
+
+	// evicts the values outside the time window at time, without inserting
+	void expire(double time);
+
+	// empties the window and the decayed statistics
+	void clear();
+
+	// returns number of values in the window
+	int size() const;
+
+	// returns sum of the values in the window
+	double sum() const;
+
+	// returns average of the values in the window (0 if empty)
+	double mean() const;
+
+	// returns population standard deviation of the values in the window (0 if empty)
+	double stddev() const;
+
+	// returns median of the values in the window (0 if empty)
+	double median() const;
+
+	// sets the half-life of the decayed statistics, in time units for insert(value, time)
+	// and in values for insert(value); restarts them
+	void setHalfLife(double halfLifeP);
+
+	// returns exponentially decayed mean of all values inserted (0 if none)
+	double decayedMean() const;
+
+	// returns exponentially decayed population standard deviation of all values inserted (0 if none)
+	double decayedStddev() const;
+
+private:
+
+	// attributes
+	vector<double> values; // ring buffer of the values in the window
+	vector<double> times; // time of each value in values
+	int head; // index of the oldest value
+	int count; // number of values in the window
+	int windowSize; // most values kept
+	double windowTime; // values older than this are evicted, 0 if only windowSize applies
+	double runSum; // running sum of the values in the window
+	double runMean; // running mean of the values in the window (Welford)
+	double runM2; // running sum of squared deviations from the mean (Welford)
+	int evictions; // values removed since the moments were last recalculated
+	multiset<double> lower; // smaller half of the values, holds the extra value when count is odd
+	multiset<double> upper; // larger half of the values
+	double halfLife; // time or number of values after which a weight halves
+	double decayWeight; // decayed total weight of the values
+	double decayMean; // decayed mean
+	double decayM2; // decayed sum of squared deviations from the mean
+	double lastTime; // time of the latest value
+
+	// helper functions
+	void add(double value, double time); // adds value to the ring buffer, the moments and the halves
+	void evictOldest(); // removes the oldest value from the ring buffer, the moments and the halves
+	void rebalance(); // restores the size difference between lower and upper
+	void recomputeMoments(); // recalculates the moments from the ring buffer
+	void addDecayed(double value, double elapsed); // ages the decayed statistics by elapsed and adds value
+
+};
+
+// result of linearRegression()
+struct LinearFit {
+	double slope; // change in y per unit of x
+	double intercept; // y on the line at x = 0
+	double correlation; // Pearson correlation of x and y
+	double rSquared; // share of the variance of y the line explains
+	double residualStddev; // population standard deviation of y around the line
+};
+
+// Means, covariances and correlations of several sequences of equal size, each a
+// column of a table whose rows are the values at the same position. compute() reads
+// every value once: a block of rows of every column is centred into a buffer, then
+// the cross products of each pair of columns are added up tile by tile of columns
+// while the block is in cache, and with several threads each takes a range of rows
+// and the partial sums are combined at the end. Covariances are population ones, as
+// stddev() is.
+class ColumnStatistics {
+
+public:
+
+	ColumnStatistics(); // constructor, no columns
+
+	// calculates the statistics of columns, replacing any earlier ones; a compact
+	// column is decoded into a temporary copy first
+	// returns false if the columns differ in size, leaving the statistics empty
+	template <class T>
+	bool compute(const vector<const BasicSequence<T>*>& columns);
+
+	// returns number of columns of the last compute()
+	int columns() const;
+
+	// returns number of values in each column
+	int rows() const;
+
+	// returns average of column i (0 if there are no rows or i is out of range)
+	double mean(int i) const;
+
+	// returns population standard deviation of column i (0 if there are no rows or i is out of range)
+	double stddev(int i) const;
+
+	// returns population covariance of columns i and j (0 if there are no rows or i or j is out of range)
+	double covariance(int i, int j) const;
+
+	// returns correlation of columns i and j, 0 if either is constant or out of range
+	double correlation(int i, int j) const;
+
+	// returns the covariances of every pair of columns, row by row (columns() * columns() values)
+	vector<double> covarianceMatrix() const;
+
+	// returns the correlations of every pair of columns, row by row
+	vector<double> correlationMatrix() const;
+
+	// sets how many threads compute() may use on large tables: 1 (the default) keeps
+	// everything on the calling thread, 0 uses one per hardware thread
+	void setThreads(int threadCountP);
+
+	// returns number of threads compute() may use
+	int threads() const;
+
+private:
+
+	// rows centred into the buffer at a time, 2 KB of each column
+	static const int BLOCK_ROWS = 256;
+
+	// columns per tile, two tiles of a block fit in a 32 KB L1 cache
+	static const int TILE_COLUMNS = 8;
+
+	// a table is only split between threads from this many values on, and every
+	// thread gets at least BLOCK_ROWS rows
+	static const int PARALLEL_MIN_SIZE = 1 << 16;
+
+	// attributes
+	int columnCount; // number of columns
+	int rowCount; // number of values in each column
+	int threadCount; // threads compute() may use
+	vector<double> means; // mean of each column
+	vector<double> covariances; // covariance of columns i and j at i * columnCount + j
+
+	// helper functions
+	static void accumulateBlock(const double* block, int rows, int columnCountP, double* products); // adds the cross products of the columns of a centred block
+	void finish(const vector<double>& centers, const vector<double>& sums, const vector<double>& products); // turns the combined sums into means and covariances
+
+};
+
+// fits y = slope * x + intercept by least squares over the pairs (x[i], y[i]),
+// in one pass of ColumnStatistics
+// returns false if x and y differ in size, are empty or x is constant
+template <class T>
+bool linearRegression(const BasicSequence<T>& x, const BasicSequence<T>& y, LinearFit& fit);
+
+// defined in statistics.cpp
+extern template bool ColumnStatistics::compute(const vector<const BasicSequence<double>*>& columns);
+extern template bool ColumnStatistics::compute(const vector<const BasicSequence<float>*>& columns);
+extern template bool ColumnStatistics::compute(const vector<const BasicSequence<int>*>& columns);
+extern template bool ColumnStatistics::compute(const vector<const BasicSequence<long long>*>& columns);
+extern template bool linearRegression(const BasicSequence<double>& x, const BasicSequence<double>& y, LinearFit& fit);
+extern template bool linearRegression(const BasicSequence<float>& x, const BasicSequence<float>& y, LinearFit& fit);
+extern template bool linearRegression(const BasicSequence<int>& x, const BasicSequence<int>& y, LinearFit& fit);
+extern template bool linearRegression(const BasicSequence<long long>& x, const BasicSequence<long long>& y, LinearFit& fit);
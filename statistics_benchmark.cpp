@@ -0,0 +1,776 @@
+/*
+statistics_benchmark.cpp
+
+Benchmark and regression harness for statistics.cpp. Times insert, sum, mean,
+median, stddev, find and concatenate across sizes and distributions, plus
+thread scaling, allocation counts, the quantile sketch, compact storage, the
+covariance matrix of several columns and the file loaders, and prints one JSON
+object per result so two runs can be diffed line by line. With
+--compare=old.json it also reads an earlier run and exits with status 1 if any
+result slowed down by more than --threshold percent.
+
+Build:
+	make statistics_benchmark
+
+Usage:
+	statistics_benchmark [--sizes=1000,65536,1048576] [--threads=N] [--min-time=0.05]
+		[--compare=old.json] [--threshold=10] > new.json
+
+Authour: Fitz Laddaran
+Contact: fitzladdaran@gmail.com
+Last Updated: 27/08/2020
+*/
+
+#include "statistics.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+using std::map;
+using std::string;
+using std::vector;
+
+// allocations made through operator new, counted so growth strategies can be compared
+static long long allocationCount = 0;
+
+void* operator new(size_t size) {
+
+	allocationCount++;
+	void* p = malloc(size > 0 ? size : 1);
+
+	if (p == nullptr) {
+		throw std::bad_alloc();
+	}
+
+	return p;
+
+}
+
+void* operator new[](size_t size) {
+
+	return operator new(size);
+
+}
+
+void operator delete(void* p) noexcept {
+
+	free(p);
+
+}
+
+void operator delete[](void* p) noexcept {
+
+	free(p);
+
+}
+
+void operator delete(void* p, size_t) noexcept {
+
+	free(p);
+
+}
+
+void operator delete[](void* p, size_t) noexcept {
+
+	free(p);
+
+}
+
+// settings from the command line
+struct BenchmarkOptions {
+	vector<int> sizes; // numbers of values to benchmark
+	int maxThreads; // largest thread count for the scaling results
+	double minTime; // each result is timed for at least this many seconds
+	string compareFile; // earlier run to compare against, empty for none
+	double threshold; // slowdown in percent reported as a regression
+};
+
+// one timed result
+struct BenchmarkResult {
+	string name; // operation timed
+	string type; // element type of the sequence
+	string distribution; // how the values were drawn
+	int size; // number of values
+	int threads; // threads the sequence could use
+	double nsPerOp; // best time of one operation, in nanoseconds
+	double opsPerRun; // operations timed together, so throughput = opsPerRun / seconds
+	double bytes; // bytes read by one operation, 0 if not meaningful
+	long long allocations; // allocations made by one operation, -1 if not counted
+	vector<std::pair<string, double>> extras; // result-specific figures (error, memory) and their names
+};
+
+// results in the order they were measured
+static vector<BenchmarkResult> results;
+
+// keeps results alive so the compiler cannot drop the timed work
+static volatile double sink = 0;
+
+// HELPER FUNCTION: returns seconds since an arbitrary start
+// USED BY: timeBest()
+static double now() {
+
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+}
+
+// HELPER FUNCTION: runs setup() and then op() until op() has run for minTime in total
+// (at least 3 and at most 1000 times) and returns the shortest op() time in seconds;
+// allocations is set to the allocations of the last op()
+// USED BY: every benchmark
+template <class Setup, class Op>
+static double timeBest(double minTime, Setup setup, Op op, long long& allocations) {
+
+	double best = 1e300;
+	double total = 0;
+
+	for (int run = 0; run < 1000 && (run < 3 || total < minTime); ++run) {
+
+		setup();
+		long long allocationsBefore = allocationCount;
+		double start = now();
+		op();
+		double elapsed = now() - start;
+		allocations = allocationCount - allocationsBefore;
+		total += elapsed;
+		best = elapsed < best ? elapsed : best;
+
+	}
+
+	return best;
+
+}
+
+// HELPER FUNCTION: records a result
+// USED BY: every benchmark
+static void record(const string& name, const string& type, const string& distribution, int size, int threads, double seconds, double opsPerRun, double bytes, long long allocations, const vector<std::pair<string, double>>& extras = {}) {
+
+	BenchmarkResult result;
+	result.name = name;
+	result.type = type;
+	result.distribution = distribution;
+	result.size = size;
+	result.threads = threads;
+	result.nsPerOp = seconds * 1e9 / opsPerRun;
+	result.opsPerRun = opsPerRun;
+	result.bytes = bytes;
+	result.allocations = allocations;
+	result.extras = extras;
+	results.push_back(result);
+
+}
+
+// HELPER FUNCTION: returns n values drawn from the named distribution
+// USED BY: main()
+template <class T>
+static vector<T> makeValues(const string& distribution, int n) {
+
+	std::mt19937_64 rng(12345);
+	vector<T> values(n);
+
+	for (int i = 0; i < n; ++i) {
+
+		if (distribution == "uniform") {
+			values[i] = (T)std::uniform_real_distribution<double>(0, 1e6)(rng);
+		}
+
+		else if (distribution == "normal") {
+			values[i] = (T)(std::normal_distribution<double>(0, 1000)(rng));
+		}
+
+		else if (distribution == "sorted") {
+			values[i] = (T)i;
+		}
+
+		else {
+			values[i] = (T)(rng() % 100); // few distinct values
+		}
+
+	}
+
+	return values;
+
+}
+
+// HELPER FUNCTION: return the name of an element type for the results
+// USED BY: benchmarkType()
+static const char* typeName(double) {
+
+	return "double";
+
+}
+
+static const char* typeName(float) {
+
+	return "float";
+
+}
+
+static const char* typeName(int) {
+
+	return "int";
+
+}
+
+// HELPER FUNCTION: benchmarks one element type at one size and distribution with
+// the given number of threads; the full set of operations runs for double with one
+// thread, other types and thread counts run the operations they change
+// USED BY: main()
+template <class T>
+static void benchmarkType(const BenchmarkOptions& options, const string& distribution, int n, int threads, bool full) {
+
+	const char* type = typeName(T());
+	vector<T> values = makeValues<T>(distribution, n);
+	double minTime = options.minTime;
+	long long allocations = 0;
+	double seconds = 0;
+
+	BasicSequence<T> seq;
+	seq.setThreads(threads);
+	seq.insert(values.data(), n);
+
+	// bulk insert into an empty sequence
+	{
+		BasicSequence<T> target;
+		seconds = timeBest(minTime, [&]() { target = BasicSequence<T>(); target.setThreads(threads); }, [&]() { target.insert(values.data(), n); }, allocations);
+		record("insert_bulk", type, distribution, n, threads, seconds, n, (double)n * sizeof(T), allocations);
+	}
+
+	// find by linear scan, bytes read give GB/s
+	{
+		T key = values[n / 2];
+		seconds = timeBest(minTime, []() {}, [&]() { sink = sink + seq.find(key); }, allocations);
+		record("find_scan", type, distribution, n, threads, seconds, 1, (double)n * sizeof(T), allocations);
+	}
+
+	// median from a fresh copy, so nothing is cached
+	{
+		BasicSequence<T> copy;
+		seconds = timeBest(minTime, [&]() { copy = seq; }, [&]() { sink = sink + copy.median(); }, allocations);
+		record("median", type, distribution, n, threads, seconds, 1, (double)n * sizeof(T), allocations);
+	}
+
+	// if only the operations that use threads or depend on the type are wanted
+	if (!full) {
+		return;
+	}
+
+	// one insert per value, growing from the default capacity
+	{
+		BasicSequence<T> target;
+		seconds = timeBest(minTime, [&]() { target = BasicSequence<T>(); }, [&]() {
+			for (int i = 0; i < n; ++i) {
+				target.insert(values[i]);
+			}
+		}, allocations);
+		record("insert_single", type, distribution, n, threads, seconds, n, (double)n * sizeof(T), allocations);
+	}
+
+	// bulk inserts of 1000 values at a time, where geometric growth matters
+	{
+		BasicSequence<T> target;
+		seconds = timeBest(minTime, [&]() { target = BasicSequence<T>(); }, [&]() {
+			for (int i = 0; i < n; i += 1000) {
+				target.insert(values.data() + i, n - i < 1000 ? n - i : 1000);
+			}
+		}, allocations);
+		record("insert_bulk_chunks", type, distribution, n, threads, seconds, n, (double)n * sizeof(T), allocations);
+	}
+
+	// running statistics
+	seconds = timeBest(minTime, []() {}, [&]() { sink = sink + seq.sum(); }, allocations);
+	record("sum", type, distribution, n, threads, seconds, 1, 0, allocations);
+	seconds = timeBest(minTime, []() {}, [&]() { sink = sink + seq.mean(); }, allocations);
+	record("mean", type, distribution, n, threads, seconds, 1, 0, allocations);
+	seconds = timeBest(minTime, []() {}, [&]() { sink = sink + seq.stddev(); }, allocations);
+	record("stddev", type, distribution, n, threads, seconds, 1, 0, allocations);
+
+	// quantiles sharing one selection
+	{
+		BasicSequence<T> copy;
+		vector<double> ps = { 0.01, 0.25, 0.5, 0.75, 0.99 };
+		seconds = timeBest(minTime, [&]() { copy = seq; }, [&]() { sink = sink + copy.quantiles(ps)[2]; }, allocations);
+		record("quantiles_5", type, distribution, n, threads, seconds, 1, (double)n * sizeof(T), allocations);
+	}
+
+	// find through the frequency index: building it, then one lookup
+	{
+		BasicSequence<T> copy;
+		T key = values[n / 3];
+		seconds = timeBest(minTime, [&]() { copy = seq; copy.setFindIndex(true); }, [&]() { sink = sink + copy.find(key); }, allocations);
+		record("find_index_build", type, distribution, n, threads, seconds, 1, (double)n * sizeof(T), allocations);
+
+		const int lookups = 1000;
+		seconds = timeBest(minTime, []() {}, [&]() {
+			for (int i = 0; i < lookups; ++i) {
+				sink = sink + copy.find(values[(long long)i * n / lookups]);
+			}
+		}, allocations);
+		record("find_index_lookup", type, distribution, n, threads, seconds, lookups, 0, allocations);
+	}
+
+	// concatenating into a new sequence, and into a temporary's array
+	{
+		BasicSequence<T> result;
+		seconds = timeBest(minTime, [&]() { result = BasicSequence<T>(); }, [&]() { result = seq.concatenate(seq); }, allocations);
+		record("concatenate", type, distribution, n, threads, seconds, 2.0 * n, 2.0 * n * sizeof(T), allocations);
+
+		BasicSequence<T> temporary;
+		seconds = timeBest(minTime, [&]() { temporary = seq; temporary.reserve(2 * n); result = BasicSequence<T>(); }, [&]() { result = std::move(temporary).concatenate(seq); }, allocations);
+		record("concatenate_rvalue", type, distribution, n, threads, seconds, n, (double)n * sizeof(T), allocations);
+	}
+
+	// compact storage: time to encode and bytes kept per value
+	{
+		BasicSequence<T> copy;
+		seconds = timeBest(minTime, [&]() { copy = seq; copy.shrinkToFit(); }, [&]() { copy.compact(); }, allocations);
+		record("compact", type, distribution, n, threads, seconds, n, (double)n * sizeof(T), allocations, { { "bytes_per_value", (double)copy.memory() / n } });
+	}
+
+}
+
+// HELPER FUNCTION: times the covariance matrix of 32 columns holding n values in
+// total with ColumnStatistics, and by hand with a pass over each pair of columns
+// USED BY: main()
+static void benchmarkColumns(const BenchmarkOptions& options, int n, int threads) {
+
+	const int m = 32; // number of columns
+	int rows = n / m > 0 ? n / m : 1;
+	vector<Sequence> columns(m);
+	vector<const Sequence*> pointers(m);
+	vector<vector<double>> values(m);
+	long long allocations = 0;
+
+	for (int c = 0; c < m; ++c) {
+		values[c] = makeValues<double>(c % 2 == 0 ? "uniform" : "normal", rows);
+		columns[c].insert(values[c].data(), rows);
+		pointers[c] = &columns[c];
+	}
+
+	ColumnStatistics stats;
+	stats.setThreads(threads);
+	double seconds = timeBest(options.minTime, []() {}, [&]() { stats.compute(pointers); sink = sink + stats.covariance(0, m - 1); }, allocations);
+	record("covariance_32", "double", "mixed", rows * m, threads, seconds, (double)rows * m, (double)rows * m * sizeof(double), allocations);
+
+	// if the pairwise baseline was timed already
+	if (threads > 1) {
+		return;
+	}
+
+	seconds = timeBest(options.minTime, []() {}, [&]() {
+		for (int i = 0; i < m; ++i) {
+			for (int j = i; j < m; ++j) {
+				double meanI = columns[i].mean();
+				double meanJ = columns[j].mean();
+				double sum = 0;
+				for (int r = 0; r < rows; ++r) {
+					sum += (values[i][r] - meanI) * (values[j][r] - meanJ);
+				}
+				sink = sink + sum / rows;
+			}
+		}
+	}, allocations);
+	record("covariance_32_pairwise", "double", "mixed", rows * m, 1, seconds, (double)rows * m, (double)rows * m * sizeof(double), allocations);
+
+}
+
+// HELPER FUNCTION: returns how far value is from being a median of values, as a
+// fraction of their number: 0 if its ranks (ties included) take in the middle one
+// USED BY: benchmarkSketch()
+static double medianRankError(const vector<double>& values, double value) {
+
+	long long below = 0;
+	long long equal = 0;
+
+	for (size_t i = 0; i < values.size(); ++i) {
+		below += values[i] < value;
+		equal += values[i] == value;
+	}
+
+	double middle = values.size() / 2.0;
+	double error = middle < below ? below - middle : (middle > below + equal ? middle - below - equal : 0);
+
+	return error / values.size();
+
+}
+
+// HELPER FUNCTION: compares the quantile sketch with the exact median, accuracy
+// against memory: for several k, the time to stream every value through a sketch,
+// the rank error of its median and the values and bytes it retains, next to the
+// time and memory of the exact median() of a Sequence of the same values
+// USED BY: main()
+static void benchmarkSketch(const BenchmarkOptions& options, const string& distribution, int n) {
+
+	vector<double> values = makeValues<double>(distribution, n);
+	long long allocations = 0;
+	const int ks[] = { 50, 100, 200, 400, 800 };
+
+	for (int k : ks) {
+
+		double estimate = 0;
+		int retained = 0;
+		size_t memory = 0;
+
+		double seconds = timeBest(options.minTime, []() {}, [&]() {
+			QuantileSketch sketch(k);
+			for (int i = 0; i < n; ++i) {
+				sketch.insert(values[i]);
+			}
+			estimate = sketch.quantile(0.5);
+			retained = sketch.retained();
+			memory = sketch.memory();
+		}, allocations);
+
+		record("median_sketch_k" + std::to_string(k), "double", distribution, n, 1, seconds, n, (double)n * sizeof(double), allocations,
+			{ { "rank_error", medianRankError(values, estimate) }, { "retained", (double)retained }, { "memory_bytes", (double)memory } });
+
+	}
+
+	double exact = 0;
+	size_t memory = 0;
+
+	double seconds = timeBest(options.minTime, []() {}, [&]() {
+		Sequence seq;
+		seq.insert(values.data(), n);
+		exact = seq.median();
+		memory = seq.memory();
+	}, allocations);
+
+	record("median_exact", "double", distribution, n, 1, seconds, n, (double)n * sizeof(double), allocations,
+		{ { "rank_error", medianRankError(values, exact) }, { "retained", (double)n }, { "memory_bytes", (double)memory } });
+
+}
+
+// HELPER FUNCTION: times loading n doubles from a raw binary file with mapFile()
+// and from a CSV file with insertText(), reporting bytes per second of file
+// USED BY: main()
+static void benchmarkLoaders(const BenchmarkOptions& options, int n, int threads) {
+
+	vector<double> values = makeValues<double>("uniform", n);
+	string binaryPath = "statistics_benchmark.bin";
+	string textPath = "statistics_benchmark.csv";
+	long long allocations = 0;
+
+	Sequence source;
+	source.insert(values.data(), n);
+
+	// if the temporary files cannot be written, skip the loaders
+	if (!source.saveFile(binaryPath.c_str())) {
+		return;
+	}
+
+	FILE* f = fopen(textPath.c_str(), "w");
+
+	if (f == nullptr) {
+		remove(binaryPath.c_str());
+		return;
+	}
+
+	for (int i = 0; i < n; ++i) {
+		fprintf(f, "%.17g%c", values[i], i % 8 == 7 ? '\n' : ',');
+	}
+
+	long textBytes = ftell(f);
+	fclose(f);
+
+	Sequence target;
+	double seconds = timeBest(options.minTime, [&]() { target = Sequence(); target.setThreads(threads); }, [&]() { target.mapFile(binaryPath.c_str()); }, allocations);
+	record("load_mapped", "double", "uniform", n, threads, seconds, 1, (double)n * sizeof(double), allocations);
+
+	seconds = timeBest(options.minTime, [&]() { target = Sequence(); target.setThreads(threads); }, [&]() { target.insertText(textPath.c_str()); }, allocations);
+	record("load_text", "double", "uniform", n, threads, seconds, 1, (double)textBytes, allocations);
+
+	remove(binaryPath.c_str());
+	remove(textPath.c_str());
+
+}
+
+// HELPER FUNCTION: reports a failed check on stderr; returns 1 if it failed
+// USED BY: checkResults()
+static int check(bool passed, const char* what) {
+
+	// if the check failed
+	if (!passed) {
+		fprintf(stderr, "check failed: %s\n", what);
+		return 1;
+	}
+
+	return 0;
+
+}
+
+// HELPER FUNCTION: checks, before anything is timed, results that cached state has
+// got wrong before, since a fast wrong answer is no result; returns the number of
+// failed checks
+// USED BY: main()
+static int checkResults() {
+
+	int failures = 0;
+	Sequence seq;
+
+	for (int i = 0; i < 100; ++i) {
+		seq.insert(i * 1.5);
+	}
+
+	// the sorted copy left by countRange() must move with the values
+	failures += check(seq.countRange(0, 1000) == 100, "countRange()");
+	Sequence moved(static_cast<Sequence&&>(seq));
+	failures += check(moved.countRange(0, 1000) == 100, "countRange() after move construction");
+	failures += check(moved.histogram(4)[0] == 25, "histogram() after move construction");
+	Sequence assigned;
+	assigned.insert(1);
+	assigned = static_cast<Sequence&&>(moved);
+	failures += check(assigned.countRange(0, 1000) == 100, "countRange() after move assignment");
+
+	// saving a mapped sequence over the file it is mapped from
+	const char* path = "statistics_benchmark_check.bin";
+	Sequence mapped;
+	failures += check(assigned.saveFile(path) && mapped.mapFile(path), "saveFile() and mapFile()");
+	failures += check(mapped.saveFile(path) && mapped.size() == 100 && mapped.median() == assigned.median(), "saveFile() onto the mapped file");
+	mapped = Sequence(); // unmaps the file before it is removed
+	remove(path);
+
+	return failures;
+
+}
+
+// HELPER FUNCTION: returns the key that identifies a result across runs
+// USED BY: printResults(), compareResults()
+static string resultKey(const string& name, const string& type, const string& distribution, int size, int threads) {
+
+	return name + "|" + type + "|" + distribution + "|" + std::to_string(size) + "|" + std::to_string(threads);
+
+}
+
+// HELPER FUNCTION: prints the results as JSON, one result object per line
+// USED BY: main()
+static void printResults() {
+
+	printf("{\"benchmark\": \"statistics\", \"results\": [\n");
+
+	for (size_t i = 0; i < results.size(); ++i) {
+
+		const BenchmarkResult& r = results[i];
+		double seconds = r.nsPerOp * r.opsPerRun / 1e9;
+		printf("{\"name\": \"%s\", \"type\": \"%s\", \"distribution\": \"%s\", \"size\": %d, \"threads\": %d, \"ns_per_op\": %.6g",
+			r.name.c_str(), r.type.c_str(), r.distribution.c_str(), r.size, r.threads, r.nsPerOp);
+
+		// if the operation reads the values, report throughput
+		if (r.bytes > 0) {
+			printf(", \"gb_per_s\": %.6g", r.bytes / seconds / 1e9);
+		}
+
+		printf(", \"allocations\": %lld", r.allocations);
+
+		for (size_t e = 0; e < r.extras.size(); ++e) {
+			printf(", \"%s\": %.6g", r.extras[e].first.c_str(), r.extras[e].second);
+		}
+
+		printf("}%s\n", i + 1 < results.size() ? "," : "");
+
+	}
+
+	printf("]}\n");
+
+}
+
+// HELPER FUNCTION: reads a field of a result line written by printResults()
+// USED BY: compareResults()
+static bool readField(const string& line, const string& field, string& value) {
+
+	string pattern = "\"" + field + "\": ";
+	size_t start = line.find(pattern);
+
+	if (start == string::npos) {
+		return false;
+	}
+
+	start += pattern.size();
+	size_t end = line[start] == '"' ? line.find('"', start + 1) + 1 : line.find_first_of(",}", start);
+	value = line.substr(start, end - start);
+
+	// strip the quotes of a string field
+	if (value.size() >= 2 && value[0] == '"') {
+		value = value.substr(1, value.size() - 2);
+	}
+
+	return true;
+
+}
+
+// HELPER FUNCTION: reads an earlier run and reports, on stderr, every result that is
+// now slower by more than the threshold; returns the number of regressions
+// USED BY: main()
+static int compareResults(const BenchmarkOptions& options) {
+
+	FILE* f = fopen(options.compareFile.c_str(), "r");
+
+	if (f == nullptr) {
+		fprintf(stderr, "cannot read %s\n", options.compareFile.c_str());
+		return 1;
+	}
+
+	map<string, double> previous; // ns_per_op of every earlier result
+	char buffer[1024];
+
+	while (fgets(buffer, sizeof(buffer), f) != nullptr) {
+
+		string line = buffer;
+		string name, type, distribution, size, threads, ns;
+
+		if (readField(line, "name", name) && readField(line, "type", type) && readField(line, "distribution", distribution) &&
+			readField(line, "size", size) && readField(line, "threads", threads) && readField(line, "ns_per_op", ns)) {
+			previous[resultKey(name, type, distribution, atoi(size.c_str()), atoi(threads.c_str()))] = atof(ns.c_str());
+		}
+
+	}
+
+	fclose(f);
+
+	int regressions = 0;
+
+	for (size_t i = 0; i < results.size(); ++i) {
+
+		const BenchmarkResult& r = results[i];
+		map<string, double>::const_iterator old = previous.find(resultKey(r.name, r.type, r.distribution, r.size, r.threads));
+
+		// if the earlier run had this result and it was faster by more than the threshold
+		if (old != previous.end() && old->second > 0 && r.nsPerOp > old->second * (1 + options.threshold / 100)) {
+			fprintf(stderr, "regression: %s %s %s size %d threads %d: %.6g ns -> %.6g ns (+%.1f%%)\n", r.name.c_str(), r.type.c_str(),
+				r.distribution.c_str(), r.size, r.threads, old->second, r.nsPerOp, (r.nsPerOp / old->second - 1) * 100);
+			regressions++;
+		}
+
+	}
+
+	return regressions;
+
+}
+
+int main(int argc, char* argv[]) {
+
+	BenchmarkOptions options;
+	options.sizes = { 1000, 65536, 1048576 };
+	options.maxThreads = (int)std::thread::hardware_concurrency();
+	options.maxThreads = options.maxThreads > 0 ? options.maxThreads : 1;
+	options.minTime = 0.05;
+	options.threshold = 10;
+
+	for (int i = 1; i < argc; ++i) {
+
+		string arg = argv[i];
+
+		if (arg.compare(0, 8, "--sizes=") == 0) {
+
+			options.sizes.clear();
+			const char* p = argv[i] + 8;
+
+			while (*p != '\0') {
+
+				char* end;
+				long size = strtol(p, &end, 10);
+
+				// if the list goes on with something other than a number
+				if (end == p) {
+					break;
+				}
+
+				options.sizes.push_back((int)size);
+				p = *end == ',' ? end + 1 : end;
+
+			}
+
+		}
+
+		else if (arg.compare(0, 10, "--threads=") == 0) {
+			options.maxThreads = atoi(argv[i] + 10) > 0 ? atoi(argv[i] + 10) : 1;
+		}
+
+		else if (arg.compare(0, 11, "--min-time=") == 0) {
+			options.minTime = atof(argv[i] + 11);
+		}
+
+		else if (arg.compare(0, 10, "--compare=") == 0) {
+			options.compareFile = argv[i] + 10;
+		}
+
+		else if (arg.compare(0, 12, "--threshold=") == 0) {
+			options.threshold = atof(argv[i] + 12);
+		}
+
+		else {
+			fprintf(stderr, "usage: %s [--sizes=N,N,...] [--threads=N] [--min-time=S] [--compare=old.json] [--threshold=PERCENT]\n", argv[0]);
+			return 2;
+		}
+
+	}
+
+	// if the statistics are wrong there is nothing worth timing
+	if (checkResults() > 0) {
+		return 1;
+	}
+
+	const char* distributions[] = { "uniform", "normal", "sorted", "few" };
+	vector<int> threadCounts; // thread counts for the scaling results, doubling up to the limit
+
+	for (int threads = 2; threads < options.maxThreads; threads *= 2) {
+		threadCounts.push_back(threads);
+	}
+
+	if (options.maxThreads > 1) {
+		threadCounts.push_back(options.maxThreads);
+	}
+
+	for (size_t s = 0; s < options.sizes.size(); ++s) {
+
+		int n = options.sizes[s];
+
+		// if the size is not usable
+		if (n <= 0) {
+			continue;
+		}
+
+		for (const char* distribution : distributions) {
+			benchmarkType<double>(options, distribution, n, 1, true);
+			benchmarkType<float>(options, distribution, n, 1, false);
+			benchmarkType<int>(options, distribution, n, 1, false);
+			benchmarkSketch(options, distribution, n);
+		}
+
+		// thread scaling, the single-thread figures come from the runs above
+		for (size_t t = 0; t < threadCounts.size(); ++t) {
+			benchmarkType<double>(options, "uniform", n, threadCounts[t], false);
+		}
+
+		benchmarkColumns(options, n, 1);
+
+		if (options.maxThreads > 1) {
+			benchmarkColumns(options, n, options.maxThreads);
+		}
+
+		benchmarkLoaders(options, n, 1);
+
+		if (options.maxThreads > 1) {
+			benchmarkLoaders(options, n, options.maxThreads);
+		}
+
+	}
+
+	printResults();
+
+	// if there is an earlier run to compare against
+	if (!options.compareFile.empty()) {
+		return compareResults(options) > 0 ? 1 : 0;
+	}
+
+	return 0;
+
+}
@@ -0,0 +1,971 @@
+/*
+tree_benchmark.cpp
+
+Benchmarks of the tree headers. Each section times one structure against the
+alternative it is meant to beat and prints one JSON object per result, in the
+same format as statistics_benchmark.cpp:
+
+	bplus		BPlusTree against RedBlackTree and std::map: insert, search
+			(present and absent keys), range search and remove
+	readers		ConcurrentRedBlackTree searches from 1 to --threads reader
+			threads, alone and beside a writer, against a RedBlackTree
+			behind a mutex
+	snapshot	RedBlackTreeSnapshot start-up (open and first searches, or
+			load into a tree) against rebuilding the tree by insert
+	batch		RedBlackTree::searchBatch() at several batch sizes against
+			one search() per key
+	interval	IntervalTree stab, overlap and overlapsAny queries against a
+			linear scan of the intervals
+	setops		RedBlackTree split() and join(), and unionWith(), intersectWith()
+			and subtract() against merging the sorted items and rebuilding,
+			above and below the size that lets them fork threads
+
+Build:
+	make tree_benchmark
+
+Usage:
+	tree_benchmark [--sizes=1000000,10000000,100000000] [--threads=64]
+		[--min-time=0.05] [--only=section] > results.json
+
+Authour: Fitz Laddaran
+Contact: fitzladdaran@gmail.com
+Last Updated: 27/08/2020
+*/
+
+#include "BPlusTree.h"
+#include "ConcurrentRedBlackTree.h"
+#include "IntervalTree.h"
+#include "RedBlackTree.h"
+#include "RedBlackTreeSnapshot.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+using std::map;
+using std::string;
+using std::vector;
+
+// settings from the command line
+struct BenchmarkOptions {
+	vector<int> sizes; // numbers of keys to benchmark
+	int maxThreads; // largest reader thread count
+	double minTime; // each result is timed for at least this many seconds
+	string only; // section to run, empty for all
+};
+
+// one timed result
+struct BenchmarkResult {
+	string name; // operation timed
+	string structure; // structure timed
+	int size; // number of keys in the structure
+	int threads; // threads taking part
+	double nsPerOp; // best time of one operation, in nanoseconds
+	vector<std::pair<string, double>> extras; // result-specific figures and their names
+};
+
+// results in the order they were measured
+static vector<BenchmarkResult> results;
+
+// keeps results alive so the compiler cannot drop the timed work
+static volatile long long sink = 0;
+
+// the same for work done on several threads at once
+static std::atomic<long long> threadSink(0);
+
+// searches timed per result, drawn from the keys, so large trees take bounded time
+static const int PROBES = 1 << 20;
+
+// RedBlackTree::PARALLEL_MIN_SIZE: set operations on fewer keys than this in both
+// trees run on the calling thread only
+static const int PARALLEL_MIN_SIZE = 1 << 16;
+
+// HELPER FUNCTION: returns seconds since an arbitrary start
+// USED BY: timeBest()
+static double now() {
+
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+}
+
+// HELPER FUNCTION: runs setup() and then op() until op() has run for minTime in total
+// (at least minRuns and at most 1000 times) and returns the shortest op() time in seconds
+// USED BY: every benchmark
+template <class Setup, class Op>
+static double timeBest(double minTime, int minRuns, Setup setup, Op op) {
+
+	double best = 1e300;
+	double total = 0;
+
+	for (int run = 0; run < 1000 && (run < minRuns || total < minTime); ++run) {
+
+		setup();
+		double start = now();
+		op();
+		double elapsed = now() - start;
+		total += elapsed;
+		best = elapsed < best ? elapsed : best;
+
+	}
+
+	return best;
+
+}
+
+// HELPER FUNCTION: returns how many times to time an operation over n keys at least;
+// trees of ten million keys and more take long enough to build for one run
+// USED BY: every benchmark
+static int minRuns(int n) {
+
+	return n >= 10000000 ? 1 : 3;
+
+}
+
+// HELPER FUNCTION: records a result
+// USED BY: every benchmark
+static void record(const string& name, const string& structure, int size, int threads, double seconds, double opsPerRun, const vector<std::pair<string, double>>& extras = {}) {
+
+	BenchmarkResult result;
+	result.name = name;
+	result.structure = structure;
+	result.size = size;
+	result.threads = threads;
+	result.nsPerOp = seconds * 1e9 / opsPerRun;
+	result.extras = extras;
+	results.push_back(result);
+
+}
+
+// HELPER FUNCTION: returns the odd numbers 1 to 2n - 1 in random order, so every
+// even number is a key that is absent
+// USED BY: every benchmark
+static vector<long long> makeKeys(int n) {
+
+	vector<long long> keys(n);
+
+	for (int i = 0; i < n; ++i) {
+		keys[i] = 2LL * i + 1;
+	}
+
+	std::shuffle(keys.begin(), keys.end(), std::mt19937_64(12345));
+	return keys;
+
+}
+
+// HELPER FUNCTION: returns count keys drawn from keys, plus one if absent is set so
+// none of them is present
+// USED BY: every benchmark
+static vector<long long> makeProbes(const vector<long long>& keys, int count, bool absent) {
+
+	std::mt19937_64 rng(54321);
+	vector<long long> probes(count);
+
+	for (int i = 0; i < count; ++i) {
+		probes[i] = keys[rng() % keys.size()] + (absent ? 1 : 0);
+	}
+
+	return probes;
+
+}
+
+// the operations of each ordered map, under one name so the timing code is shared
+static void insertKey(BPlusTree<long long, long long>& tree, long long key) { tree.insert(key, key); }
+static void insertKey(RedBlackTree<long long, long long>& tree, long long key) { tree.insert(key, key); }
+static void insertKey(map<long long, long long>& tree, long long key) { tree.emplace(key, key); }
+
+static bool containsKey(const BPlusTree<long long, long long>& tree, long long key) { return tree.search(key); }
+static bool containsKey(const RedBlackTree<long long, long long>& tree, long long key) { return tree.search(key); }
+static bool containsKey(const map<long long, long long>& tree, long long key) { return tree.find(key) != tree.end(); }
+
+static vector<long long> rangeValues(const BPlusTree<long long, long long>& tree, long long low, long long high) { return tree.search(low, high); }
+static vector<long long> rangeValues(const RedBlackTree<long long, long long>& tree, long long low, long long high) { return tree.search(low, high); }
+
+static vector<long long> rangeValues(const map<long long, long long>& tree, long long low, long long high) {
+
+	vector<long long> myVect;
+
+	for (map<long long, long long>::const_iterator it = tree.lower_bound(low); it != tree.end() && it->first <= high; ++it) {
+		myVect.push_back(it->second);
+	}
+
+	return myVect;
+
+}
+
+static void removeKey(BPlusTree<long long, long long>& tree, long long key) { tree.remove(key); }
+static void removeKey(RedBlackTree<long long, long long>& tree, long long key) { tree.remove(key); }
+static void removeKey(map<long long, long long>& tree, long long key) { tree.erase(key); }
+
+// HELPER FUNCTION: times one ordered map over n shuffled keys: inserting them all,
+// searching for present and absent keys, range searches of about 1000 keys, and
+// removing them all in another random order
+// USED BY: benchmarkOrderedMaps()
+template <class Map>
+static void benchmarkMap(const BenchmarkOptions& options, const char* structure, const vector<long long>& keys) {
+
+	int n = (int)keys.size();
+	int probes = n < PROBES ? n : PROBES;
+	vector<long long> present = makeProbes(keys, probes, false);
+	vector<long long> absent = makeProbes(keys, probes, true);
+	Map* tree = nullptr;
+
+	double seconds = timeBest(options.minTime, minRuns(n), [&]() { delete tree; tree = new Map(); }, [&]() {
+		for (int i = 0; i < n; ++i) {
+			insertKey(*tree, keys[i]);
+		}
+	});
+	record("insert", structure, n, 1, seconds, n);
+
+	seconds = timeBest(options.minTime, 3, []() {}, [&]() {
+		long long found = 0;
+		for (int i = 0; i < probes; ++i) {
+			found += containsKey(*tree, present[i]);
+		}
+		sink = sink + found;
+	});
+	record("search_present", structure, n, 1, seconds, probes);
+
+	seconds = timeBest(options.minTime, 3, []() {}, [&]() {
+		long long found = 0;
+		for (int i = 0; i < probes; ++i) {
+			found += containsKey(*tree, absent[i]);
+		}
+		sink = sink + found;
+	});
+	record("search_absent", structure, n, 1, seconds, probes);
+
+	// ranges of about 1000 keys (2000 numbers, half of them keys)
+	int ranges = 1000;
+	seconds = timeBest(options.minTime, 3, []() {}, [&]() {
+		long long values = 0;
+		for (int i = 0; i < ranges; ++i) {
+			values += (long long)rangeValues(*tree, present[i], present[i] + 2000).size();
+		}
+		sink = sink + values;
+	});
+	record("range_1000", structure, n, 1, seconds, ranges);
+
+	vector<long long> order = keys;
+	std::shuffle(order.begin(), order.end(), std::mt19937_64(999));
+	bool full = true; // the tree still holds every key
+
+	seconds = timeBest(options.minTime, minRuns(n), [&]() {
+		if (!full) {
+			delete tree;
+			tree = new Map();
+			for (int i = 0; i < n; ++i) {
+				insertKey(*tree, keys[i]);
+			}
+		}
+		full = false;
+	}, [&]() {
+		for (int i = 0; i < n; ++i) {
+			removeKey(*tree, order[i]);
+		}
+	});
+	record("remove", structure, n, 1, seconds, n);
+
+	delete tree;
+
+}
+
+// HELPER FUNCTION: compares BPlusTree with RedBlackTree and std::map at n keys
+// USED BY: main()
+static void benchmarkOrderedMaps(const BenchmarkOptions& options, int n) {
+
+	vector<long long> keys = makeKeys(n);
+	benchmarkMap<BPlusTree<long long, long long>>(options, "BPlusTree", keys);
+	benchmarkMap<RedBlackTree<long long, long long>>(options, "RedBlackTree", keys);
+	benchmarkMap<map<long long, long long>>(options, "std::map", keys);
+
+}
+
+// HELPER FUNCTION: starts threads copies of work(thread), releases them together
+// and returns the seconds until the last one finished
+// USED BY: timeThreads()
+template <class Work>
+static double runThreads(int threads, Work work) {
+
+	std::atomic<int> ready(0);
+	std::atomic<bool> go(false);
+	vector<std::thread> workers;
+
+	for (int t = 0; t < threads; ++t) {
+		workers.emplace_back([&, t]() {
+			ready.fetch_add(1);
+			while (!go.load()) {
+				std::this_thread::yield();
+			}
+			work(t);
+		});
+	}
+
+	while (ready.load() < threads) {
+		std::this_thread::yield();
+	}
+
+	double start = now();
+	go.store(true);
+
+	for (int t = 0; t < threads; ++t) {
+		workers[t].join();
+	}
+
+	return now() - start;
+
+}
+
+// HELPER FUNCTION: returns the shortest of three runThreads() times, leaving
+// thread start-up out of the timing
+// USED BY: benchmarkReaders()
+template <class Work>
+static double timeThreads(int threads, Work work) {
+
+	double best = 1e300;
+
+	for (int run = 0; run < 3; ++run) {
+		double elapsed = runThreads(threads, work);
+		best = elapsed < best ? elapsed : best;
+	}
+
+	return best;
+
+}
+
+// HELPER FUNCTION: times searches of n keys from 1 to options.maxThreads reader
+// threads (doubling, and ending on the limit), each doing the same number of
+// searches: ConcurrentRedBlackTree::search() pinning a snapshot per search,
+// Snapshot::search() under one snapshot per thread, the same with a writer
+// inserting and removing absent keys throughout, and a RedBlackTree behind a
+// std::mutex. ns_per_op is wall time per search over all readers, so flat
+// results mean perfect scaling
+// USED BY: main()
+static void benchmarkReaders(const BenchmarkOptions& options, int n) {
+
+	vector<long long> keys = makeKeys(n);
+	int perThread = (n < PROBES ? n : PROBES) / 4;
+	vector<long long> probes = makeProbes(keys, perThread, false);
+	ConcurrentRedBlackTree<long long, long long> shared;
+	RedBlackTree<long long, long long> locked;
+	std::mutex lock;
+
+	for (int i = 0; i < n; ++i) {
+		shared.insert(keys[i], keys[i]);
+		locked.insert(keys[i], keys[i]);
+	}
+
+	// thread counts double up to the limit and end on it
+	for (int threads = 1; ; threads = threads * 2 < options.maxThreads ? threads * 2 : options.maxThreads) {
+
+		double searches = (double)perThread * threads;
+
+		double seconds = timeThreads(threads, [&](int t) {
+			long long found = 0;
+			for (int i = 0; i < perThread; ++i) {
+				found += shared.search(probes[(i + t * 7919) % perThread]);
+			}
+			threadSink.fetch_add(found);
+		});
+		record("search", "ConcurrentRedBlackTree", n, threads, seconds, searches);
+
+		seconds = timeThreads(threads, [&](int t) {
+			ConcurrentRedBlackTree<long long, long long>::Snapshot snap = shared.snapshot();
+			long long found = 0;
+			for (int i = 0; i < perThread; ++i) {
+				found += snap.search(probes[(i + t * 7919) % perThread]);
+			}
+			threadSink.fetch_add(found);
+		});
+		record("snapshot_search", "ConcurrentRedBlackTree", n, threads, seconds, searches);
+
+		// the writer runs as one more thread until every reader is done
+		double writesPerSecond = 0;
+		seconds = 1e300;
+
+		for (int run = 0; run < 3; ++run) {
+
+			std::atomic<int> readersLeft(threads);
+			long long writes = 0;
+
+			double elapsed = runThreads(threads + 1, [&](int t) {
+				if (t == threads) {
+					for (long long key = 0; readersLeft.load() > 0; key = (key + 2) % (2LL * n)) {
+						shared.insert(key, key);
+						shared.remove(key);
+						writes += 2;
+					}
+					return;
+				}
+				long long found = 0;
+				for (int i = 0; i < perThread; ++i) {
+					found += shared.search(probes[(i + t * 7919) % perThread]);
+				}
+				threadSink.fetch_add(found);
+				readersLeft.fetch_sub(1);
+			});
+
+			if (elapsed < seconds) {
+				seconds = elapsed;
+				writesPerSecond = writes / elapsed;
+			}
+
+		}
+
+		record("search_with_writer", "ConcurrentRedBlackTree", n, threads, seconds, searches, { { "writes_per_s", writesPerSecond } });
+
+		seconds = timeThreads(threads, [&](int t) {
+			long long found = 0;
+			for (int i = 0; i < perThread; ++i) {
+				std::lock_guard<std::mutex> guard(lock);
+				found += locked.search(probes[(i + t * 7919) % perThread]);
+			}
+			threadSink.fetch_add(found);
+		});
+		record("search", "RedBlackTree+mutex", n, threads, seconds, searches);
+
+		if (threads == options.maxThreads) {
+			break;
+		}
+
+	}
+
+}
+
+// HELPER FUNCTION: times how long a service takes to answer lookups over n keys
+// after start-up: saving a snapshot, mapping it and answering the first 1000
+// searches, mapping it and loading it into a tree, against inserting every key
+// into a new tree; then searches on the mapped snapshot against the tree. The file
+// is in the page cache when it is opened, as it is after a quick restart
+// USED BY: main()
+static void benchmarkSnapshot(const BenchmarkOptions& options, int n) {
+
+	const char* path = "tree_benchmark.snap";
+	vector<long long> keys = makeKeys(n);
+	int probes = n < PROBES ? n : PROBES;
+	vector<long long> present = makeProbes(keys, probes, false);
+	RedBlackTree<long long, long long> rbTree;
+
+	for (int i = 0; i < n; ++i) {
+		rbTree.insert(keys[i], keys[i]);
+	}
+
+	bool saved = true;
+	double seconds = timeBest(options.minTime, minRuns(n), []() {}, [&]() {
+		saved = saveSnapshot(rbTree, path) && saved;
+	});
+
+	// if the file could not be written there is nothing to start from
+	if (!saved) {
+		fprintf(stderr, "could not save %s\n", path);
+		return;
+	}
+
+	FILE* f = fopen(path, "rb");
+	fseek(f, 0, SEEK_END);
+	double fileBytes = (double)ftell(f);
+	fclose(f);
+	record("save", "RedBlackTreeSnapshot", n, 1, seconds, 1, { { "file_bytes", fileBytes } });
+
+	RedBlackTreeSnapshot<long long, long long> snap;
+	int first = probes < 1000 ? probes : 1000;
+	seconds = timeBest(options.minTime, 3, [&]() { snap.close(); }, [&]() {
+		snap.open(path);
+		long long found = 0;
+		for (int i = 0; i < first; ++i) {
+			found += snap.search(present[i]);
+		}
+		sink = sink + found;
+	});
+	record("open_first_1000_searches", "RedBlackTreeSnapshot", n, 1, seconds, 1);
+
+	RedBlackTree<long long, long long>* loaded = nullptr;
+	seconds = timeBest(options.minTime, minRuns(n), [&]() { delete loaded; loaded = new RedBlackTree<long long, long long>(); }, [&]() {
+		loadSnapshot(*loaded, path);
+	});
+	record("load", "RedBlackTreeSnapshot", n, 1, seconds, 1);
+	delete loaded;
+	loaded = nullptr;
+
+	seconds = timeBest(options.minTime, minRuns(n), [&]() { delete loaded; loaded = new RedBlackTree<long long, long long>(); }, [&]() {
+		for (int i = 0; i < n; ++i) {
+			loaded->insert(keys[i], keys[i]);
+		}
+	});
+	record("rebuild_by_insert", "RedBlackTree", n, 1, seconds, 1);
+	delete loaded;
+
+	seconds = timeBest(options.minTime, 3, []() {}, [&]() {
+		long long found = 0;
+		for (int i = 0; i < probes; ++i) {
+			found += snap.search(present[i]);
+		}
+		sink = sink + found;
+	});
+	record("search_present", "RedBlackTreeSnapshot", n, 1, seconds, probes);
+
+	seconds = timeBest(options.minTime, 3, []() {}, [&]() {
+		long long found = 0;
+		for (int i = 0; i < probes; ++i) {
+			found += rbTree.search(present[i]);
+		}
+		sink = sink + found;
+	});
+	record("search_present", "RedBlackTree", n, 1, seconds, probes);
+
+	snap.close();
+	remove(path);
+
+}
+
+// HELPER FUNCTION: times random searches of n keys, half of them absent, one
+// search() per key against searchBatch() over batches of 16 to all the probes.
+// searchBatch() also returns the values, so the per-key figure is the lower bound
+// USED BY: main()
+static void benchmarkBatch(const BenchmarkOptions& options, int n) {
+
+	vector<long long> keys = makeKeys(n);
+	int probes = n < PROBES ? n : PROBES;
+	vector<long long> mixed = makeProbes(keys, probes, false);
+	RedBlackTree<long long, long long> rbTree;
+
+	for (int i = 0; i < n; ++i) {
+		rbTree.insert(keys[i], keys[i]);
+	}
+
+	for (int i = 1; i < probes; i += 2) {
+		++mixed[i];
+	}
+
+	double seconds = timeBest(options.minTime, 3, []() {}, [&]() {
+		long long found = 0;
+		for (int i = 0; i < probes; ++i) {
+			found += rbTree.search(mixed[i]);
+		}
+		sink = sink + found;
+	});
+	record("search", "RedBlackTree", n, 1, seconds, probes);
+
+	vector<long long> outValues(probes);
+	std::unique_ptr<bool[]> found(new bool[probes]);
+	const int batchSizes[] = { 16, 64, 256, 4096, probes };
+
+	for (int b = 0; b < 5; ++b) {
+
+		int batch = batchSizes[b] < probes ? batchSizes[b] : probes;
+
+		// if the size is a repeat of the last one, when probes is small
+		if (b > 0 && batch == (batchSizes[b - 1] < probes ? batchSizes[b - 1] : probes)) {
+			continue;
+		}
+
+		seconds = timeBest(options.minTime, 3, []() {}, [&]() {
+			long long total = 0;
+			for (int i = 0; i < probes; i += batch) {
+				int count = probes - i < batch ? probes - i : batch;
+				total += rbTree.searchBatch(mixed.data() + i, count, outValues.data() + i, found.get() + i);
+			}
+			sink = sink + total;
+		});
+		record("search_batch", "RedBlackTree", n, 1, seconds, probes, { { "batch", (double)batch } });
+
+	}
+
+}
+
+// an interval for the linear scan
+struct BenchmarkInterval {
+	long long low; // start of the interval
+	long long high; // end of the interval
+	long long value; // associated value
+};
+
+// HELPER FUNCTION: times queries over n random intervals of length 0 to 99 spread
+// over [0, 10n), so each query matches a handful of them: stab(), overlap() of
+// windows of 100 and overlapsAny(), each against a scan of every interval
+// USED BY: main()
+static void benchmarkIntervals(const BenchmarkOptions& options, int n) {
+
+	std::mt19937_64 rng(777);
+	long long span = 10LL * n;
+	vector<BenchmarkInterval> scan(n);
+	IntervalTree<long long, long long>* iTree = nullptr;
+
+	for (int i = 0; i < n; ++i) {
+		scan[i].low = (long long)(rng() % span);
+		scan[i].high = scan[i].low + (long long)(rng() % 100);
+		scan[i].value = i;
+	}
+
+	double seconds = timeBest(options.minTime, minRuns(n), [&]() { delete iTree; iTree = new IntervalTree<long long, long long>(); }, [&]() {
+		for (int i = 0; i < n; ++i) {
+			iTree->insert(scan[i].low, scan[i].high, scan[i].value);
+		}
+	});
+	record("insert", "IntervalTree", n, 1, seconds, n);
+
+	// a scan reads every interval, so it gets fewer queries
+	int treeQueries = 100000;
+	int scanQueries = n >= 10000000 ? 10 : 100;
+	vector<long long> points(treeQueries);
+
+	for (int i = 0; i < treeQueries; ++i) {
+		points[i] = (long long)(rng() % span);
+	}
+
+	seconds = timeBest(options.minTime, 3, []() {}, [&]() {
+		long long matches = 0;
+		for (int i = 0; i < treeQueries; ++i) {
+			matches += (long long)iTree->stab(points[i]).size();
+		}
+		sink = sink + matches;
+	});
+	record("stab", "IntervalTree", n, 1, seconds, treeQueries);
+
+	seconds = timeBest(options.minTime, 3, []() {}, [&]() {
+		long long matches = 0;
+		for (int i = 0; i < scanQueries; ++i) {
+			vector<long long> myVect;
+			for (int j = 0; j < n; ++j) {
+				if (scan[j].low <= points[i] && points[i] <= scan[j].high) {
+					myVect.push_back(scan[j].value);
+				}
+			}
+			matches += (long long)myVect.size();
+		}
+		sink = sink + matches;
+	});
+	record("stab", "linear_scan", n, 1, seconds, scanQueries);
+
+	seconds = timeBest(options.minTime, 3, []() {}, [&]() {
+		long long matches = 0;
+		for (int i = 0; i < treeQueries; ++i) {
+			matches += (long long)iTree->overlap(points[i], points[i] + 100).size();
+		}
+		sink = sink + matches;
+	});
+	record("overlap_100", "IntervalTree", n, 1, seconds, treeQueries);
+
+	seconds = timeBest(options.minTime, 3, []() {}, [&]() {
+		long long matches = 0;
+		for (int i = 0; i < scanQueries; ++i) {
+			vector<long long> myVect;
+			for (int j = 0; j < n; ++j) {
+				if (scan[j].low <= points[i] + 100 && points[i] <= scan[j].high) {
+					myVect.push_back(scan[j].value);
+				}
+			}
+			matches += (long long)myVect.size();
+		}
+		sink = sink + matches;
+	});
+	record("overlap_100", "linear_scan", n, 1, seconds, scanQueries);
+
+	seconds = timeBest(options.minTime, 3, []() {}, [&]() {
+		long long matches = 0;
+		for (int i = 0; i < treeQueries; ++i) {
+			matches += iTree->overlapsAny(points[i], points[i]);
+		}
+		sink = sink + matches;
+	});
+	record("overlaps_any", "IntervalTree", n, 1, seconds, treeQueries);
+
+	// stops at the first match, as overlapsAny() does
+	seconds = timeBest(options.minTime, 3, []() {}, [&]() {
+		long long matches = 0;
+		for (int i = 0; i < scanQueries; ++i) {
+			for (int j = 0; j < n; ++j) {
+				if (scan[j].low <= points[i] && points[i] <= scan[j].high) {
+					++matches;
+					break;
+				}
+			}
+		}
+		sink = sink + matches;
+	});
+	record("overlaps_any", "linear_scan", n, 1, seconds, scanQueries);
+
+	delete iTree;
+
+}
+
+// HELPER FUNCTION: returns the levels of set-operation recursion that fork a thread
+// for total keys, as RedBlackTree::parallelLevels() (private) works them out
+// USED BY: benchmarkSetOps()
+static int parallelLevels(int total) {
+
+	if (total < PARALLEL_MIN_SIZE) {
+		return 0;
+	}
+
+	int threads = (int)std::thread::hardware_concurrency();
+	int levels = 0;
+
+	while ((2 << levels) <= threads && levels < 6) {
+		levels++;
+	}
+
+	return levels;
+
+}
+
+// HELPER FUNCTION: merges the sorted items of a and b with op (std::set_union,
+// std::set_intersection or std::set_difference) and builds out from the result,
+// the serial way to combine two trees without the set operations
+// USED BY: benchmarkSetOps()
+template <class Merge>
+static void mergeSorted(const RedBlackTree<long long, long long>& a, const RedBlackTree<long long, long long>& b, RedBlackTree<long long, long long>& out, Merge op) {
+
+	vector<std::pair<long long, long long>> aItems = a.items();
+	vector<std::pair<long long, long long>> bItems = b.items();
+	vector<std::pair<long long, long long>> merged;
+	merged.reserve(aItems.size() + bItems.size());
+	op(aItems.begin(), aItems.end(), bItems.begin(), bItems.end(), std::back_inserter(merged),
+		[](const std::pair<long long, long long>& x, const std::pair<long long, long long>& y) { return x.first < y.first; });
+
+	vector<long long> keys(merged.size());
+	vector<long long> values(merged.size());
+
+	for (size_t i = 0; i < merged.size(); ++i) {
+		keys[i] = merged[i].first;
+		values[i] = merged[i].second;
+	}
+
+	out.buildFromSorted(keys.data(), values.data(), (int)keys.size());
+
+}
+
+// HELPER FUNCTION: times split() at a random absent key followed by join() with it
+// as the separator, averaged over 1000 of each, then unionWith(), intersectWith()
+// and subtract() of two trees of n keys sharing half of them, each by copy and by
+// move, against mergeSorted(). Set operation results carry the hardware thread
+// count and how many levels of the recursion fork a thread
+// USED BY: main()
+static void benchmarkSetOps(const BenchmarkOptions& options, int n) {
+
+	vector<long long> keys = makeKeys(n);
+	RedBlackTree<long long, long long> first;
+	RedBlackTree<long long, long long> second;
+
+	for (int i = 0; i < n; ++i) {
+		first.insert(keys[i], keys[i]);
+		second.insert(keys[i] + 2 * (n / 2), keys[i]);
+	}
+
+	// the tree gains each separator, so every split is at a new even number
+	RedBlackTree<long long, long long> whole(first);
+	RedBlackTree<long long, long long> less;
+	RedBlackTree<long long, long long> greater;
+	std::mt19937_64 rng(4242);
+	int cycles = 0;
+	double splitSeconds = 0;
+	double joinSeconds = 0;
+
+	for (int i = 0; i < 1000; ++i) {
+
+		long long key = 2 * (long long)(rng() % n);
+
+		// if an earlier cycle already used this separator
+		if (whole.search(key)) {
+			continue;
+		}
+
+		double start = now();
+		whole.split(key, less, greater);
+		double middle = now();
+		whole.join(less, key, key, greater);
+		double end = now();
+		splitSeconds += middle - start;
+		joinSeconds += end - middle;
+		++cycles;
+
+	}
+
+	record("split", "RedBlackTree", n, 1, splitSeconds, cycles);
+	record("join", "RedBlackTree", n, 1, joinSeconds, cycles);
+
+	// each forking level doubles the threads working on the operation
+	int threads = 1 << parallelLevels(2 * n);
+	vector<std::pair<string, double>> extras = { { "hardware_threads", (double)std::thread::hardware_concurrency() },
+		{ "parallel_levels", (double)parallelLevels(2 * n) } };
+	RedBlackTree<long long, long long>* a = nullptr;
+	RedBlackTree<long long, long long>* b = nullptr;
+	auto copyBoth = [&]() {
+		delete a;
+		delete b;
+		a = new RedBlackTree<long long, long long>(first);
+		b = new RedBlackTree<long long, long long>(second);
+	};
+
+	double seconds = timeBest(options.minTime, minRuns(n), copyBoth, [&]() { a->unionWith(*b); });
+	record("union_copy", "RedBlackTree", n, threads, seconds, 1, extras);
+	seconds = timeBest(options.minTime, minRuns(n), copyBoth, [&]() { a->unionWith(std::move(*b)); });
+	record("union_move", "RedBlackTree", n, threads, seconds, 1, extras);
+	seconds = timeBest(options.minTime, minRuns(n), copyBoth, [&]() {
+		RedBlackTree<long long, long long> out;
+		mergeSorted(*a, *b, out, [](auto... args) { return std::set_union(args...); });
+	});
+	record("union", "sorted_merge", n, 1, seconds, 1);
+
+	seconds = timeBest(options.minTime, minRuns(n), copyBoth, [&]() { a->intersectWith(*b); });
+	record("intersect_copy", "RedBlackTree", n, threads, seconds, 1, extras);
+	seconds = timeBest(options.minTime, minRuns(n), copyBoth, [&]() { a->intersectWith(std::move(*b)); });
+	record("intersect_move", "RedBlackTree", n, threads, seconds, 1, extras);
+	seconds = timeBest(options.minTime, minRuns(n), copyBoth, [&]() {
+		RedBlackTree<long long, long long> out;
+		mergeSorted(*a, *b, out, [](auto... args) { return std::set_intersection(args...); });
+	});
+	record("intersect", "sorted_merge", n, 1, seconds, 1);
+
+	seconds = timeBest(options.minTime, minRuns(n), copyBoth, [&]() { a->subtract(*b); });
+	record("subtract_copy", "RedBlackTree", n, threads, seconds, 1, extras);
+	seconds = timeBest(options.minTime, minRuns(n), copyBoth, [&]() { a->subtract(std::move(*b)); });
+	record("subtract_move", "RedBlackTree", n, threads, seconds, 1, extras);
+	seconds = timeBest(options.minTime, minRuns(n), copyBoth, [&]() {
+		RedBlackTree<long long, long long> out;
+		mergeSorted(*a, *b, out, [](auto... args) { return std::set_difference(args...); });
+	});
+	record("subtract", "sorted_merge", n, 1, seconds, 1);
+
+	delete a;
+	delete b;
+
+}
+
+// HELPER FUNCTION: prints the results as JSON, one result object per line
+// USED BY: main()
+static void printResults() {
+
+	printf("{\"benchmark\": \"tree\", \"results\": [\n");
+
+	for (size_t i = 0; i < results.size(); ++i) {
+
+		const BenchmarkResult& r = results[i];
+		printf("{\"name\": \"%s\", \"structure\": \"%s\", \"size\": %d, \"threads\": %d, \"ns_per_op\": %.6g",
+			r.name.c_str(), r.structure.c_str(), r.size, r.threads, r.nsPerOp);
+
+		for (size_t e = 0; e < r.extras.size(); ++e) {
+			printf(", \"%s\": %.6g", r.extras[e].first.c_str(), r.extras[e].second);
+		}
+
+		printf("}%s\n", i + 1 < results.size() ? "," : "");
+
+	}
+
+	printf("]}\n");
+
+}
+
+// HELPER FUNCTION: checks if section is to run
+// USED BY: main()
+static bool wanted(const BenchmarkOptions& options, const char* section) {
+
+	return options.only.empty() || options.only == section;
+
+}
+
+int main(int argc, char* argv[]) {
+
+	BenchmarkOptions options;
+	options.sizes = { 1000000 };
+	options.maxThreads = 64;
+	options.minTime = 0.05;
+
+	for (int i = 1; i < argc; ++i) {
+
+		string arg = argv[i];
+
+		if (arg.compare(0, 8, "--sizes=") == 0) {
+
+			options.sizes.clear();
+			const char* p = argv[i] + 8;
+
+			while (*p != '\0') {
+
+				char* end;
+				long size = strtol(p, &end, 10);
+
+				// if the list goes on with something other than a number
+				if (end == p) {
+					break;
+				}
+
+				options.sizes.push_back((int)size);
+				p = *end == ',' ? end + 1 : end;
+
+			}
+
+		}
+
+		else if (arg.compare(0, 10, "--threads=") == 0) {
+			options.maxThreads = atoi(argv[i] + 10) > 0 ? atoi(argv[i] + 10) : 1;
+		}
+
+		else if (arg.compare(0, 11, "--min-time=") == 0) {
+			options.minTime = atof(argv[i] + 11);
+		}
+
+		else if (arg.compare(0, 7, "--only=") == 0) {
+			options.only = argv[i] + 7;
+		}
+
+		else {
+			fprintf(stderr, "usage: %s [--sizes=N,N,...] [--threads=N] [--min-time=S] [--only=section]\n", argv[0]);
+			return 2;
+		}
+
+	}
+
+	for (size_t s = 0; s < options.sizes.size(); ++s) {
+
+		int n = options.sizes[s];
+
+		// if the size is not usable
+		if (n <= 0) {
+			continue;
+		}
+
+		if (wanted(options, "bplus")) {
+			benchmarkOrderedMaps(options, n);
+		}
+
+		if (wanted(options, "readers")) {
+			benchmarkReaders(options, n);
+		}
+
+		if (wanted(options, "snapshot")) {
+			benchmarkSnapshot(options, n);
+		}
+
+		if (wanted(options, "batch")) {
+			benchmarkBatch(options, n);
+		}
+
+		if (wanted(options, "interval")) {
+			benchmarkIntervals(options, n);
+		}
+
+		if (wanted(options, "setops")) {
+			benchmarkSetOps(options, n);
+		}
+
+	}
+
+	// two trees of this size stay under the parallel threshold, so the set
+	// operations show their single-thread cost too
+	if (wanted(options, "setops")) {
+		benchmarkSetOps(options, PARALLEL_MIN_SIZE / 4);
+	}
+
+	printResults();
+	return 0;
+
+}